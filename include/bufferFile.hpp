@@ -44,12 +44,20 @@ namespace utils{
         
         //!_buffer length in chars
         std::streamsize _size;
+
+        //! Should the file be memory mapped instead of copied into _buffer?
+        bool _useMmap;
+        //! Length of memory mapping if _buffer is memory mapped, otherwise 0.
+        size_t _mappedSize;
+
+        bool _mapBuffer();
+        void _freeBuffer();
     public:
         explicit BufferFile(std::string fname = "");
         BufferFile(const BufferFile& rhs);
         
         ~BufferFile(){
-            delete [] _buffer;
+            _freeBuffer();
         }
         
         //modifiers
@@ -60,8 +68,22 @@ namespace utils{
         virtual bool read(std::string);
         bool exists() const;
 
+        /**
+         \brief Set whether the file should be memory mapped by the next call to read. <br>
+
+         Memory mapped files are paged in by the OS on demand and can be released under memory pressure.
+         */
+        void setUseMmap(bool useMmap){
+            _useMmap = useMmap;
+        }
+        void adviseWillNeed(size_t offset, size_t len) const;
+
         //properties
         bool buffer_empty() const;
+        //! Is the buffer a memory mapped view of the file?
+        bool isMapped() const{
+            return _mappedSize != 0;
+        }
     };
 }
 
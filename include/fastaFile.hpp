@@ -31,11 +31,16 @@
 #include <fstream>
 #include <algorithm>
 #include <map>
+#include <vector>
+#include <cstdint>
+#include <functional>
 #include <sstream>
 #include <string>
 
 #include <utils.hpp>
 #include <bufferFile.hpp>
+#include <stringView.hpp>
+#include <stringHashIndex.hpp>
 
 namespace utils {
     class FastaFile;
@@ -43,6 +48,7 @@ namespace utils {
 
     const std::string PROT_SEQ_NOT_FOUND = "PROT_SEQ_NOT_FOUND";
     const std::string PEP_SEQ_NOT_FOUND = "PEP_SEQ_NOT_FOUND";
+    const std::string MOD_LOC_OUT_OF_BOUNDS = "MOD_LOC_OUT_OF_BOUNDS";
 
     const size_t PROT_ID_NOT_FOUND = std::string::npos;
 
@@ -71,43 +77,156 @@ namespace utils {
         }
     };
 
+    /**
+     \brief Modified residues located by FastaFile::getModifiedResidues <br>
+
+     Each column has one value for each input row, in the same order as the input.
+     */
+    struct ModifiedResidueTable {
+        enum class Status : uint8_t {
+            FOUND,
+            PROTEIN_NOT_FOUND,
+            PEPTIDE_NOT_FOUND,
+            //! modLoc is not a position in the peptide.
+            OUT_OF_BOUNDS
+        };
+
+        //! Modified residue or '\0' if status is not FOUND.
+        std::vector<char> residue;
+        //! 1 based position of modified residue in protein or 0 if status is not FOUND.
+        std::vector<size_t> position;
+        std::vector<Status> status;
+
+        void clear();
+        //! Number of rows.
+        size_t size() const {
+            return status.size();
+        }
+        std::string str(size_t row) const;
+    };
+
+    /**
+     \brief Indexed protein sequences from a fasta file. <br>
+
+     Every sequence is parsed and indexed by FastaFile::read. After that, the index is never modified,
+     so const member functions can be called concurrently from any number of threads without locking.
+     Returned StringView(s) stay valid until the object is destroyed or read is called again.
+
+     For very large databases, residues can be stored in a more compact form with FastaFile::setStorage.
+     In the DENSE and PACKED_5BIT modes the file buffer is released after indexing,
+     and in PACKED_5BIT mode sequences are decoded on access with FastaFile::getSequence(size_t, std::string&).
+     In PACKED_5BIT mode, FastaFile::operator[], FastaFile::at and FastaFile::getSequence(StringView, bool)
+     throw std::logic_error, because there is no stored text for the returned StringView to point to.
+     */
     class FastaFile : public utils::BufferFile{
-    private:
+    public:
+        //! Bit flags for the header tokens which are added to the ID index.
+        enum IdKey : unsigned {
+            //! The ID returned by FastaFile::getIndexID. (For example P12345 in >sp|P12345|NAME_HUMAN)
+            ACCESSION = 1,
+            //! UniProt entry name. (NAME_HUMAN in >sp|P12345|NAME_HUMAN)
+            ENTRY_NAME = 2,
+            //! First whitespace delimited token of header. (sp|P12345|NAME_HUMAN)
+            HEADER_TOKEN = 4
+        };
+        //! How residues are stored after FastaFile::read
+        enum class Storage {
+            //! One byte per residue. The file buffer is kept, so headers are available.
+            ARENA,
+            //! One byte per residue. The file buffer is released after indexing, so FastaFile::getHeader returns empty views.
+            DENSE,
+            /**
+             5 bit residue codes packed 12 to a 64 bit word. The file buffer is released after indexing.
+             Lowercase residues are stored as uppercase and characters other than A-Z, '*' and '-' as X.
+             */
+            PACKED_5BIT
+        };
+        static size_t const RESIDUES_PER_WORD = 12;
+        //! Built in header formats for FastaFile::setIdExtractor.
+        enum class IdFormat {
+            //! Accession between first and second '|' of sp| and tr| headers, otherwise the first token.
+            UNIPROT,
+            //! Accession after the database tag of gi| headers (NP_000001.1 in >gi|123|ref|NP_000001.1|), otherwise the first token.
+            NCBI,
+            //! First whitespace delimited token of header.
+            FIRST_TOKEN
+        };
+        /**
+         \brief Function which returns the protein ID from a header line. <br>
+         The argument is the header without the leading '>' or line ending.
+         The returned StringView must point into the argument.
+         */
+        typedef std::function<StringView(StringView header)> IdExtractor;
 
-        typedef std::map<std::string, size_t> IdMapType;
+    private:
+        typedef StringHashIndex IdMapType;
         typedef std::vector<FastaEntry> IndexMapType;
+        typedef std::vector<std::pair<size_t, size_t> > SequenceIndexType;
 
-        //!All peptide sequences which were already found are stored internally
-        std::map<std::string, std::string> _foundSequences;
         //!Stores beginning and ending offset indices of each protein index
         IndexMapType _indexOffsets;
-        //!Stores index values for each protein ID
+        //!Stores index values for each protein ID and alternate key
         IdMapType _idIndex;
-        //!Pre-parsed sequences for fast access
-        std::vector<std::string> _sequences;
+        //!IdKey flags of keys to index
+        unsigned _idKeys;
+        //!Function used to get the ID of each entry from its header
+        IdExtractor _idExtractor;
+        //!Residues of every protein concatenated with newlines removed
+        std::string _residues;
+        //!Offset in _residues and length of each protein sequence
+        SequenceIndexType _sequenceIndex;
         //!Total number of entries in fasta file
         size_t _sequenceCount;
-
-        //! Should previously read sequences be stored internally?
-        bool _storeFound;
+        Storage _storage;
+        //!Packed residues in PACKED_5BIT mode. Residue i is bits 5 * (i % 12) to 5 * (i % 12) + 4 of word i / 12.
+        std::vector<uint64_t> _packed;
+        //!Number of residues in _packed
+        size_t _packedSize;
 
         void _buildIndex();
         void _copyValues(const FastaFile&);
-        std::string _parseSequence(size_t beg, size_t end) const;
+        void _addEntry(StringView header, size_t beg, size_t end, size_t residuesOffset);
+        void _appendResidues(const char* begin, size_t len);
+        size_t _residueCount() const {
+            return _storage == Storage::PACKED_5BIT ? _packedSize : _residues.size();
+        }
+        StringView _getSequence(StringView proteinID, std::string& buffer, bool verbose = false) const;
+        //! 5 bit code of residue \p i in _packed
+        uint8_t _packedCode(size_t i) const {
+            return (_packed[i / RESIDUES_PER_WORD] >> (5 * (i % RESIDUES_PER_WORD))) & 31;
+        }
+        template<typename Callback>
+        void _scanPacked(size_t begin, size_t end, const std::vector<uint8_t>& codes, Callback callback) const;
 
     public:
         /**
         \brief Default constructor.
 
-        \param storeFound Should previously read sequences be stored internally?
-        This value should be set to false if object is used in multi-threaded environments.
+        \param storeFound Ignored.
+        \deprecated Lookups no longer cache sequences, so there is nothing to store and
+        the object is always safe to share between threads. Use FastaFile(const std::string&) instead.
         \param fname Path to fasta file.
         */
         FastaFile(bool storeFound = true, std::string fname = "") : BufferFile(fname) {
             _sequenceCount = 0;
-            _storeFound = storeFound;
-
+            _idKeys = ACCESSION;
+            _idExtractor = uniprotId;
+            _storage = Storage::ARENA;
+            _packedSize = 0;
+        }
+        /**
+        \brief Constructor.
+        \param fname Path to fasta file.
+        */
+        explicit FastaFile(const std::string& fname) : BufferFile(fname) {
+            _sequenceCount = 0;
+            _idKeys = ACCESSION;
+            _idExtractor = uniprotId;
+            _storage = Storage::ARENA;
+            _packedSize = 0;
         }
+        //! Overloaded constructor so string literals are not converted to bool.
+        explicit FastaFile(const char* fname) : FastaFile(std::string(fname)) {}
         //!Copy constructor
         FastaFile(const FastaFile& rhs) : BufferFile(rhs){
             _copyValues(rhs);
@@ -122,43 +241,129 @@ namespace utils {
         }
         bool read();
         bool read(std::string);
+        /**
+         \brief Set which header tokens are added to the ID index. Must be called before FastaFile::read.
+         \param idKeys Bitwise or of FastaFile::IdKey flags. ACCESSION is always indexed.
+         */
+        void setIdKeys(unsigned idKeys) {
+            _idKeys = idKeys | ACCESSION;
+        }
+        /**
+         \brief Set how residues are stored. Must be called before FastaFile::read.
+         \param storage Storage mode.
+         */
+        void setStorage(Storage storage) {
+            _storage = storage;
+        }
+        Storage getStorage() const {
+            return _storage;
+        }
+        void setIdExtractor(IdFormat format);
+        void setIdExtractor(IdExtractor extractor);
+
+        static StringView uniprotId(StringView header);
+        static StringView ncbiId(StringView header);
+        static StringView firstToken(StringView header);
+        static IdExtractor regexId(const std::string& pattern);
 
         //properties
-        size_t getIdIndex(std::string proteinID) const;
+        size_t getIdIndex(StringView proteinID) const;
         std::string getIndexID(size_t) const;
+        StringView getHeader(size_t) const;
         bool empty() const;
         size_t getSequenceCount() const;
-        std::string operator[] (size_t) const;
-        std::string at(size_t) const;
+        StringView operator[] (size_t) const;
+        StringView at(size_t) const;
+        StringView getSequence(size_t index, std::string& buffer) const;
+        size_t getSequenceLength(size_t index) const;
+        void findResidues(size_t index, const std::string& residues, std::vector<size_t>& positions) const;
+        size_t findInSequence(size_t index, StringView query, size_t pos = 0) const;
 
-        std::string getSequence(std::string proteinID, bool verbose = false);
-        std::string getSequence(std::string proteinID, bool verbose = false) const;
-        std::string getModifiedResidue(std::string proteinID, std::string peptideSeq, int modLoc);
+        StringView getSequence(StringView proteinID, bool verbose = false) const;
         std::string getModifiedResidue(std::string proteinID, std::string peptideSeq, int modLoc) const;
         std::string getModifiedResidue(std::string proteinID, std::string peptideSeq,
-                                       int modLoc, bool verbose, bool& found);
+                                       int modLoc, bool verbose, bool& found) const;
+        void getModifiedResidues(const std::vector<std::string>& proteinIDs,
+                                 const std::vector<std::string>& peptideSeqs,
+                                 const std::vector<int>& modLocs,
+                                 ModifiedResidueTable& result, unsigned int nThread = 0) const;
         int getMoodifiedResidueNumber(std::string peptideSeq, int modLoc) const;
 
-        std::string nBefore(const std::string& query, const std::string& ref_id,
-            unsigned n, bool noExcept = false);
-        std::string nAfter(const std::string& query, const std::string& ref_id,
-            unsigned n, bool noExcept = false);
         std::string nBefore(const std::string& query, const std::string& ref_id,
             unsigned n, bool noExcept = false) const;
         std::string nAfter(const std::string& query, const std::string& ref_id,
             unsigned n, bool noExcept = false) const;
-        size_t indexN(const std::string& query, const std::string& ref_id,
-            unsigned n, bool noExcept = false);
         size_t indexN(const std::string& query, const std::string& ref_id,
             unsigned n, bool noExcept = false) const;
     };
 
-    std::string getModifiedResidue(const std::string& seq, const std::string& peptideSeq, int modLoc);
+    /**
+     \brief Generate decoy sequences and write target-decoy databases. <br>
+
+     Decoys of every protein are generated in parallel, directly from the sequences in a FastaFile,
+     and written in batches of a fixed number of residues, so the whole decoy database is never held in memory.
+     Decoy entries have the same header as their target with a prefix added,
+     and are written in the same order as the targets.
+
+     Methods:
+     - REVERSE: Reverse the whole protein sequence.
+     - PSEUDO_REVERSE: Reverse each peptide between cleavage sites, keeping the cleavage residues in place,
+       so decoy peptides have the same precursor masses as the target peptides.
+     - SHUFFLE: Shuffle each peptide between cleavage sites, keeping the cleavage residues in place.
+       Each protein is shuffled with a random number generator seeded from the generator seed and protein index,
+       so the output is the same for every run and number of threads.
+     */
+    class DecoyGenerator {
+    public:
+        enum class Method {REVERSE, PSEUDO_REVERSE, SHUFFLE};
+        //! Approximate number of residues processed by each thread in each batch.
+        static size_t const CHUNK_RESIDUES = 1 << 20;
+
+    private:
+        Method _method;
+        std::string _prefix;
+        //! Is each character a cleavage residue?
+        bool _cleavage[256];
+        uint64_t _seed;
+        //! Residues per sequence line. If 0, sequences are written on one line.
+        size_t _lineWidth;
+        bool _includeTargets;
+
+        void _permute(std::string& seq, size_t begin, size_t end, uint64_t& state) const;
+        void _writeEntry(StringView header, StringView seq, std::string& out) const;
+
+    public:
+        explicit DecoyGenerator(Method method = Method::REVERSE, std::string prefix = "rev_");
+
+        void setMethod(Method method) {
+            _method = method;
+        }
+        void setPrefix(std::string prefix) {
+            _prefix = prefix;
+        }
+        void setCleavageResidues(const std::string& residues);
+        void setSeed(uint64_t seed) {
+            _seed = seed;
+        }
+        void setLineWidth(size_t lineWidth) {
+            _lineWidth = lineWidth;
+        }
+        //! Should the target entries be written before the decoys?
+        void setIncludeTargets(bool includeTargets) {
+            _includeTargets = includeTargets;
+        }
+
+        void makeDecoy(StringView target, size_t index, std::string& decoy) const;
+        bool write(const FastaFile& fasta, std::ostream& out, unsigned int nThread = 0) const;
+        bool write(const FastaFile& fasta, const std::string& ofname, unsigned int nThread = 0) const;
+    };
+
+    std::string getModifiedResidue(StringView seq, const std::string& peptideSeq, int modLoc);
 
-    bool align(const std::string& query, const std::string& ref, size_t& beg, size_t& end);
-    std::string nBefore(const std::string& query, const std::string& ref, unsigned n, bool noExcept = false);
-    std::string nAfter(const std::string& query, const std::string& ref, unsigned n, bool noExcept = false);
-    size_t indexN(const std::string& query, const std::string& ref, size_t n, bool noExcept = false);
+    bool align(const std::string& query, StringView ref, size_t& beg, size_t& end);
+    std::string nBefore(const std::string& query, StringView ref, unsigned n, bool noExcept = false);
+    std::string nAfter(const std::string& query, StringView ref, unsigned n, bool noExcept = false);
+    size_t indexN(const std::string& query, StringView ref, size_t n, bool noExcept = false);
 }
 
 #endif /* fastaFile_hpp */
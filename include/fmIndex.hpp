@@ -0,0 +1,194 @@
+//
+// fmIndex.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef fmIndex_hpp
+#define fmIndex_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <exceptions.hpp>
+#include <bufferFile.hpp>
+#include <stringView.hpp>
+#include <fastaFile.hpp>
+
+namespace utils {
+    class FmIndex;
+
+    /**
+     \brief FM-index over every protein sequence in a FastaFile. <br>
+
+     Count and locate queries take time proportional to the length of the query, and do not depend on
+     the size of the proteome, so questions like which proteins contain a peptide need no candidate list.
+
+     Sequences are concatenated with a separator between proteins, so matches never span two proteins.
+     Residues are case insensitive and anything other than A-Z is treated as a separator.
+     The index holds:
+     - The Burrows-Wheeler transform with one byte per residue.
+     - Occurrence counts of each symbol at every FmIndex::CHECKPOINT_INTERVAL positions.
+     - Suffix array values for every text position divisible by the sample rate, used by FmIndex::locate.
+
+     An index is built in memory with FmIndex::build, and can be saved with FmIndex::write.
+     Saved files are memory mapped by FmIndex::read. Loading an index only checks that each section is
+     consistent with the others, so a corrupt file can not cause a read outside of the index.
+     Use FmIndex::matches to check that a saved index was built from the same FastaFile.
+     The index is never modified after it is built or read, so queries are thread safe.
+
+     \code
+     FmIndex index;
+     if(!index.read(FmIndex::indexPath(fastaPath)) || !index.matches(fasta)) {
+         index.build(fasta);
+         index.write(FmIndex::indexPath(fastaPath));
+     }
+     std::vector<FmIndex::Occurrence> occurrences;
+     index.locate("PEPTIDE", occurrences);
+     \endcode
+     */
+    class FmIndex : public utils::BufferFile {
+    public:
+        //! Bit flags in FmIndex::Header::flags
+        enum Flags : uint32_t {
+            IL_EQUIVALENT = 1
+        };
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t flags;
+            //! Length of concatenated text including separators and terminator.
+            uint64_t textLength;
+            uint64_t proteinCount;
+            uint64_t saSampleRate;
+            uint64_t sampleCount;
+            //! Total length of protein sequences in the FastaFile the index was built from.
+            uint64_t residueCount;
+            //! Hash of the length of each protein sequence in the FastaFile the index was built from.
+            uint64_t sourceHash;
+            //! Absolute offsets of each section. Every section is aligned to 8 bytes.
+            uint64_t cOffset;
+            uint64_t bwtOffset;
+            uint64_t occOffset;
+            uint64_t markOffset;
+            uint64_t markRankOffset;
+            uint64_t sampleOffset;
+            uint64_t proteinOffset;
+            uint64_t fileSize;
+        };
+
+        //! Location of a query in a protein.
+        struct Occurrence {
+            //! Index of protein in FastaFile.
+            size_t protein;
+            //! 0 based offset of query in protein sequence.
+            size_t start;
+
+            Occurrence(size_t _protein = 0, size_t _start = 0) : protein(_protein), start(_start) {}
+            bool operator == (const Occurrence& rhs) const {
+                return protein == rhs.protein && start == rhs.start;
+            }
+            bool operator < (const Occurrence& rhs) const {
+                return protein == rhs.protein ? start < rhs.start : protein < rhs.protein;
+            }
+        };
+
+        static char const MAGIC[8];
+        static uint32_t const VERSION = 2;
+        static size_t const DEFAULT_SA_SAMPLE = 16;
+        static size_t const CHECKPOINT_INTERVAL = 64;
+        //! Number of symbols: terminator, separator and A-Z
+        static int const SIGMA = 28;
+
+    private:
+        //! Index built by FmIndex::build in the same layout as the file.
+        std::vector<uint64_t> _data;
+
+        // Sections of index in _data or _buffer
+        const Header* _header;
+        //! Number of symbols in text less than each symbol.
+        const uint64_t* _C;
+        const uint8_t* _bwt;
+        //! Count of each symbol in _bwt before each checkpoint.
+        const uint32_t* _occ;
+        //! Bit vector of BWT rows with a sampled suffix array value.
+        const uint64_t* _markBits;
+        //! Number of set bits in _markBits before each word.
+        const uint32_t* _markRank;
+        //! Sampled suffix array values in BWT row order.
+        const uint32_t* _samples;
+        //! Offset of each protein in text followed by the text length.
+        const uint64_t* _proteinStarts;
+
+        //! Symbol of each character or 0 for characters which are not residues.
+        uint8_t _code[256];
+
+        void _initAlphabet(bool ilEquivalent);
+        void _setSections(const char* data, size_t size);
+        void _clearSections();
+        size_t _rank(uint8_t c, size_t row) const;
+        size_t _lf(size_t row) const;
+        bool _range(StringView query, size_t& lo, size_t& hi) const;
+        size_t _textPosition(size_t row) const;
+
+        static void _fingerprint(const FastaFile& fasta, uint64_t& residueCount, uint64_t& sourceHash);
+        static void _suffixSort(const std::vector<uint8_t>& text, std::vector<uint32_t>& sa, unsigned int nThread);
+
+    public:
+        explicit FmIndex(std::string fname = "");
+        FmIndex(const FmIndex&) = delete;
+        FmIndex& operator = (const FmIndex&) = delete;
+
+        void build(const FastaFile& fasta, bool ilEquivalent = false,
+                   size_t saSampleRate = DEFAULT_SA_SAMPLE, unsigned int nThread = 0);
+        bool write(const std::string& ofname) const;
+        bool read();
+        bool read(std::string);
+
+        bool matches(const FastaFile& fasta) const;
+        size_t count(StringView query) const;
+        void locate(StringView query, std::vector<Occurrence>& occurrences) const;
+        void getProteins(StringView query, std::vector<size_t>& proteins) const;
+
+        //! Is the index empty?
+        bool empty() const {
+            return _header == nullptr;
+        }
+        size_t getProteinCount() const {
+            return _header == nullptr ? 0 : _header->proteinCount;
+        }
+        bool getILEquivalent() const {
+            return _header != nullptr && (_header->flags & IL_EQUIVALENT);
+        }
+        //! Default path of index for \p fastaPath.
+        static std::string indexPath(const std::string& fastaPath) {
+            return fastaPath + ".fmi";
+        }
+    };
+}
+
+#endif
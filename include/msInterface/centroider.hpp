@@ -0,0 +1,94 @@
+//
+// centroider.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef centroider_hpp
+#define centroider_hpp
+
+#include <cstddef>
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class Centroider;
+
+        /**
+         \brief Convert profile mode spectra to centroided peak lists. <br>
+
+         Peaks are local maxima in the profile intensities. The apex of each peak is refined
+         by fitting a curve through the maximum and its two neighbors.
+         Centroiding is a single pass over the profile points, so it is cheap enough to do
+         on the fly while iterating through a file (see MsInterface::enableCentroiding).
+
+         \code
+         Centroider centroider(3);
+         if(!scan.isCentroided())
+             centroider.centroid(scan);
+         \endcode
+         */
+        class Centroider {
+        public:
+            //! Curve used to estimate peak apex.
+            enum class Apex {
+                PARABOLIC, /**< Parabola through the 3 points around the maximum. */
+                GAUSSIAN /**< Parabola through the log intensities of the 3 points around the maximum. */
+            };
+
+        private:
+            //! Minimum ratio of peak intensity to estimated noise level. 0 keeps every local maximum.
+            double _snThreshold;
+            Apex _apex;
+
+        public:
+            explicit Centroider(double snThreshold = 0, Apex apex = Apex::GAUSSIAN) {
+                _snThreshold = snThreshold;
+                _apex = apex;
+            }
+
+            void setSNThreshold(double snThreshold) {
+                _snThreshold = snThreshold;
+            }
+            void setApex(Apex apex) {
+                _apex = apex;
+            }
+            double getSNThreshold() const {
+                return _snThreshold;
+            }
+            Apex getApex() const {
+                return _apex;
+            }
+
+            void centroid(const double* mz, const double* intensity, size_t n,
+                          std::vector<double>& outMZ, std::vector<double>& outIntensity) const;
+            void centroid(Scan& scan) const;
+            static double estimateNoise(const double* intensity, size_t n);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,125 @@
+//
+// chromatogram.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef chromatogram_hpp
+#define chromatogram_hpp
+
+#include <string>
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class Chromatogram;
+        struct RunSummary;
+
+        //! Intensity as a function of retention time.
+        class Chromatogram {
+        private:
+            std::string _id;
+            //! Retention times in seconds.
+            std::vector<double> _time;
+            std::vector<double> _intensity;
+
+        public:
+            explicit Chromatogram(std::string id = "") : _id(std::move(id)) {}
+
+            void clear() {
+                _id.clear();
+                _time.clear();
+                _intensity.clear();
+            }
+            void add(double time, double intensity) {
+                _time.push_back(time);
+                _intensity.push_back(intensity);
+            }
+
+            void setId(const std::string& id) {
+                _id = id;
+            }
+            const std::string& getId() const {
+                return _id;
+            }
+            std::vector<double>& getTime() {
+                return _time;
+            }
+            const std::vector<double>& getTime() const {
+                return _time;
+            }
+            std::vector<double>& getIntensity() {
+                return _intensity;
+            }
+            const std::vector<double>& getIntensity() const {
+                return _intensity;
+            }
+            size_t size() const {
+                return _time.size();
+            }
+        };
+
+        /**
+         \brief Per scan summary statistics for every scan in a run. <br>
+
+         Statistics are stored in parallel columns where row i of each column refers to the same scan.
+         Rows are sorted by scan number. Populated by MsInterface::summarizeRun.
+         */
+        struct RunSummary {
+            std::vector<size_t> scanNum;
+            //! MS level. 0 if the scan could not be read.
+            std::vector<int> level;
+            //! Retention time in seconds.
+            std::vector<double> rt;
+            //! Total ion current.
+            std::vector<double> tic;
+            std::vector<double> basePeakMZ;
+            std::vector<double> basePeakIntensity;
+            std::vector<size_t> peakCount;
+            //! Scan number of precursor scan. 0 if not known.
+            std::vector<size_t> precursorScan;
+            //! Precursor m/z. 0 for MS1 scans.
+            std::vector<double> precursorMZ;
+            //! Precursor charge. 0 if not known.
+            std::vector<int> precursorCharge;
+            //! Lower and upper m/z bounds of the isolation window. Both are 0 if not known.
+            std::vector<double> isolationLower;
+            std::vector<double> isolationUpper;
+
+            void clear();
+            void resize(size_t n);
+            void setPrecursor(size_t row, const PrecursorScan& precursor);
+            size_t size() const {
+                return scanNum.size();
+            }
+
+            void getTIC(Chromatogram& chromatogram, int msLevel = 1) const;
+            void getBPC(Chromatogram& chromatogram, int msLevel = 1) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+//
+// deisotoper.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef deisotoper_hpp
+#define deisotoper_hpp
+
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class Deisotoper;
+
+        /**
+         \brief Collapse isotope envelopes in centroided scans to singly charged monoisotopic peaks. <br>
+
+         Peaks are visited in order of increasing m/z. Starting from each peak not yet assigned to a cluster,
+         the next isotope peak for each charge from the maximum charge down to 1 is found with a binary search
+         over the sorted m/z array. A peak is added to the cluster if the ratio of its intensity to the
+         previous peak is close to the ratio expected from a Poisson approximation of the averagine isotope
+         distribution. The charge which gives the longest cluster is chosen.
+
+         Each cluster is replaced by one peak at the singly charged m/z of its monoisotopic peak.
+         */
+        class Deisotoper {
+        public:
+            //! Mass difference between 13C and 12C.
+            static double const C13_DIFF;
+            //! Expected number of heavy isotopes per Dalton of averagine.
+            static double const AVERAGINE_ISOTOPE_RATE;
+
+        private:
+            MZTolerance _tolerance;
+            int _maxCharge;
+            //! Minimum number of peaks in an isotope cluster.
+            size_t _minPeaks;
+            //! Maximum number of peaks in an isotope cluster.
+            size_t _maxPeaks;
+            //! Maximum fold difference between observed and expected intensity ratio of adjacent isotopes.
+            double _ratioTolerance;
+            //! Whether peaks which are not part of a cluster are kept.
+            bool _keepUnassigned;
+            //! Whether the intensity of a collapsed cluster is the sum of all its peaks or only the monoisotopic peak.
+            bool _sumIntensities;
+
+        public:
+            explicit Deisotoper(const MZTolerance& tolerance = MZTolerance(10), int maxCharge = 4) {
+                _tolerance = tolerance;
+                _maxCharge = maxCharge;
+                _minPeaks = 2;
+                _maxPeaks = 6;
+                _ratioTolerance = 3;
+                _keepUnassigned = true;
+                _sumIntensities = true;
+            }
+
+            void setTolerance(const MZTolerance& tolerance) {
+                _tolerance = tolerance;
+            }
+            void setMaxCharge(int maxCharge) {
+                _maxCharge = maxCharge;
+            }
+            void setMinPeaks(size_t minPeaks) {
+                _minPeaks = minPeaks;
+            }
+            void setMaxPeaks(size_t maxPeaks) {
+                _maxPeaks = maxPeaks;
+            }
+            void setRatioTolerance(double ratioTolerance) {
+                _ratioTolerance = ratioTolerance;
+            }
+            void setKeepUnassigned(bool keepUnassigned) {
+                _keepUnassigned = keepUnassigned;
+            }
+            void setSumIntensities(bool sumIntensities) {
+                _sumIntensities = sumIntensities;
+            }
+
+            void process(Scan& scan, std::vector<int>* charges = nullptr) const;
+        };
+    }
+}
+
+#endif
@@ -12,6 +12,7 @@
 #ifndef base64_utils_hpp
 #define base64_utils_hpp
 
+#include <cstring>
 #include <iostream>
 
 #include <thirdparty/rapidxml/rapidxml.hpp>
@@ -27,6 +28,10 @@ namespace utils {
         uint64_t _dtohl(uint64_t l, bool bigEndian);
         unsigned long _dtohl(uint32_t l, bool bigEndian);
         int _b64_decode_mio( char *dest,  char *src, size_t size );
+        bool _b64_decode_range(char* dest, const char* src, size_t srcLen, size_t offset, size_t size);
+        size_t _b64_encode(char* dest, const char* src, size_t size);
+        void _b64_encode(std::string& dest, const char* src, size_t size);
+        void _compress(std::string& dest, const char* src, size_t size);
         void _decode32(msInterface::Scan& scan, const char* pData, size_t dataSize, size_t peaksCount, bool bigEndian = true);
         void _decode64(msInterface::Scan& scan, const char* pData, size_t dataSize, size_t peaksCount, bool bigEndian = true);
 
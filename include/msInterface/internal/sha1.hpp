@@ -0,0 +1,62 @@
+//
+// sha1.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef sha1_hpp
+#define sha1_hpp
+
+#include <cstdint>
+#include <string>
+
+namespace utils {
+    namespace internal {
+        /**
+         \brief Incremental SHA-1 digest. <br>
+
+         Used to calculate the checksums at the end of indexed mzML and mzXML files.
+         */
+        class Sha1 {
+        private:
+            uint32_t _state[5];
+            unsigned char _block[64];
+            size_t _blockLen;
+            uint64_t _totalLen;
+
+            void _processBlock(const unsigned char* block);
+
+        public:
+            Sha1() {
+                reset();
+            }
+
+            void reset();
+            void update(const char* data, size_t len);
+            std::string hexDigest();
+        };
+    }
+}
+
+#endif
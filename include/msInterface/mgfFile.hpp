@@ -0,0 +1,63 @@
+//
+// mgfFile.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef mgfFile_hpp
+#define mgfFile_hpp
+
+#include <string>
+
+#include <utils.hpp>
+#include <exceptions.hpp>
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class MgfFile;
+
+        /**
+         \brief Reader for Mascot generic format (.mgf) files. <br>
+
+         Each BEGIN IONS ... END IONS block is one MS2 scan.
+         Scan numbers are taken from the SCANS parameter or from "scan=" in the TITLE.
+         If any block does not have a scan number, or scan numbers are not unique,
+         the 1 based position of each block in the file is used as its scan number instead.
+         */
+        class MgfFile : public MsInterface {
+        private:
+            void _buildIndex() override;
+            bool _getScan(size_t, Scan &) const override;
+            size_t _findScanNumber(const char* begin, const char* end) const;
+            static bool _isParam(const char* line, const char* eol, const char* name, const char*& value);
+
+        public:
+            explicit MgfFile(std::string fname = "") : MsInterface(fname) {}
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+//
+// ms1File.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ms1File_hpp
+#define ms1File_hpp
+
+#include <string>
+
+#include <msInterface/ms2File.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class Ms1File;
+
+        /**
+         \brief Reader for .ms1 files. <br>
+
+         .ms1 files use the same line format as .ms2 files, except that S lines
+         do not have a precursor m/z and every scan is MS level 1.
+         */
+        class Ms1File : public Ms2File {
+        public:
+            explicit Ms1File(std::string fname = "") : Ms2File(fname) {
+                _msLevel = 1;
+            }
+        };
+    }
+}
+
+#endif
@@ -49,21 +49,29 @@ namespace utils {
 
         class Ms2File : public MsInterface {
         private:
+            //! Maximum number of tab delimited fields split in a header line.
+            static size_t const MAX_FIELDS = 8;
+
             bool getMetaData();
+            static size_t _splitLine(const char* begin, const char* end, const char** fields, const char** fieldEnds);
+            static bool _isKey(const char* key, const char* s, size_t len);
 
             void _buildIndex() override;
+            bool _getScan(size_t, Scan &) const override;
+
+        protected:
+            //! MS level of scans in file.
+            int _msLevel;
 
         public:
             Ms2File(std::string fname = "") : MsInterface(fname) {
                 initMetadata();
+                _msLevel = 2;
             }
             ~Ms2File() {}
 
             bool read() override;
             bool read(std::string fname) override;
-
-            //properties
-            bool getScan(size_t, Scan &) const override;
         };
     }
 }//end of namespace
@@ -0,0 +1,81 @@
+//
+// ms2Writer.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ms2Writer_hpp
+#define ms2Writer_hpp
+
+#include <string>
+
+#include <msInterface/msWriter.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class Ms2Writer;
+
+        /**
+         \brief Write MS2 scans to a .ms2 file. <br>
+
+         Scans with an MS level other than 2 are skipped.
+         Scan retention times are in seconds, but are written in minutes for the RetTime line.
+         */
+        class Ms2Writer : public MsWriter {
+        private:
+            int _mzPrecision;
+            int _intensityPrecision;
+            //! Offsets of FirstScan and LastScan values in header.
+            size_t _firstScanOffset, _lastScanOffset;
+
+            bool _accept(const Scan& scan) const override;
+            void _writeHeader(const Scan* firstScan) override;
+            void _writeFooter() override;
+            void _encodeScan(const Scan& scan, size_t index, std::string& out) const override;
+
+        public:
+            explicit Ms2Writer(unsigned int nThread = 0, size_t batchSize = DEFAULT_BATCH_SIZE)
+                : MsWriter(nThread, batchSize) {
+                _mzPrecision = 4;
+                _intensityPrecision = 1;
+                _firstScanOffset = 0;
+                _lastScanOffset = 0;
+            }
+            ~Ms2Writer() override {
+                close();
+            }
+
+            //! Set number of digits after the decimal point for ion m/z values.
+            void setMZPrecision(int precision) {
+                _mzPrecision = precision;
+            }
+            //! Set number of digits after the decimal point for ion intensity values.
+            void setIntensityPrecision(int precision) {
+                _intensityPrecision = precision;
+            }
+        };
+    }
+}
+
+#endif
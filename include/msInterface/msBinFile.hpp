@@ -0,0 +1,132 @@
+//
+// msBinFile.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef msBinFile_hpp
+#define msBinFile_hpp
+
+#include <cstdint>
+#include <string>
+
+#include <utils.hpp>
+#include <exceptions.hpp>
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class MsBinFile;
+
+        /**
+         \brief Reader and writer for a compact binary spectrum format. <br>
+
+         All values are little endian. The file has the layout:
+         - A fixed size MsBinFile::Header.
+         - A table with one fixed size MsBinFile::ScanRecord for each scan.
+         - Contiguous m/z and intensity arrays for each scan, aligned to 8 bytes.
+           Arrays are stored as 64 or 32 bit floats and can optionally be zlib compressed.
+         - A string table with the precursor m/z, scan, file and sample name of each scan.
+
+         Files are memory mapped when read, so getting an uncompressed scan is a pointer offset
+         with no parsing.
+         */
+        class MsBinFile : public MsInterface {
+        public:
+            //! Bit flags in MsBinFile::Header::flags
+            enum Flags : uint32_t {
+                FLOAT_MZ = 1,
+                FLOAT_INTENSITY = 2,
+                ZLIB = 4
+            };
+
+            struct Header {
+                char magic[8];
+                uint32_t version;
+                uint32_t flags;
+                uint64_t scanCount;
+                uint64_t scanTableOffset;
+                uint64_t stringTableOffset;
+                uint64_t stringTableSize;
+                uint64_t reserved[2];
+            };
+
+            struct ScanRecord {
+                uint64_t scanNum;
+                uint64_t peaksCount;
+                //! Absolute file offset of m/z array.
+                uint64_t mzOffset;
+                //! Length of m/z array in bytes as stored in the file.
+                uint64_t mzBytes;
+                uint64_t intensityOffset;
+                uint64_t intensityBytes;
+                double rt;
+                double precursorIntensity;
+                double ionInjectionTime;
+                double ionMobilityCV;
+                int32_t level;
+                int32_t polarity;
+                int32_t charge;
+                int32_t activationMethod;
+                uint32_t isIonMobilityScan;
+                //! Offsets of precursor m/z, scan, file and sample strings relative to the string table.
+                uint32_t stringOffsets[4];
+                uint32_t stringLengths[4];
+                //! Non zero if the scan is profile mode data. (Was reserved in earlier files, where it is always 0.)
+                uint32_t profile;
+            };
+
+        private:
+            uint32_t _flags;
+
+            void _buildIndex() override;
+            bool _getScan(size_t, Scan &) const override;
+            bool _getPeaksInRange(size_t queryScan, double lower, double upper,
+                                  std::vector<double>& mz, std::vector<double>& intensity) const override;
+            const ScanRecord* _getRecord(size_t queryScan) const;
+
+            template<typename T>
+            static void _decodeArray(const char* data, size_t nBytes, size_t peaksCount, bool zlib,
+                                     std::vector<double>& arr);
+
+        public:
+            static char const MAGIC[8];
+            static uint32_t const VERSION = 1;
+
+            explicit MsBinFile(std::string fname = "") : MsInterface(fname) {
+                _flags = 0;
+                _useMmap = true;
+            }
+
+            bool getPeakArrays(size_t queryScan, const double*& mz, const double*& intensity, size_t& peaksCount) const;
+
+            static bool write(const MsInterface& input, const std::string& ofname,
+                              bool floatMZ = false, bool floatIntensity = false,
+                              bool zlib = false, unsigned int nThread = 0);
+        };
+    }
+}
+
+#endif
@@ -28,10 +28,14 @@
 #define msFileBase_hpp
 
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <bufferFile.hpp>
 #include <msInterface/msScan.hpp>
+#include <msInterface/scanCache.hpp>
+#include <msInterface/centroider.hpp>
+#include <msInterface/chromatogram.hpp>
 
 namespace utils {
     namespace msInterface {
@@ -42,7 +46,7 @@ namespace utils {
         class MsInterface : public utils::BufferFile {
         public:
             enum class FileType {
-                MS2, MZXML, MZML, UNKNOWN
+                MS2, MZXML, MZML, MSBIN, MS1, MGF, UNKNOWN
             };
 
         protected:
@@ -64,7 +68,18 @@ namespace utils {
             std::string _parentFileBase;
             size_t firstScan, lastScan;
 
+            //! Optional cache of decoded scans. nullptr if caching is disabled.
+            std::unique_ptr<ScanCache> _scanCache;
+            //! Optional centroider applied to profile mode scans. nullptr if centroiding is disabled.
+            std::unique_ptr<Centroider> _centroider;
+            //! Maps scan numbers of MSn scans to the scan number of their parent scan. Populated by MsInterface::buildParentIndex
+            std::map<size_t, size_t> _parentScanMap;
+
             virtual void _buildIndex() = 0;
+            virtual bool _getScan(size_t, Scan &) const = 0;
+            virtual bool _summarizeScan(size_t queryScan, RunSummary& summary, size_t row) const;
+            virtual bool _getPeaksInRange(size_t queryScan, double lower, double upper,
+                                          std::vector<double>& mz, std::vector<double>& intensity) const;
             void copyMetadata(const MsInterface &rhs);
             void initMetadata();
             size_t _getScanIndex(size_t) const;
@@ -83,10 +98,26 @@ namespace utils {
             void calcParentFileBase(std::string path);
             virtual bool read(std::string) override;
             virtual bool read();
-            virtual bool getScan(size_t, Scan &) const = 0;
+            bool getScan(size_t, Scan &) const;
             bool getScan(std::string, Scan &) const;
+            bool getPeaksInRange(size_t queryScan, double lower, double upper,
+                                 std::vector<double>& mz, std::vector<double>& intensity) const;
             void clear();
 
+            void enableScanCache(size_t maxBytes, size_t nShards = ScanCache::DEFAULT_SHARDS);
+            void disableScanCache();
+            //! Get scan cache. Returns nullptr if caching is disabled.
+            const ScanCache* getScanCache() const {
+                return _scanCache.get();
+            }
+
+            void enableCentroiding(const Centroider& centroider = Centroider());
+            void disableCentroiding();
+            //! Get centroider. Returns nullptr if centroiding is disabled.
+            const Centroider* getCentroider() const {
+                return _centroider.get();
+            }
+
             //metadata getters
             size_t getScanCount() const {
                 return _scanCount;
@@ -102,6 +133,13 @@ namespace utils {
             }
             size_t nextScan(size_t i) const;
             size_t prevScan(size_t i) const;
+            void getScanNumbers(std::vector<size_t>& scans) const;
+            void summarizeRun(RunSummary& summary, unsigned int nThread = 0) const;
+            void buildParentIndex(unsigned int nThread = 0);
+            void buildParentIndex(const RunSummary& summary);
+            size_t getParentScan(size_t queryScan) const;
+            static void getParentScans(const RunSummary& summary, std::vector<size_t>& parents);
+            void adviseScan(size_t queryScan) const;
             static FileType getFileType(std::string fname);
         };
     }
@@ -39,6 +39,9 @@ namespace utils {
         typedef double ScanIntensity;
         typedef double ScanMZ;
 
+        //! Mass of a proton in Da.
+        double const PROTON_MASS = 1.00727646688;
+
         //! Represents ion activation methods
         enum class ActivationMethod {
             CID, /**< collision-induced dissociation */
@@ -60,6 +63,31 @@ namespace utils {
 
         class PrecursorScan;
 
+        //! Returned by Scan::findPeak when no peak is inside the tolerance window.
+        size_t const PEAK_NOT_FOUND = std::string::npos;
+
+        //! Which peak to choose when more than one peak is inside a tolerance window.
+        enum class PeakSelect {
+            CLOSEST, /**< Peak with m/z closest to the query */
+            MOST_INTENSE /**< Peak with the greatest intensity */
+        };
+
+        //! m/z tolerance in either parts per million or Daltons.
+        struct MZTolerance {
+            enum class Unit {PPM, DA};
+            double value;
+            Unit unit;
+
+            MZTolerance(double _value = 10, Unit _unit = Unit::PPM) {
+                value = _value;
+                unit = _unit;
+            }
+            //! Half width of tolerance window around \p mz.
+            double width(double mz) const {
+                return unit == Unit::PPM ? mz * value / 1e6 : value;
+            }
+        };
+
         template<typename MZ_T, typename INTENSITY_T>
         class Ion;
 
@@ -147,6 +175,8 @@ namespace utils {
             std::string _sample;
             ActivationMethod _activationMethod;
             int _charge;
+            //! Lower and upper m/z bounds of isolation window. Both are 0 if the window is not known.
+            double _isolationLower, _isolationUpper;
 
         public:
             PrecursorScan() : Ion("", 0) {
@@ -156,6 +186,8 @@ namespace utils {
                 _sample = "";
                 _charge = 0;
                 _activationMethod = ActivationMethod::UNKNOWN;
+                _isolationLower = 0;
+                _isolationUpper = 0;
             }
 
             PrecursorScan(const PrecursorScan &rhs) : Ion(rhs) {
@@ -165,6 +197,8 @@ namespace utils {
                 _sample = rhs._sample;
                 _charge = rhs._charge;
                 _activationMethod = rhs._activationMethod;
+                _isolationLower = rhs._isolationLower;
+                _isolationUpper = rhs._isolationUpper;
             }
 
             PrecursorScan &operator=(const PrecursorScan &rhs) {
@@ -175,6 +209,8 @@ namespace utils {
                 _sample = rhs._sample;
                 _charge = rhs._charge;
                 _activationMethod = rhs._activationMethod;
+                _isolationLower = rhs._isolationLower;
+                _isolationUpper = rhs._isolationUpper;
                 return *this;
             }
             bool operator==(const PrecursorScan& rhs) const;
@@ -198,6 +234,11 @@ namespace utils {
             void setCharge(int charge) {
                 _charge = charge;
             }
+            //! Set isolation window m/z bounds.
+            void setIsolationWindow(double lower, double upper) {
+                _isolationLower = lower;
+                _isolationUpper = upper;
+            }
             void clear();
 
             //properties
@@ -221,6 +262,18 @@ namespace utils {
             ActivationMethod getActivationMethod() const {
                 return _activationMethod;
             }
+            //! Lower m/z bound of isolation window. 0 if not known.
+            double getIsolationLower() const {
+                return _isolationLower;
+            }
+            //! Upper m/z bound of isolation window. 0 if not known.
+            double getIsolationUpper() const {
+                return _isolationUpper;
+            }
+            //! true if the isolation window is known.
+            bool hasIsolationWindow() const {
+                return _isolationUpper > _isolationLower;
+            }
         };
 
         class Scan {
@@ -243,10 +296,18 @@ namespace utils {
 
             double _ionMobilityCV;
             bool _isIonMobilityScan;
+            //! false if ions are profile mode data points.
+            bool _centroided;
+
+            enum class SortState {SORTED, UNSORTED, UNKNOWN};
+            //! Whether _ions are sorted by m/z. UNKNOWN after _ions is exposed through a non-const accessor.
+            SortState _sortState;
 
             //! vector of Ion(s)
             IonsType _ions;
 
+            size_t _findPeak(ScanMZ mz, const MZTolerance& tolerance, PeakSelect select, bool sorted) const;
+
         public:
 
             Scan() {
@@ -260,6 +321,8 @@ namespace utils {
                 _ionInjectionTime = 0;
                 _ionMobilityCV = 0;
                 _isIonMobilityScan = false;
+                _centroided = true;
+                _sortState = SortState::SORTED;
                 precursorScan = PrecursorScan();
                 _ions = IonsType();
                 _scanNum = std::string::npos;
@@ -270,6 +333,7 @@ namespace utils {
             bool operator==(const Scan& rhs) const;
 
             void clear();
+            void swap(Scan& rhs);
             void add(const ScanIon &);
             void add(ScanMZ, ScanIntensity);
             void setMinMZ(ScanMZ);
@@ -284,24 +348,29 @@ namespace utils {
                 return precursorScan;
             }
             IonsType &getIons() {
+                _sortState = SortState::UNKNOWN;
                 return _ions;
             }
             ScanIon &operator[](size_t i) {
+                _sortState = SortState::UNKNOWN;
                 return _ions[i];
             }
             const ScanIon &at(size_t i) const {
                 return _ions.at(i);
             }
             ScanIon &at(size_t i) {
+                _sortState = SortState::UNKNOWN;
                 return _ions.at(i);
             }
             const IonsType &getIons() const {
                 return _ions;
             }
             IonsType::iterator begin() {
+                _sortState = SortState::UNKNOWN;
                 return _ions.begin();
             }
             IonsType::iterator end() {
+                _sortState = SortState::UNKNOWN;
                 return _ions.end();
             }
             IonsType::const_iterator begin() const {
@@ -355,6 +424,12 @@ namespace utils {
             bool isIonMobilityScan() const {
                 return _isIonMobilityScan;
             }
+            void setCentroided(bool centroided) {
+                _centroided = centroided;
+            }
+            bool isCentroided() const {
+                return _centroided;
+            }
             void setScanNum(size_t scanNum) {
                 _scanNum = scanNum;
             }
@@ -371,6 +446,15 @@ namespace utils {
                 _polarity = p;
             }
             void printIons(std::ostream&, char sep = '\t');
+            size_t memoryUsage() const;
+
+            bool isSorted() const;
+            void sortByMZ();
+            size_t findPeak(ScanMZ mz, const MZTolerance& tolerance,
+                            PeakSelect select = PeakSelect::CLOSEST) const;
+            std::pair<IonsType::const_iterator, IonsType::const_iterator> peaksInRange(ScanMZ lower, ScanMZ upper) const;
+            void matchPeaks(const std::vector<ScanMZ>& queries, const MZTolerance& tolerance,
+                            std::vector<size_t>& matches, PeakSelect select = PeakSelect::CLOSEST) const;
         };
     }
 }
@@ -0,0 +1,135 @@
+//
+// msWriter.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef msWriter_hpp
+#define msWriter_hpp
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class MsWriter;
+
+        /**
+         \brief Base class for writing Scan(s) to a file. <br>
+
+         Scans passed to MsWriter::write are buffered in batches. When a batch is full,
+         the scans in the batch are encoded in parallel and then written to the file in the
+         order they were passed to MsWriter::write, so memory usage is bounded by the batch size.
+         The byte offset of each scan is recorded so subclasses can write an index in the footer.
+
+         \code
+         MzMLWriter writer;
+         writer.open("out.mzML");
+         writer.write(msFile); // or writer.write(scan) for individual scans
+         writer.close();
+         \endcode
+         */
+        class MsWriter {
+        public:
+            static size_t const DEFAULT_BATCH_SIZE = 256;
+            static char const* const SOFTWARE_NAME;
+            static char const* const SOFTWARE_VERSION;
+
+        protected:
+            //! Width of fields in the header which are overwritten when the file is closed.
+            static size_t const PLACEHOLDER_WIDTH = 30;
+
+            std::string _fname;
+            std::fstream _out;
+            //! Number of bytes written to _out.
+            size_t _offset;
+            bool _headerWritten;
+            unsigned int _nThread;
+
+            //! Scans waiting to be encoded. Only the first _batchCount elements are used.
+            std::vector<Scan> _batch;
+            size_t _batchCount;
+            //! Encoded scans in current batch.
+            std::vector<std::string> _encoded;
+
+            //! Pairs of scan numbers and byte offsets of each scan written.
+            std::vector<std::pair<size_t, size_t>> _index;
+            size_t _minScan, _maxScan;
+
+            void _write(const std::string& s);
+            void _flush();
+            void _overwrite(size_t offset, const std::string& s);
+            std::string _sha1();
+            static std::string _pad(std::string s, size_t width = PLACEHOLDER_WIDTH);
+            static std::string _toString(double value, int precision = 10);
+            static std::string _escapeXml(const std::string& s);
+            static void _summarize(const Scan& scan, double& tic, double& basePeakMZ, double& basePeakInt);
+
+            //! Return false if \p scan can not be represented in the output format.
+            virtual bool _accept(const Scan& scan) const {
+                return true;
+            }
+            /**
+             \brief Write file header.
+             \param firstScan First scan written to file or nullptr if the file is empty.
+             */
+            virtual void _writeHeader(const Scan* firstScan) = 0;
+            //! Write everything after the last scan and fill in header placeholders.
+            virtual void _writeFooter() = 0;
+            /**
+             \brief Encode a single scan. Called concurrently from multiple threads.
+             \param scan Scan to encode.
+             \param index Index of scan in file.
+             \param out Empty string to append encoded scan to.
+             */
+            virtual void _encodeScan(const Scan& scan, size_t index, std::string& out) const = 0;
+
+        public:
+            explicit MsWriter(unsigned int nThread = 0, size_t batchSize = DEFAULT_BATCH_SIZE);
+            MsWriter(const MsWriter&) = delete;
+            MsWriter& operator = (const MsWriter&) = delete;
+            virtual ~MsWriter() = default;
+
+            bool open(const std::string& fname);
+            bool write(const Scan& scan);
+            size_t write(const MsInterface& file);
+            void close();
+
+            bool isOpen() const {
+                return _out.is_open();
+            }
+            //! Number of scans written so far.
+            size_t getScanCount() const {
+                return _index.size() + _batchCount;
+            }
+        };
+    }
+}
+
+#endif
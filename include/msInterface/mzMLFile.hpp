@@ -41,15 +41,49 @@ namespace utils{
 
         class MzMLFile : public MsInterface {
         private:
+            //! Offsets of beginning and end of each <chromatogram>
+            OffsetIndexType _chromatogramIndex;
+            //! id attribute of each <chromatogram>
+            std::vector<std::string> _chromatogramIds;
+
+            //! Location of a base64 encoded binary array in the file buffer.
+            struct EncodedArray {
+                const char* data;
+                //! Number of base64 characters.
+                size_t size;
+                //! Bytes per element. 0 if the array is compressed.
+                size_t width;
+                EncodedArray() : data(nullptr), size(0), width(0) {}
+                size_t length() const;
+                double at(size_t i) const;
+            };
+
             void _buildIndex() override;
+            bool _getScan(size_t, Scan &) const override;
+            bool _summarizeScan(size_t queryScan, RunSummary& summary, size_t row) const override;
+            bool _getPeaksInRange(size_t queryScan, double lower, double upper,
+                                  std::vector<double>& mz, std::vector<double>& intensity) const override;
+            static bool _findEncodedArrays(const char* begin, const char* end, EncodedArray& mz, EncodedArray& intensity);
 
             std::string _parseScan(const std::string&) const;
+            void _parsePrecursor(rapidxml::xml_node<>* precursorList, PrecursorScan& precursor) const;
+            static void _decodeArrays(rapidxml::xml_node<>* root, const char* xAccession, const char* xName,
+                                      const std::string& id, std::vector<double>& x, std::vector<double>& intensity,
+                                      std::string* xUnit = nullptr);
 
         public:
             MzMLFile(std::string fname = "") : MsInterface(fname){}
 
-            //properties
-            bool getScan(size_t, Scan &) const override;
+            //! Number of chromatograms in file.
+            size_t getChromatogramCount() const {
+                return _chromatogramIds.size();
+            }
+            //! id of each chromatogram in the order they appear in the file.
+            const std::vector<std::string>& getChromatogramIds() const {
+                return _chromatogramIds;
+            }
+            bool getChromatogram(size_t index, Chromatogram& chromatogram) const;
+            bool getChromatogram(const std::string& id, Chromatogram& chromatogram) const;
         };
     }
 }
@@ -0,0 +1,98 @@
+//
+// mzMLWriter.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef mzMLWriter_hpp
+#define mzMLWriter_hpp
+
+#include <string>
+#include <vector>
+
+#include <msInterface/msWriter.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class MzMLWriter;
+
+        /**
+         \brief Write scans to an indexedmzML file. <br>
+
+         Binary arrays can be written as 32 or 64 bit floats, MS-Numpress encoded, and optionally zlib compressed.
+         The file ends with an \<indexList\> of spectrum offsets and a SHA-1 \<fileChecksum\>.
+         */
+        class MzMLWriter : public MsWriter {
+        public:
+            enum class Numpress {NONE, LINEAR, PIC, SLOF};
+
+        private:
+            bool _mzDoublePrecision;
+            bool _intensityDoublePrecision;
+            bool _zlib;
+            Numpress _mzNumpress;
+            Numpress _intensityNumpress;
+            //! Offset of spectrumList count attribute.
+            size_t _spectrumCountOffset;
+
+            void _writeHeader(const Scan* firstScan) override;
+            void _writeFooter() override;
+            void _encodeScan(const Scan& scan, size_t index, std::string& out) const override;
+            void _encodeArray(const std::vector<double>& values, bool doublePrecision, Numpress numpress,
+                              const std::string& arrayCvParam, std::string& out) const;
+            static std::string _spectrumID(const std::string& scanNum);
+
+        public:
+            explicit MzMLWriter(unsigned int nThread = 0, size_t batchSize = DEFAULT_BATCH_SIZE)
+                : MsWriter(nThread, batchSize) {
+                _mzDoublePrecision = true;
+                _intensityDoublePrecision = false;
+                _zlib = false;
+                _mzNumpress = Numpress::NONE;
+                _intensityNumpress = Numpress::NONE;
+                _spectrumCountOffset = 0;
+            }
+            ~MzMLWriter() override {
+                close();
+            }
+
+            //! Write m/z and intensity arrays as 64 bit instead of 32 bit floats.
+            void setDoublePrecision(bool mz, bool intensity) {
+                _mzDoublePrecision = mz;
+                _intensityDoublePrecision = intensity;
+            }
+            //! zlib compress binary arrays.
+            void setZlib(bool zlib) {
+                _zlib = zlib;
+            }
+            //! MS-Numpress encode binary arrays. Numpress encoded arrays are always decoded as 64 bit floats.
+            void setNumpress(Numpress mz, Numpress intensity) {
+                _mzNumpress = mz;
+                _intensityNumpress = intensity;
+            }
+        };
+    }
+}
+
+#endif
@@ -42,12 +42,10 @@ namespace utils{
         class MzXMLFile : public MsInterface {
         private:
             void _buildIndex() override;
+            bool _getScan(size_t, Scan &) const override;
 
         public:
             MzXMLFile(std::string fname = "") : MsInterface(fname){}
-
-            //properties
-            bool getScan(size_t, Scan &) const override;
         };
     }
 }
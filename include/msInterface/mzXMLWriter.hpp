@@ -0,0 +1,78 @@
+//
+// mzXMLWriter.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef mzXMLWriter_hpp
+#define mzXMLWriter_hpp
+
+#include <string>
+
+#include <msInterface/msWriter.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class MzXMLWriter;
+
+        /**
+         \brief Write scans to an indexed mzXML file. <br>
+
+         Peaks are written as interleaved m/z-int pairs in network byte order.
+         */
+        class MzXMLWriter : public MsWriter {
+        private:
+            bool _doublePrecision;
+            bool _zlib;
+            //! Offset of scanCount attribute in header.
+            size_t _scanCountOffset;
+
+            void _writeHeader(const Scan* firstScan) override;
+            void _writeFooter() override;
+            void _encodeScan(const Scan& scan, size_t index, std::string& out) const override;
+
+        public:
+            explicit MzXMLWriter(unsigned int nThread = 0, size_t batchSize = DEFAULT_BATCH_SIZE)
+                : MsWriter(nThread, batchSize) {
+                _doublePrecision = false;
+                _zlib = false;
+                _scanCountOffset = 0;
+            }
+            ~MzXMLWriter() override {
+                close();
+            }
+
+            //! Write peaks as 64 bit instead of 32 bit floats.
+            void setDoublePrecision(bool doublePrecision) {
+                _doublePrecision = doublePrecision;
+            }
+            //! zlib compress peaks.
+            void setZlib(bool zlib) {
+                _zlib = zlib;
+            }
+        };
+    }
+}
+
+#endif
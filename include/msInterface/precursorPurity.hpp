@@ -0,0 +1,107 @@
+//
+// precursorPurity.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef precursorPurity_hpp
+#define precursorPurity_hpp
+
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+#include <msInterface/chromatogram.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class PurityCalculator;
+        struct PurityResult;
+
+        //! Precursor purity of every MS2 scan in a run.
+        struct PurityResult {
+            //! Scan numbers of MS2 scans sorted by scan number.
+            std::vector<size_t> scanNum;
+            //! Scan number of parent MS1 scan. SCAN_INDEX_NOT_FOUND if the parent is not known.
+            std::vector<size_t> parentScan;
+            //! Fraction of intensity in isolation window from the precursor isotope envelope. 0 if the window is empty.
+            std::vector<double> purity;
+
+            void clear();
+            size_t size() const {
+                return scanNum.size();
+            }
+        };
+
+        /**
+         \brief Calculate the fraction of the intensity in the isolation window of MS2 scans which belongs to the precursor. <br>
+
+         For each MS2 scan, the peaks in the parent MS1 scan inside the isolation window are split into
+         peaks which match an isotope of the precursor, at precursor m/z + k * Deisotoper::C13_DIFF / charge for integer k,
+         and all other peaks. If the precursor charge is not known, only the precursor m/z itself is matched.
+         If the isolation window is not in the file, a window of the default width centered on the precursor m/z is used.
+
+         MS2 scans are grouped by parent scan so each MS1 scan is decoded only once. Groups are processed in parallel.
+
+         \code
+         PurityCalculator calculator(MZTolerance(10));
+         PurityResult result;
+         calculator.compute(msFile, result);
+         \endcode
+         */
+        class PurityCalculator {
+        private:
+            MZTolerance _tolerance;
+            //! Width of isolation window in m/z used when the window is not in the file.
+            double _isolationWidth;
+
+        public:
+            explicit PurityCalculator(const MZTolerance& tolerance = MZTolerance(10), double isolationWidth = 2.0) {
+                _tolerance = tolerance;
+                _isolationWidth = isolationWidth;
+            }
+
+            void setTolerance(const MZTolerance& tolerance) {
+                _tolerance = tolerance;
+            }
+            void setIsolationWidth(double isolationWidth) {
+                _isolationWidth = isolationWidth;
+            }
+            const MZTolerance& getTolerance() const {
+                return _tolerance;
+            }
+            double getIsolationWidth() const {
+                return _isolationWidth;
+            }
+
+            double purity(const Scan& ms1, double precursorMZ, int charge, double lower, double upper) const;
+            void compute(const MsInterface& file, PurityResult& result, unsigned int nThread = 0) const;
+            void compute(const MsInterface& file, const RunSummary& summary,
+                         PurityResult& result, unsigned int nThread = 0) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,154 @@
+//
+// reporterIons.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef reporterIons_hpp
+#define reporterIons_hpp
+
+#include <string>
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+#include <msInterface/chromatogram.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class ReporterIonExtractor;
+        struct ReporterChannel;
+        struct ReporterResult;
+
+        //! Name and m/z of one isobaric labeling reporter ion.
+        struct ReporterChannel {
+            std::string name;
+            double mz;
+
+            ReporterChannel(std::string _name = "", double _mz = 0) {
+                name = _name;
+                mz = _mz;
+            }
+        };
+
+        /**
+         \brief Reporter ion intensities for every scan at one MS level. <br>
+
+         Intensities are stored as a row major scan x channel matrix, so the intensity of channel c
+         in row r is intensity[r * channels.size() + c].
+         */
+        struct ReporterResult {
+            //! Scan numbers sorted by scan number.
+            std::vector<size_t> scanNum;
+            //! Channel names.
+            std::vector<std::string> channels;
+            //! Reporter intensities. 0 if no peak was found.
+            std::vector<double> intensity;
+
+            void clear();
+            //! Number of scans.
+            size_t size() const {
+                return scanNum.size();
+            }
+            double at(size_t row, size_t channel) const {
+                return intensity.at(row * channels.size() + channel);
+            }
+        };
+
+        /**
+         \brief Extract isobaric labeling reporter ion intensities from every MS2 or MS3 scan in a run. <br>
+
+         Only the m/z range spanning the reporter ions is read from each scan with MsInterface::getPeaksInRange,
+         so formats which support it skip decoding the rest of the peak arrays. Scans are processed in parallel.
+
+         Isotope impurity correction is optional. The observed intensities are modeled as A * x where
+         A[i][j] is the fraction of the signal of channel j observed in channel i. A is LU factorized once
+         and each scan is corrected by solving for x. Negative corrected intensities are set to 0.
+
+         \code
+         ReporterIonExtractor extractor(ReporterIonExtractor::Plex::TMT10);
+         ReporterResult result;
+         extractor.extract(msFile, result);
+         \endcode
+         */
+        class ReporterIonExtractor {
+        public:
+            enum class Plex {ITRAQ4, ITRAQ8, TMT6, TMT10, TMT11, TMTPRO16, TMTPRO18};
+
+        private:
+            std::vector<ReporterChannel> _channels;
+            MZTolerance _tolerance;
+            PeakSelect _peakSelect;
+            //! MS level of scans to extract.
+            int _msLevel;
+            //! LU factorization of impurity matrix, row major. Empty if impurity correction is disabled.
+            std::vector<double> _lu;
+            //! Row permutation of _lu.
+            std::vector<size_t> _pivot;
+
+            void _extractScan(const std::vector<double>& mz, const std::vector<double>& intensity, double* out) const;
+
+        public:
+            explicit ReporterIonExtractor(Plex plex = Plex::TMT10, const MZTolerance& tolerance = MZTolerance(10));
+            explicit ReporterIonExtractor(std::vector<ReporterChannel> channels, const MZTolerance& tolerance = MZTolerance(10));
+
+            static void getChannels(Plex plex, std::vector<ReporterChannel>& channels);
+
+            void setTolerance(const MZTolerance& tolerance) {
+                _tolerance = tolerance;
+            }
+            void setPeakSelect(PeakSelect peakSelect) {
+                _peakSelect = peakSelect;
+            }
+            void setMSLevel(int msLevel) {
+                _msLevel = msLevel;
+            }
+            const std::vector<ReporterChannel>& getChannels() const {
+                return _channels;
+            }
+            size_t size() const {
+                return _channels.size();
+            }
+
+            void setImpurityMatrix(const std::vector<double>& matrix);
+            void setImpurities(const std::vector<std::vector<double> >& impurities);
+            void disableImpurityCorrection() {
+                _lu.clear();
+                _pivot.clear();
+            }
+            //! true if impurity correction is enabled.
+            bool isCorrecting() const {
+                return !_lu.empty();
+            }
+            void correct(double* intensities) const;
+
+            void extract(const MsInterface& file, ReporterResult& result, unsigned int nThread = 0) const;
+            void extract(const MsInterface& file, const RunSummary& summary,
+                         ReporterResult& result, unsigned int nThread = 0) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+//
+// scanCache.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef scanCache_hpp
+#define scanCache_hpp
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class ScanCache;
+
+        /**
+         \brief Thread safe LRU cache of decoded Scan(s). <br>
+
+         The cache is split into shards by scan number so that concurrent readers
+         only contend when they hit the same shard. Each shard gets an equal share
+         of the total memory budget and evicts its least recently used scans once
+         the budget is exceeded.
+         */
+        class ScanCache {
+        public:
+            static size_t const DEFAULT_SHARDS = 16;
+
+        private:
+            struct Shard {
+                typedef std::list<std::pair<size_t, Scan> > ListType;
+                std::mutex mutex;
+                //! Cached scans. Most recently used scans are at the front.
+                ListType lru;
+                //! Maps scan numbers to position in Shard::lru
+                std::unordered_map<size_t, ListType::iterator> map;
+                //! Current memory usage of shard in bytes.
+                size_t bytes;
+                Shard() : bytes(0) {}
+            };
+
+            std::vector<std::unique_ptr<Shard> > _shards;
+            //! Total memory budget in bytes.
+            size_t _maxBytes;
+            //! Memory budget of each shard in bytes.
+            size_t _shardBytes;
+
+            std::atomic<size_t> _hits;
+            std::atomic<size_t> _misses;
+            std::atomic<size_t> _evictions;
+
+            Shard& _getShard(size_t scanNum) const {
+                return *_shards[scanNum % _shards.size()];
+            }
+
+        public:
+            explicit ScanCache(size_t maxBytes, size_t nShards = DEFAULT_SHARDS);
+            ScanCache(const ScanCache&) = delete;
+            ScanCache& operator = (const ScanCache&) = delete;
+
+            bool get(size_t scanNum, Scan& scan);
+            void insert(size_t scanNum, const Scan& scan);
+            void clear();
+
+            size_t size() const;
+            size_t getBytes() const;
+            size_t getMaxBytes() const {
+                return _maxBytes;
+            }
+            size_t getShardCount() const {
+                return _shards.size();
+            }
+            size_t getHits() const {
+                return _hits.load();
+            }
+            size_t getMisses() const {
+                return _misses.load();
+            }
+            size_t getEvictions() const {
+                return _evictions.load();
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,124 @@
+//
+// scanPrefetcher.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef scanPrefetcher_hpp
+#define scanPrefetcher_hpp
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class ScanPrefetcher;
+
+        /**
+         \brief Iterate through the scans in a MsInterface while the next scans are decoded on background threads. <br>
+
+         Decoded scans are stored in a ring buffer with room for a fixed number of scans,
+         so memory usage is bounded no matter how far the consumer falls behind.
+         Scans are always returned in the order they were requested.
+
+         \code
+         ScanPrefetcher prefetcher(msFile);
+         Scan scan;
+         while(prefetcher.next(scan)) {
+             // do something with scan
+         }
+         \endcode
+
+         An optional Transform can be given to process each scan on the decoding threads,
+         so per scan work such as ScanPreprocessor::process is done in parallel.
+         */
+        class ScanPrefetcher {
+        public:
+            static size_t const DEFAULT_AHEAD = 32;
+            //! Function applied to each scan on the decoding threads.
+            typedef std::function<void(Scan&)> Transform;
+
+        private:
+            enum class SlotState {EMPTY, DECODING, READY};
+            struct Slot {
+                Scan scan;
+                SlotState state;
+                //! Return value of MsInterface::getScan
+                bool found;
+                //! Exception thrown while decoding the scan.
+                std::exception_ptr error;
+                Slot() : state(SlotState::EMPTY), found(false) {}
+            };
+
+            const MsInterface& _file;
+            //! Optional function applied to each scan after it is decoded.
+            Transform _transform;
+            //! Scan numbers to iterate through
+            std::vector<size_t> _scans;
+            //! Ring buffer of decoded scans. Scan i is stored in _slots[i % _slots.size()]
+            std::vector<Slot> _slots;
+
+            //! Index in _scans of next scan to be decoded.
+            size_t _nextDecode;
+            //! Index in _scans of next scan to be returned by ScanPrefetcher::next
+            size_t _nextConsume;
+            bool _stop;
+
+            std::mutex _mutex;
+            std::condition_variable _slotFree;
+            std::condition_variable _slotReady;
+            std::vector<std::thread> _threads;
+
+            void _init(size_t nAhead, unsigned int nThread);
+            void _worker();
+
+        public:
+            explicit ScanPrefetcher(const MsInterface& file, size_t nAhead = DEFAULT_AHEAD, unsigned int nThread = 0);
+            ScanPrefetcher(const MsInterface& file, const std::vector<size_t>& scans,
+                           size_t nAhead = DEFAULT_AHEAD, unsigned int nThread = 0);
+            ScanPrefetcher(const MsInterface& file, Transform transform,
+                           size_t nAhead = DEFAULT_AHEAD, unsigned int nThread = 0);
+            ScanPrefetcher(const MsInterface& file, const std::vector<size_t>& scans, Transform transform,
+                           size_t nAhead = DEFAULT_AHEAD, unsigned int nThread = 0);
+            ScanPrefetcher(const ScanPrefetcher&) = delete;
+            ScanPrefetcher& operator = (const ScanPrefetcher&) = delete;
+            ~ScanPrefetcher();
+
+            bool next(Scan& scan);
+            //! Total number of scans which will be iterated through.
+            size_t size() const {
+                return _scans.size();
+            }
+        };
+    }
+}
+
+#endif
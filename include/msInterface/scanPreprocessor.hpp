@@ -0,0 +1,125 @@
+//
+// scanPreprocessor.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef scanPreprocessor_hpp
+#define scanPreprocessor_hpp
+
+#include <limits>
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class ScanPreprocessor;
+
+        /**
+         \brief Filter and normalize scan peaks in place before scoring. <br>
+
+         Stages are configured once and then applied to any number of scans with ScanPreprocessor::process.
+         Stages which are not configured are skipped. The m/z range clip, precursor removal and top N filter
+         are done together in one pass over the peaks, then the remaining peaks are normalized.
+         ScanPreprocessor::process is const, so one instance can be shared between threads.
+
+         \code
+         ScanPreprocessor preprocessor;
+         preprocessor.setTopN(10, 100);
+         preprocessor.setPrecursorRemoval(MZTolerance(0.5, MZTolerance::Unit::DA), {18.010565});
+         preprocessor.setNormalization(ScanPreprocessor::Normalization::SQRT);
+         ScanPrefetcher prefetcher(msFile, [&preprocessor](Scan& scan){ preprocessor.process(scan); });
+         \endcode
+         */
+        class ScanPreprocessor {
+        public:
+            //! Transformation applied to peak intensities after filtering.
+            enum class Normalization {
+                NONE,
+                SQRT, /**< Square root of intensity */
+                RANK /**< Rank of intensity divided by number of peaks. The most intense peak is 1. */
+            };
+
+        private:
+            double _minMZ, _maxMZ;
+            //! Maximum number of peaks to keep in each window. 0 to disable top N filter.
+            size_t _topN;
+            double _windowWidth;
+            bool _removePrecursor;
+            MZTolerance _precursorTolerance;
+            //! Neutral loss masses to remove from the precursor.
+            std::vector<double> _neutralLosses;
+            Normalization _normalization;
+
+            void _removalWindows(const Scan& scan, std::vector<std::pair<double, double> >& windows) const;
+
+        public:
+            ScanPreprocessor() {
+                _minMZ = -std::numeric_limits<double>::infinity();
+                _maxMZ = std::numeric_limits<double>::infinity();
+                _topN = 0;
+                _windowWidth = 100;
+                _removePrecursor = false;
+                _normalization = Normalization::NONE;
+            }
+
+            //! Only keep peaks with m/z in [\p minMZ, \p maxMZ].
+            void setMZRange(double minMZ, double maxMZ) {
+                _minMZ = minMZ;
+                _maxMZ = maxMZ;
+            }
+            /**
+             \brief Only keep the \p n most intense peaks in each m/z window.
+             \param n Number of peaks to keep per window. 0 disables the filter.
+             \param windowWidth Window width in m/z. Windows start at multiples of \p windowWidth.
+             */
+            void setTopN(size_t n, double windowWidth = 100) {
+                _topN = n;
+                _windowWidth = windowWidth;
+            }
+            /**
+             \brief Remove peaks at the precursor m/z and the m/z of precursor neutral losses.
+             \param tolerance Tolerance around each removed m/z.
+             \param neutralLosses Neutral loss masses. The m/z of each loss is calculated with the precursor charge.
+             */
+            void setPrecursorRemoval(const MZTolerance& tolerance, std::vector<double> neutralLosses = {}) {
+                _removePrecursor = true;
+                _precursorTolerance = tolerance;
+                _neutralLosses = std::move(neutralLosses);
+            }
+            void disablePrecursorRemoval() {
+                _removePrecursor = false;
+                _neutralLosses.clear();
+            }
+            void setNormalization(Normalization normalization) {
+                _normalization = normalization;
+            }
+
+            void process(Scan& scan) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+//
+// spectralSimilarity.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef spectralSimilarity_hpp
+#define spectralSimilarity_hpp
+
+#include <vector>
+
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class PreparedSpectrum;
+        class SimilarityQuery;
+        struct SimilarityScores;
+
+        //! Similarity scores between two spectra.
+        struct SimilarityScores {
+            //! Dot product of the raw intensities of matched peaks.
+            double dotProduct;
+            //! Cosine of the angle between the intensity vectors. In the range [0, 1].
+            double cosine;
+            //! 1 - 2 * acos(cosine) / pi. In the range [0, 1].
+            double spectralContrastAngle;
+            //! Unweighted spectral entropy similarity. (Li et al. Nat. Methods 2021) In the range [0, 1].
+            double entropy;
+            //! Number of aligned peak pairs.
+            size_t matchedPeaks;
+
+            SimilarityScores() {
+                dotProduct = 0;
+                cosine = 0;
+                spectralContrastAngle = 0;
+                entropy = 0;
+                matchedPeaks = 0;
+            }
+        };
+
+        /**
+         \brief Peaks of a spectrum sorted by m/z, with the normalized intensity vectors needed for
+         similarity scoring precomputed. <br>
+
+         Preparing a spectrum once and reusing it avoids sorting and normalizing it in every comparison.
+         */
+        class PreparedSpectrum {
+            friend SimilarityScores compareSpectra(const PreparedSpectrum&, const PreparedSpectrum&, const MZTolerance&);
+        private:
+            std::vector<double> _mz;
+            std::vector<double> _intensity;
+            //! Intensities divided by the L2 norm of the intensity vector.
+            std::vector<double> _unit;
+            //! Intensities divided by the sum of intensities.
+            std::vector<double> _probability;
+            //! _probability[i] * ln(_probability[i])
+            std::vector<double> _xLogX;
+
+            void _init();
+
+        public:
+            PreparedSpectrum() = default;
+            explicit PreparedSpectrum(const Scan& scan);
+            PreparedSpectrum(const double* mz, const double* intensity, size_t n);
+
+            size_t size() const {
+                return _mz.size();
+            }
+            const std::vector<double>& getMZ() const {
+                return _mz;
+            }
+            const std::vector<double>& getIntensity() const {
+                return _intensity;
+            }
+        };
+
+        SimilarityScores compareSpectra(const PreparedSpectrum& lhs, const PreparedSpectrum& rhs,
+                                        const MZTolerance& tolerance);
+        SimilarityScores compareSpectra(const Scan& lhs, const Scan& rhs, const MZTolerance& tolerance);
+
+        /**
+         \brief Compare one query spectrum to many spectra. <br>
+
+         The query is prepared once when the SimilarityQuery is constructed.
+
+         \code
+         SimilarityQuery query(scan, MZTolerance(0.02, MZTolerance::Unit::DA));
+         std::vector<SimilarityScores> scores;
+         query.compare(library, scores);
+         \endcode
+         */
+        class SimilarityQuery {
+        private:
+            PreparedSpectrum _query;
+            MZTolerance _tolerance;
+
+        public:
+            SimilarityQuery(const Scan& query, const MZTolerance& tolerance) : _query(query), _tolerance(tolerance) {}
+            SimilarityQuery(PreparedSpectrum query, const MZTolerance& tolerance)
+                    : _query(std::move(query)), _tolerance(tolerance) {}
+
+            SimilarityScores compare(const Scan& scan) const {
+                return compareSpectra(_query, PreparedSpectrum(scan), _tolerance);
+            }
+            SimilarityScores compare(const PreparedSpectrum& spectrum) const {
+                return compareSpectra(_query, spectrum, _tolerance);
+            }
+            void compare(const std::vector<Scan>& scans, std::vector<SimilarityScores>& scores,
+                         unsigned int nThread = 0) const;
+            void compare(const std::vector<PreparedSpectrum>& spectra, std::vector<SimilarityScores>& scores,
+                         unsigned int nThread = 0) const;
+
+            const PreparedSpectrum& getQuery() const {
+                return _query;
+            }
+            const MZTolerance& getTolerance() const {
+                return _tolerance;
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+//
+// spectrumBinner.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef spectrumBinner_hpp
+#define spectrumBinner_hpp
+
+#include <cstdint>
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/msScan.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class SpectrumBinner;
+        struct CsrMatrix;
+
+        //! Sparse matrix in compressed sparse row format.
+        struct CsrMatrix {
+            //! Offset of the first element of each row in indices and data. Has one more element than there are rows.
+            std::vector<size_t> indptr;
+            //! Column of each element.
+            std::vector<uint32_t> indices;
+            std::vector<float> data;
+            size_t nCols;
+
+            CsrMatrix() : nCols(0) {}
+            void clear() {
+                indptr.clear();
+                indices.clear();
+                data.clear();
+                nCols = 0;
+            }
+            size_t nRows() const {
+                return indptr.empty() ? 0 : indptr.size() - 1;
+            }
+        };
+
+        /**
+         \brief Convert spectra to fixed length vectors of binned intensities. <br>
+
+         Peak i is put into bin floor((mz_i - minMZ) / binWidth + offset). Peaks which fall outside of
+         [0, SpectrumBinner::size()) are dropped. The intensity transform is applied to each peak before
+         peaks in the same bin are combined.
+
+         \code
+         SpectrumBinner binner(0.02, 0, 100, 2000, SpectrumBinner::Transform::SQRT);
+         std::vector<size_t> scans;
+         msFile.getScanNumbers(scans);
+         std::vector<float> matrix(scans.size() * binner.size());
+         binner.binDense(msFile, scans, matrix.data());
+         \endcode
+         */
+        class SpectrumBinner {
+        public:
+            //! Transformation applied to peak intensities.
+            enum class Transform {NONE, SQRT, LOG1P};
+            //! How intensities of peaks in the same bin are combined.
+            enum class Aggregate {SUM, MAX};
+
+        private:
+            double _binWidth;
+            //! Offset of bin boundaries as a fraction of bin width.
+            double _offset;
+            double _minMZ;
+            double _maxMZ;
+            Transform _transform;
+            Aggregate _aggregate;
+            size_t _nBins;
+
+            float _transformIntensity(double intensity) const;
+
+        public:
+            explicit SpectrumBinner(double binWidth = 0.02, double offset = 0,
+                                    double minMZ = 0, double maxMZ = 2000,
+                                    Transform transform = Transform::NONE,
+                                    Aggregate aggregate = Aggregate::SUM);
+
+            //! Number of bins.
+            size_t size() const {
+                return _nBins;
+            }
+            //! Bin index of \p mz. May be out of range.
+            long binIndex(double mz) const;
+            //! Lower m/z bound of bin \p i.
+            double binLowerMZ(size_t i) const {
+                return _minMZ + ((double)i - _offset) * _binWidth;
+            }
+            double getBinWidth() const {
+                return _binWidth;
+            }
+            double getOffset() const {
+                return _offset;
+            }
+            double getMinMZ() const {
+                return _minMZ;
+            }
+            double getMaxMZ() const {
+                return _maxMZ;
+            }
+            Transform getTransform() const {
+                return _transform;
+            }
+            Aggregate getAggregate() const {
+                return _aggregate;
+            }
+
+            void binDense(const Scan& scan, float* out) const;
+            void binSparse(const Scan& scan, std::vector<uint32_t>& indices, std::vector<float>& values) const;
+            void binDense(const MsInterface& file, const std::vector<size_t>& scans, float* out,
+                          unsigned int nThread = 0) const;
+            void binSparse(const MsInterface& file, const std::vector<size_t>& scans, CsrMatrix& matrix,
+                           unsigned int nThread = 0) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+//
+// xicExtractor.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef xicExtractor_hpp
+#define xicExtractor_hpp
+
+#include <limits>
+#include <vector>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/chromatogram.hpp>
+
+namespace utils {
+    namespace msInterface {
+        class XicExtractor;
+        struct XicTarget;
+        struct XicResult;
+
+        //! An m/z window and retention time range to extract an ion chromatogram for.
+        struct XicTarget {
+            double mz;
+            //! m/z tolerance in parts per million.
+            double ppm;
+            //! Retention time range in seconds.
+            double rtMin, rtMax;
+
+            XicTarget(double _mz = 0, double _ppm = 10,
+                      double _rtMin = -std::numeric_limits<double>::infinity(),
+                      double _rtMax = std::numeric_limits<double>::infinity()) {
+                mz = _mz;
+                ppm = _ppm;
+                rtMin = _rtMin;
+                rtMax = _rtMax;
+            }
+        };
+
+        /**
+         \brief Extracted ion chromatograms for a set of XicTarget(s). <br>
+
+         The MS1 scans in the run are sorted by retention time. The scans inside the retention time
+         range of a target are contiguous, so the chromatogram of target t is stored as
+         intensity[targetOffsets[t]] to intensity[targetOffsets[t + 1] - 1] for MS1 scans
+         firstScan[t], firstScan[t] + 1, ...
+         */
+        struct XicResult {
+            //! Scan numbers of MS1 scans sorted by retention time.
+            std::vector<size_t> scanNum;
+            //! Retention time of each MS1 scan in seconds.
+            std::vector<double> rt;
+            //! Offset of each target in intensity. Has one more element than there are targets.
+            std::vector<size_t> targetOffsets;
+            //! Index in scanNum of first scan in retention time range of each target.
+            std::vector<size_t> firstScan;
+            //! Summed intensity of peaks in each target m/z window. 0 if no peaks were found.
+            std::vector<double> intensity;
+
+            void clear();
+            //! Number of targets.
+            size_t size() const {
+                return firstScan.size();
+            }
+            void getXic(size_t target, Chromatogram& chromatogram) const;
+        };
+
+        /**
+         \brief Extract ion chromatograms for many targets in a single pass over the MS1 scans in a run. <br>
+
+         Targets are sorted by m/z once, then each MS1 scan is decoded one time and merge joined
+         against the targets whose retention time range contains the scan.
+         Scans are processed in parallel.
+
+         \code
+         XicExtractor extractor;
+         extractor.addTarget(XicTarget(524.2648, 10, 1200, 1500));
+         XicResult result;
+         extractor.extract(msFile, result);
+         \endcode
+         */
+        class XicExtractor {
+        private:
+            std::vector<XicTarget> _targets;
+
+        public:
+            XicExtractor() = default;
+            explicit XicExtractor(std::vector<XicTarget> targets) : _targets(std::move(targets)) {}
+
+            //! Add \p target and return its index in XicResult.
+            size_t addTarget(const XicTarget& target) {
+                _targets.push_back(target);
+                return _targets.size() - 1;
+            }
+            void clear() {
+                _targets.clear();
+            }
+            const std::vector<XicTarget>& getTargets() const {
+                return _targets;
+            }
+            size_t size() const {
+                return _targets.size();
+            }
+
+            void extract(const MsInterface& file, XicResult& result, unsigned int nThread = 0) const;
+            void extract(const MsInterface& file, const RunSummary& summary,
+                         XicResult& result, unsigned int nThread = 0) const;
+        };
+    }
+}
+
+#endif
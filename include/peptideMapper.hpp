@@ -0,0 +1,143 @@
+//
+// peptideMapper.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef peptideMapper_hpp
+#define peptideMapper_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include <stringView.hpp>
+#include <fastaFile.hpp>
+
+namespace utils {
+    class PeptideMapper;
+
+    //! Location of a peptide in a protein.
+    struct PeptideHit {
+        //! Index of peptide in the list given to PeptideMapper.
+        size_t peptide;
+        //! Index of protein in FastaFile.
+        size_t protein;
+        //! 0 based offset of first peptide residue in protein sequence.
+        size_t start;
+
+        PeptideHit(size_t _peptide = 0, size_t _protein = 0, size_t _start = 0)
+            : peptide(_peptide), protein(_protein), start(_start) {}
+        bool operator == (const PeptideHit& rhs) const {
+            return peptide == rhs.peptide && protein == rhs.protein && start == rhs.start;
+        }
+        bool operator < (const PeptideHit& rhs) const {
+            if(protein != rhs.protein) return protein < rhs.protein;
+            if(start != rhs.start) return start < rhs.start;
+            return peptide < rhs.peptide;
+        }
+    };
+
+    /**
+     \brief Find every occurrence of a set of peptides in every protein with an Aho-Corasick automaton. <br>
+
+     The automaton is built once from the peptides, then each protein sequence is scanned a single time,
+     so mapping takes time proportional to the size of the proteome plus the number of hits
+     instead of peptides × proteins calls to \p std::string::find.
+
+     States are numbered in breadth first order and stored in flat arrays.
+     The children of each state are contiguous, so a transition is a short scan of one cache line,
+     and the root has a dense transition table since most lookups start there.
+     The automaton is not modified after it is built, so PeptideMapper::map is const and thread safe.
+
+     \code
+     PeptideMapper mapper(peptides, true);
+     std::vector<PeptideHit> hits;
+     mapper.map(fasta, hits);
+     \endcode
+     */
+    class PeptideMapper {
+    public:
+        typedef std::vector<PeptideHit> HitListType;
+        static uint32_t const NONE = UINT32_MAX;
+        static uint32_t const ROOT = 0;
+        //! Number of symbols in automaton alphabet. (A-Z)
+        static int const ALPHABET_SIZE = 26;
+
+    private:
+        //! Alphabet code of each character or -1 for characters which are not residues.
+        int8_t _code[256];
+        bool _ilEquivalent;
+
+        //! Index of first child of each state. Children of state s are [_firstChild[s], _firstChild[s + 1])
+        std::vector<uint32_t> _firstChild;
+        //! Alphabet code of the edge into each state.
+        std::vector<uint8_t> _label;
+        //! Longest proper suffix of each state which is also a state.
+        std::vector<uint32_t> _fail;
+        //! Nearest state on failure chain with outputs or NONE.
+        std::vector<uint32_t> _dictLink;
+        //! Peptides ending at state s are _outputs[_outputBegin[s]] to _outputs[_outputBegin[s + 1] - 1]
+        std::vector<uint32_t> _outputBegin;
+        std::vector<uint32_t> _outputs;
+        //! Transitions from root for each alphabet code.
+        uint32_t _rootNext[ALPHABET_SIZE];
+        //! Length of each peptide.
+        std::vector<uint32_t> _lengths;
+
+        void _initAlphabet();
+        uint32_t _child(uint32_t state, uint8_t c) const;
+        uint32_t _next(uint32_t state, uint8_t c) const;
+        bool _hasOutputs(uint32_t state) const {
+            return _outputBegin[state] != _outputBegin[state + 1];
+        }
+
+    public:
+        explicit PeptideMapper(bool ilEquivalent = false);
+        PeptideMapper(const std::vector<std::string>& peptides, bool ilEquivalent = false);
+
+        void build(const std::vector<std::string>& peptides);
+
+        void map(StringView sequence, size_t protein, HitListType& hits) const;
+        void map(const FastaFile& fasta, HitListType& hits, unsigned int nThread = 0) const;
+
+        //! Number of peptides in automaton.
+        size_t size() const {
+            return _lengths.size();
+        }
+        //! Number of states in automaton.
+        size_t stateCount() const {
+            return _label.size();
+        }
+        bool getILEquivalent() const {
+            return _ilEquivalent;
+        }
+    };
+}
+
+#endif
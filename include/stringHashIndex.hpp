@@ -0,0 +1,97 @@
+//
+// stringHashIndex.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef stringHashIndex_hpp
+#define stringHashIndex_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <stringView.hpp>
+
+namespace utils {
+    class StringHashIndex;
+
+    /**
+     \brief Open addressing hash table mapping strings to integer values. <br>
+
+     Key characters are copied into a single arena owned by the index, and slots store the offset and length
+     of their key, so the table is made of two contiguous allocations no matter how many keys it holds.
+     Lookups take a StringView, \p const \p char* or \p std::string without allocating.
+     Collisions are resolved with linear probing and the table is kept at most half full.
+     */
+    class StringHashIndex {
+    public:
+        static size_t const NOT_FOUND = std::string::npos;
+
+    private:
+        struct Slot {
+            uint64_t hash;
+            size_t keyOffset;
+            size_t keyLength;
+            //! NOT_FOUND if the slot is empty.
+            size_t value;
+            Slot() : hash(0), keyOffset(0), keyLength(0), value(NOT_FOUND) {}
+        };
+
+        //! Characters of every key.
+        std::string _keys;
+        //! Size is always 0 or a power of 2.
+        std::vector<Slot> _slots;
+        size_t _size;
+
+        void _rehash(size_t capacity);
+        size_t _findSlot(StringView key, uint64_t hash) const;
+
+    public:
+        StringHashIndex() : _size(0) {}
+
+        static uint64_t hash(StringView key);
+
+        bool insert(StringView key, size_t value);
+        size_t find(StringView key) const;
+        size_t find(const char* key, size_t length) const {
+            return find(StringView(key, length));
+        }
+        bool contains(StringView key) const {
+            return find(key) != NOT_FOUND;
+        }
+
+        void reserve(size_t n, size_t keyBytes = 0);
+        void clear();
+        size_t size() const {
+            return _size;
+        }
+        bool empty() const {
+            return _size == 0;
+        }
+    };
+}
+
+#endif
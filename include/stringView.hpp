@@ -0,0 +1,139 @@
+//
+// stringView.hpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#ifndef stringView_hpp
+#define stringView_hpp
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace utils {
+    class StringView;
+
+    /**
+     \brief Non owning, read only view of a contiguous sequence of characters. <br>
+
+     A subset of \p std::string_view for C++11. The viewed characters must outlive the view.
+     Views implicitly convert to \p std::string, which makes a copy.
+     */
+    class StringView {
+    public:
+        typedef const char* const_iterator;
+        typedef const_iterator iterator;
+        static size_t const npos = std::string::npos;
+
+    private:
+        const char* _data;
+        size_t _size;
+
+    public:
+        StringView() : _data(""), _size(0) {}
+        StringView(const char* data, size_t size) : _data(data), _size(size) {}
+        StringView(const char* str) : _data(str), _size(strlen(str)) {}
+        StringView(const std::string& str) : _data(str.data()), _size(str.size()) {}
+
+        const_iterator begin() const {
+            return _data;
+        }
+        const_iterator end() const {
+            return _data + _size;
+        }
+        const char* data() const {
+            return _data;
+        }
+        size_t size() const {
+            return _size;
+        }
+        size_t length() const {
+            return _size;
+        }
+        bool empty() const {
+            return _size == 0;
+        }
+        char operator[](size_t i) const {
+            return _data[i];
+        }
+        //! \throws std::out_of_range if \p i >= size()
+        char at(size_t i) const {
+            if(i >= _size) throw std::out_of_range("StringView index out of range!");
+            return _data[i];
+        }
+        char front() const {
+            return _data[0];
+        }
+        char back() const {
+            return _data[_size - 1];
+        }
+
+        //! \throws std::out_of_range if \p pos > size()
+        StringView substr(size_t pos, size_t n = npos) const {
+            if(pos > _size) throw std::out_of_range("StringView substr position out of range!");
+            return StringView(_data + pos, std::min(n, _size - pos));
+        }
+        size_t find(char c, size_t pos = 0) const {
+            if(pos >= _size) return npos;
+            const void* match = memchr(_data + pos, c, _size - pos);
+            return match == nullptr ? npos : (const char*)match - _data;
+        }
+        size_t find(StringView str, size_t pos = 0) const {
+            if(pos > _size || str._size > _size - pos) return npos;
+            const char* match = std::search(_data + pos, end(), str.begin(), str.end());
+            return match == end() && !str.empty() ? npos : match - _data;
+        }
+        int compare(StringView rhs) const {
+            int ret = memcmp(_data, rhs._data, std::min(_size, rhs._size));
+            if(ret != 0) return ret;
+            return _size < rhs._size ? -1 : (_size > rhs._size ? 1 : 0);
+        }
+
+        std::string str() const {
+            return std::string(_data, _size);
+        }
+        operator std::string() const {
+            return str();
+        }
+    };
+
+    inline bool operator == (StringView lhs, StringView rhs) {
+        return lhs.size() == rhs.size() && memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+    }
+    inline bool operator != (StringView lhs, StringView rhs) {
+        return !(lhs == rhs);
+    }
+    inline bool operator < (StringView lhs, StringView rhs) {
+        return lhs.compare(rhs) < 0;
+    }
+    inline std::ostream& operator << (std::ostream& out, StringView str) {
+        return out.write(str.data(), str.size());
+    }
+}
+
+#endif
@@ -129,6 +129,8 @@ namespace utils{
     size_t offset(const char* buf, size_t len, std::string s);
     void removeEmptyStrings(std::vector<std::string>&);
     void getIdxOfSubstr(char*, const char*, std::vector<size_t>&);
+    const char* parseDouble(const char* begin, const char* end, double& value);
+    const char* parseLong(const char* begin, const char* end, long& value);
     std::string toSubscript(int);
     void addChar(const std::string& toAdd, std::string& s, const std::string& delim = "|");
     void addChar(char toAdd, std::string& s, const std::string& delim = "|");
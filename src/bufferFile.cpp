@@ -24,6 +24,13 @@
 // -----------------------------------------------------------------------------
 // 
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <bufferFile.hpp>
 
 /**
@@ -34,7 +41,10 @@ utils::BufferFile::BufferFile(std::string fname)
 {
     _fname = fname;
     _size = 0;
-    _buffer = new char[_size];
+    _useMmap = false;
+    _mappedSize = 0;
+    _buffer = new char[1];
+    _buffer[0] = '\0';
 }
 
 /**
@@ -43,13 +53,16 @@ utils::BufferFile::BufferFile(std::string fname)
  */
 utils::BufferFile::BufferFile(const utils::BufferFile& rhs)
 {
-    //copy buffer
-    _buffer = new char[rhs._size];
+    //copy buffer. Terminated like the buffers from utils::readBuffer and BufferFile::_mapBuffer
+    _buffer = new char[rhs._size + 1];
     std::copy(rhs._buffer, rhs._buffer + rhs._size, _buffer);
+    _buffer[rhs._size] = '\0';
     
     //other vars
     _fname = rhs._fname;
     _size = rhs._size;
+    _useMmap = rhs._useMmap;
+    _mappedSize = 0;
 }
 
 /**
@@ -59,10 +72,12 @@ utils::BufferFile::BufferFile(const utils::BufferFile& rhs)
 utils::BufferFile& utils::BufferFile::operator = (utils::BufferFile rhs)
 {
     std::swap(_buffer, rhs._buffer);
+    std::swap(_mappedSize, rhs._mappedSize);
     
     //other vars
     _fname = rhs._fname;
     _size = rhs._size;
+    _useMmap = rhs._useMmap;
     return *this;
 }
 
@@ -87,8 +102,96 @@ bool utils::BufferFile::read()
     std::ifstream inF(_fname);
     if(!inF) return false;
     
+    _freeBuffer();
+    if(_useMmap)
+        return _mapBuffer();
+    utils::readBuffer(_fname, &_buffer, _size);
+    return true;
+}
+
+/**
+ \brief Memory map FileBuffer::_fname into FileBuffer::_buffer. <br>
+
+ The mapping is one byte longer than the file and the extra byte is always 0,
+ so the buffer can safely be searched with the c string functions.
+ The mapping is private, so writes to the buffer are never written back to the file.
+ Memory mapping is not supported on Windows, where the file is read into memory with utils::readBuffer.
+ \return true if successful
+ */
+bool utils::BufferFile::_mapBuffer()
+{
+#ifdef _WIN32
     utils::readBuffer(_fname, &_buffer, _size);
     return true;
+#else
+    int fd = open(_fname.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st{};
+    if(fstat(fd, &st) != 0){
+        close(fd);
+        return false;
+    }
+
+    // Reserve an anonymous (zero filled) region one byte longer than the file and map the file over it.
+    size_t fileSize = st.st_size;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t mapLen = ((fileSize + 1 + pageSize - 1) / pageSize) * pageSize;
+    void* base = mmap(nullptr, mapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED){
+        close(fd);
+        return false;
+    }
+    if(fileSize > 0 &&
+       mmap(base, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED){
+        munmap(base, mapLen);
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    _buffer = (char*)base;
+    _size = fileSize;
+    _mappedSize = mapLen;
+    return true;
+#endif
+}
+
+//! Free or unmap BufferFile::_buffer.
+void utils::BufferFile::_freeBuffer()
+{
+#ifndef _WIN32
+    if(_mappedSize != 0)
+        munmap(_buffer, _mappedSize);
+    else delete [] _buffer;
+#else
+    delete [] _buffer;
+#endif
+    _buffer = nullptr;
+    _mappedSize = 0;
+    _size = 0;
+}
+
+/**
+ \brief Tell the OS that bytes \p offset to \p offset + \p len of the buffer will be read soon. <br>
+
+ Has no effect unless the buffer is memory mapped, so it does nothing on Windows.
+ \param offset Offset in buffer.
+ \param len Number of bytes.
+ */
+void utils::BufferFile::adviseWillNeed(size_t offset, size_t len) const
+{
+#ifndef _WIN32
+    if(_mappedSize == 0 || offset >= (size_t)_size) return;
+    if(offset + len > (size_t)_size) len = _size - offset;
+
+    // madvise requires a page aligned address
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t begin = offset - (offset % pageSize);
+    madvise(_buffer + begin, len + (offset - begin), MADV_WILLNEED);
+#else
+    (void)offset;
+    (void)len;
+#endif
 }
 
 /**
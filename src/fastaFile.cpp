@@ -24,6 +24,10 @@
 // -----------------------------------------------------------------------------
 //
 
+#include <memory>
+#include <regex>
+#include <thread>
+
 #include <fastaFile.hpp>
 
 /**
@@ -57,55 +61,287 @@ utils::FastaEntry& utils::FastaEntry::operator = (const FastaEntry& rhs)
 /**
 \brief Return protein sequence at index \p i. <br>
 
-If i > _sequences.size(), an empty string is returned.
+If i > getSequenceCount(), an empty view is returned.
+The view is valid until the FastaFile is destroyed or read again.
 
+\throws std::logic_error if sequences are stored in PACKED_5BIT mode.
 \return Protein sequence
 */
-std::string utils::FastaFile::operator [](size_t i) const
+utils::StringView utils::FastaFile::operator [](size_t i) const
 {
-    if(i >= _sequences.size())
-        return "";
-    return _sequences[i];
+    if(_storage == Storage::PACKED_5BIT)
+        throw std::logic_error("Packed sequences must be decoded with FastaFile::getSequence(size_t, std::string&)");
+    if(i >= _sequenceIndex.size())
+        return StringView();
+    return StringView(_residues.data() + _sequenceIndex[i].first, _sequenceIndex[i].second);
 }
 
 /**
 \brief Return protein sequence at index \p i.
 
 \throws std::out_of_range if \p i not in _indexOffsets.
+\throws std::logic_error if sequences are stored in PACKED_5BIT mode.
+Use FastaFile::getSequence(size_t, std::string&) instead, which works in every storage mode.
 \return Protein sequence
 */
-std::string utils::FastaFile::at(size_t i) const
+utils::StringView utils::FastaFile::at(size_t i) const
 {
-    std::string ret = (*this)[i];
+    StringView ret = (*this)[i];
     if(ret.empty())
         throw std::out_of_range("Protein index does not exist!");
     return ret;
 }
 
+size_t const utils::FastaFile::RESIDUES_PER_WORD;
+
+namespace {
+    //! Residue codes and SWAR constants for FastaFile::Storage::PACKED_5BIT
+    struct PackedAlphabet {
+        uint8_t encode[256];
+        char decode[32];
+        //! Lowest bit of each 5 bit lane.
+        uint64_t low;
+        //! Highest bit of each 5 bit lane.
+        uint64_t high;
+        //! Lower 4 bits of each 5 bit lane.
+        uint64_t lowBits;
+
+        PackedAlphabet() {
+            std::fill(decode, decode + 32, 'X');
+            for(int c = 0; c < 26; c++)
+                decode[c + 1] = (char)('A' + c);
+            decode[27] = '*';
+            decode[28] = '-';
+            std::fill(encode, encode + 256, (uint8_t)('X' - 'A' + 1));
+            for(int c = 1; c < 29; c++) {
+                encode[(unsigned char)decode[c]] = (uint8_t)c;
+                encode[(unsigned char)tolower(decode[c])] = (uint8_t)c;
+            }
+
+            low = 0;
+            for(size_t lane = 0; lane < utils::FastaFile::RESIDUES_PER_WORD; lane++)
+                low |= (uint64_t)1 << (5 * lane);
+            high = low << 4;
+            lowBits = high - low;
+        }
+
+        //! Set the high bit of every lane of \p x which is 0.
+        uint64_t zeroLanes(uint64_t x) const {
+            return ~(((x & lowBits) + lowBits) | x | lowBits) & high;
+        }
+    };
+
+    PackedAlphabet const packedAlphabet;
+}
+
+void utils::FastaFile::_appendResidues(const char* begin, size_t len)
+{
+    if(_storage != Storage::PACKED_5BIT) {
+        _residues.append(begin, len);
+        return;
+    }
+    for(size_t i = 0; i < len; i++) {
+        size_t lane = _packedSize % RESIDUES_PER_WORD;
+        if(lane == 0) _packed.push_back(0);
+        _packed.back() |= (uint64_t)packedAlphabet.encode[(unsigned char)begin[i]] << (5 * lane);
+        _packedSize++;
+    }
+}
+
+/**
+ \brief Get protein sequence at index \p index in any storage mode.
+ \param index Index of protein.
+ \param buffer Used to store the decoded sequence in PACKED_5BIT mode.
+ \return Protein sequence or an empty view if \p index does not exist.
+ The view is valid until \p buffer is modified or the FastaFile is read again.
+ */
+utils::StringView utils::FastaFile::getSequence(size_t index, std::string& buffer) const
+{
+    if(index >= _sequenceIndex.size())
+        return StringView();
+    if(_storage != Storage::PACKED_5BIT)
+        return (*this)[index];
+
+    size_t offset = _sequenceIndex[index].first;
+    size_t len = _sequenceIndex[index].second;
+    buffer.resize(len);
+    for(size_t i = 0; i < len;) {
+        size_t lane = (offset + i) % RESIDUES_PER_WORD;
+        uint64_t word = _packed[(offset + i) / RESIDUES_PER_WORD] >> (5 * lane);
+        for(; lane < RESIDUES_PER_WORD && i < len; lane++, i++) {
+            buffer[i] = packedAlphabet.decode[word & 31];
+            word >>= 5;
+        }
+    }
+    return StringView(buffer.data(), len);
+}
+
+//! Length of protein sequence at \p index or 0 if \p index does not exist.
+size_t utils::FastaFile::getSequenceLength(size_t index) const
+{
+    return index < _sequenceIndex.size() ? _sequenceIndex[index].second : 0;
+}
+
+/**
+ \brief Call \p callback with the offset of every packed residue from \p begin to \p end which has one of \p codes. <br>
+
+ Each word is compared to all 12 residues at once, so words without a match are skipped in a few instructions.
+ \p callback returns false to stop the scan.
+ */
+template<typename Callback>
+void utils::FastaFile::_scanPacked(size_t begin, size_t end, const std::vector<uint8_t>& codes, Callback callback) const
+{
+    if(begin >= end || codes.empty()) return;
+    size_t firstWord = begin / RESIDUES_PER_WORD;
+    size_t lastWord = (end - 1) / RESIDUES_PER_WORD;
+    for(size_t w = firstWord; w <= lastWord; w++) {
+        uint64_t match = 0;
+        for(uint8_t code: codes)
+            match |= packedAlphabet.zeroLanes(_packed[w] ^ (code * packedAlphabet.low));
+        if(match == 0) continue;
+
+        size_t beginLane = w == firstWord ? begin % RESIDUES_PER_WORD : 0;
+        size_t endLane = w == lastWord ? (end - 1) % RESIDUES_PER_WORD + 1 : RESIDUES_PER_WORD;
+        for(size_t lane = beginLane; lane < endLane; lane++) {
+            if((match >> (5 * lane + 4)) & 1) {
+                if(!callback(w * RESIDUES_PER_WORD + lane)) return;
+            }
+        }
+    }
+}
+
+/**
+ \brief Find every position of \p residues in protein \p index, such as the cleavage sites of an enzyme. <br>
+
+ Residues are compared by their PACKED_5BIT code in every storage mode, so matching is case insensitive
+ and characters other than A-Z, '*' and '-' are all equal to 'X'.
+ In PACKED_5BIT mode the packed words are scanned directly without decoding the sequence.
+ \param index Index of protein.
+ \param residues Residues to search for.
+ \param positions Populated with sorted 0 based offsets in protein sequence.
+ */
+void utils::FastaFile::findResidues(size_t index, const std::string& residues, std::vector<size_t>& positions) const
+{
+    positions.clear();
+    if(index >= _sequenceIndex.size()) return;
+    size_t offset = _sequenceIndex[index].first;
+    size_t len = _sequenceIndex[index].second;
+
+    std::vector<uint8_t> codes;
+    for(char c: residues) {
+        uint8_t code = packedAlphabet.encode[(unsigned char)c];
+        if(std::find(codes.begin(), codes.end(), code) == codes.end())
+            codes.push_back(code);
+    }
+
+    if(_storage != Storage::PACKED_5BIT) {
+        bool isResidue[256] = {false};
+        for(int c = 0; c < 256; c++)
+            isResidue[c] = std::find(codes.begin(), codes.end(), packedAlphabet.encode[c]) != codes.end();
+        const char* seq = _residues.data() + offset;
+        for(size_t i = 0; i < len; i++)
+            if(isResidue[(unsigned char)seq[i]]) positions.push_back(i);
+        return;
+    }
+
+    _scanPacked(offset, offset + len, codes, [&positions, offset](size_t pos) {
+        positions.push_back(pos - offset);
+        return true;
+    });
+}
+
+/**
+ \brief Find the first occurrence of \p query in protein \p index at or after \p pos. <br>
+
+ Residues are compared by their PACKED_5BIT code in every storage mode, so matching is case insensitive
+ and characters other than A-Z, '*' and '-' are all equal to 'X'.
+ In PACKED_5BIT mode candidate positions of the first residue are found by scanning the packed words
+ and the rest of \p query is compared code by code, so the sequence is never decoded.
+ \param index Index of protein.
+ \param query Sequence to search for.
+ \param pos Offset in protein to start searching from.
+ \return 0 based offset of \p query in protein sequence or std::string::npos if it is not found.
+ */
+size_t utils::FastaFile::findInSequence(size_t index, StringView query, size_t pos) const
+{
+    if(index >= _sequenceIndex.size()) return std::string::npos;
+    size_t offset = _sequenceIndex[index].first;
+    size_t len = _sequenceIndex[index].second;
+    if(pos > len || query.size() > len - pos) return std::string::npos;
+    if(query.empty()) return pos;
+
+    std::vector<uint8_t> codes(query.size());
+    for(size_t i = 0; i < query.size(); i++)
+        codes[i] = packedAlphabet.encode[(unsigned char)query[i]];
+    if(_storage != Storage::PACKED_5BIT) {
+        const auto* seq = (const unsigned char*)_residues.data() + offset;
+        for(size_t candidate = pos; candidate + codes.size() <= len; candidate++) {
+            size_t i = 0;
+            while(i < codes.size() && packedAlphabet.encode[seq[candidate + i]] == codes[i]) i++;
+            if(i == codes.size()) return candidate;
+        }
+        return std::string::npos;
+    }
+    size_t ret = std::string::npos;
+    _scanPacked(offset + pos, offset + len - codes.size() + 1, std::vector<uint8_t>(1, codes[0]),
+                [this, &codes, &ret, offset](size_t candidate) {
+        for(size_t i = 1; i < codes.size(); i++)
+            if(_packedCode(candidate + i) != codes[i]) return true;
+        ret = candidate - offset;
+        return false;
+    });
+    return ret;
+}
+
 //!Copy FastaFile members from \p rhs. Should not be called directly.
 void utils::FastaFile::_copyValues(const FastaFile& rhs)
 {
     _indexOffsets = rhs._indexOffsets;
     _idIndex = rhs._idIndex;
-    _foundSequences = rhs._foundSequences;
-    _sequences = rhs._sequences;
+    _idKeys = rhs._idKeys;
+    _idExtractor = rhs._idExtractor;
+    _storage = rhs._storage;
+    _packed = rhs._packed;
+    _packedSize = rhs._packedSize;
+    _residues = rhs._residues;
+    _sequenceIndex = rhs._sequenceIndex;
     _sequenceCount = rhs._sequenceCount;
-    _storeFound = rhs._storeFound;
 }
 
 /**
  \brief Get integer index of \p proteinID in IndexMapType <br>
 
+ \p proteinID can be any of the keys selected with FastaFile::setIdKeys.
+ The lookup does not allocate.
  If \p proteinID is not found, utils::PROT_ID_NOT_FOUND is returned.
  \param proteinID Protein identifier in fasta file to lookup.
  \return Index of \p proteinID.
 */
-size_t utils::FastaFile::getIdIndex(std::string proteinID) const
+size_t utils::FastaFile::getIdIndex(StringView proteinID) const
 {
-    auto it = _idIndex.find(proteinID);
-    if(it == _idIndex.end())
+    size_t ret = _idIndex.find(proteinID);
+    if(ret == StringHashIndex::NOT_FOUND)
         return PROT_ID_NOT_FOUND;
-    return it->second;
+    return ret;
+}
+
+/**
+ \brief Get header line of entry \p i.
+ \param i Index of entry.
+ \return Header without the leading '>' or line ending.
+ Empty if \p i does not exist or the file buffer was released by the storage mode.
+ */
+utils::StringView utils::FastaFile::getHeader(size_t i) const
+{
+    if(i >= _indexOffsets.size() || _size == 0)
+        return StringView();
+    const char* begin = _buffer + _indexOffsets[i].getBeg() + 1;
+    const char* end = _buffer + _indexOffsets[i].getEnd();
+    const char* lineEnd = (const char*)memchr(begin, '\n', end - begin);
+    if(lineEnd == nullptr) lineEnd = end;
+    while(lineEnd > begin && lineEnd[-1] == '\r')
+        --lineEnd;
+    return StringView(begin, lineEnd - begin);
 }
 
 std::string utils::FastaFile::getIndexID(size_t i) const
@@ -121,8 +357,10 @@ std::string utils::FastaFile::getIndexID(size_t i) const
  \param verbose Should details of ids not found be printed to std::cerr?
  \return If found, parent protein sequence. If protein sequence is not found returns
  utils::PROT_SEQ_NOT_FOUND.
+ \throws std::logic_error if \p proteinID is found and sequences are stored in PACKED_5BIT mode.
+ Use FastaFile::getIdIndex with FastaFile::getSequence(size_t, std::string&) instead, which works in every storage mode.
  */
-std::string utils::FastaFile::getSequence(std::string proteinID, bool verbose) const
+utils::StringView utils::FastaFile::getSequence(StringView proteinID, bool verbose) const
 {
     //get offset of proteinID
     size_t proteinIndex_temp = getIdIndex(proteinID);
@@ -137,42 +375,22 @@ std::string utils::FastaFile::getSequence(std::string proteinID, bool verbose) c
 }
 
 /**
- \brief Search for \p proteinID in FastaFile::_buffer and extract protein sequence.
- \param proteinID uniprot ID of protein to search for.
+ \brief Get sequence of \p proteinID in any storage mode.
+ \param proteinID ID of protein to search for.
+ \param buffer Used to store the decoded sequence in PACKED_5BIT mode.
  \param verbose Should details of ids not found be printed to std::cerr?
- \return If found, parent protein sequence. If protein sequence is not found returns
- utils::PROT_SEQ_NOT_FOUND.
+ \return If found, parent protein sequence. Otherwise utils::PROT_SEQ_NOT_FOUND.
  */
-std::string utils::FastaFile::getSequence(std::string proteinID, bool verbose)
+utils::StringView utils::FastaFile::_getSequence(StringView proteinID, std::string& buffer, bool verbose) const
 {
-    if(_storeFound){
-        //if proteinID has already been parsed, return the seq and exit
-        auto foundIt = _foundSequences.find(proteinID);
-        if(foundIt != _foundSequences.end())
-            return foundIt->second;
-    }
-
-    //get offset of proteinID
-    size_t proteinIndex_temp = getIdIndex(proteinID);
-    if(proteinIndex_temp == utils::PROT_ID_NOT_FOUND){
+    size_t index = getIdIndex(proteinID);
+    if(index == utils::PROT_ID_NOT_FOUND){
         if(verbose){
             std::cerr << "Warning! ID: " << proteinID << " not found in fastaFile.\n";
         }
         return utils::PROT_SEQ_NOT_FOUND;
     }
-
-    std::string seq = (*this)[proteinIndex_temp];
-    _foundSequences[proteinID] = seq;
-    return seq;
-}
-
-//! const overloaded version of FastaFile::getModifiedResidue
-std::string utils::FastaFile::getModifiedResidue(std::string proteinID,
-                                                 std::string peptideSeq,
-                                                 int modLoc) const
-{
-    std::string seq = getSequence(proteinID);
-    return utils::getModifiedResidue(seq, peptideSeq, modLoc);
+    return getSequence(index, buffer);
 }
 
 /**
@@ -185,10 +403,10 @@ std::string utils::FastaFile::getModifiedResidue(std::string proteinID,
  */
 std::string utils::FastaFile::getModifiedResidue(std::string proteinID,
                                                  std::string peptideSeq,
-                                                 int modLoc)
+                                                 int modLoc) const
 {
-    std::string seq = getSequence(proteinID);
-    return utils::getModifiedResidue(seq, peptideSeq, modLoc);
+    std::string buffer;
+    return utils::getModifiedResidue(_getSequence(proteinID, buffer), peptideSeq, modLoc);
 }
 
 /**
@@ -206,13 +424,13 @@ std::string utils::FastaFile::getModifiedResidue(std::string proteinID,
                                                  std::string peptideSeq,
                                                  int modLoc,
                                                  bool verbose,
-                                                 bool& found)
+                                                 bool& found) const
 {
     found = true;
-    std::string seq = getSequence(proteinID, verbose);
+    std::string buffer;
+    StringView seq = _getSequence(proteinID, buffer, verbose);
     if(seq == utils::PROT_SEQ_NOT_FOUND)
         found = false;
-    //else seq = _foundSequences[proteinID];
     if(seq == utils::PROT_SEQ_NOT_FOUND)
         return utils::PROT_SEQ_NOT_FOUND;
 
@@ -220,86 +438,316 @@ std::string utils::FastaFile::getModifiedResidue(std::string proteinID,
 }
 
 /**
- \brief Parse sequence directly from buffer without intermediate copies.
- \param beg Beginning offset in buffer.
- \param end End offset in buffer.
- \return Parsed protein sequence.
+ \brief Get residue and position of many modifications in their parent proteins. <br>
+
+ Protein IDs are looked up in parallel, then rows are grouped by protein so each protein is
+ handled by one thread and each distinct peptide is only searched for once per protein.
+ Nothing is copied from the protein sequences.
+ \param proteinIDs Parent protein ID of each modification. Can be any of the keys selected with FastaFile::setIdKeys.
+ \param peptideSeqs Unmodified peptide sequence of each modification.
+ \param modLocs Location of each modified residue in its peptide (where 0 is the beginning of the peptide.)
+ \param result Populated with one row for each modification.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ \throws std::invalid_argument if the input columns are not the same length.
  */
-std::string utils::FastaFile::_parseSequence(size_t beg, size_t end) const
+void utils::FastaFile::getModifiedResidues(const std::vector<std::string>& proteinIDs,
+                                           const std::vector<std::string>& peptideSeqs,
+                                           const std::vector<int>& modLocs,
+                                           ModifiedResidueTable& result, unsigned int nThread) const
 {
-    // Estimate sequence length (entry size minus header, typically ~80% is sequence)
-    size_t entrySize = end - beg;
-    std::string seq;
-    seq.reserve(entrySize);
+    size_t nRows = proteinIDs.size();
+    if(peptideSeqs.size() != nRows || modLocs.size() != nRows)
+        throw std::invalid_argument("proteinIDs, peptideSeqs and modLocs must be the same length!");
+    result.residue.assign(nRows, '\0');
+    result.position.assign(nRows, 0);
+    result.status.assign(nRows, ModifiedResidueTable::Status::PROTEIN_NOT_FOUND);
+    if(nRows == 0) return;
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nRows));
+
+    std::vector<size_t> proteinIndex(nRows);
+    std::vector<std::thread> threads;
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            for(size_t i = thread; i < nRows; i += _nThread)
+                proteinIndex[i] = getIdIndex(proteinIDs[i]);
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+
+    // Counting sort rows by protein.
+    std::vector<size_t> groupStart(_sequenceCount + 1, 0);
+    for(size_t i = 0; i < nRows; i++)
+        if(proteinIndex[i] != PROT_ID_NOT_FOUND) groupStart[proteinIndex[i] + 1]++;
+    for(size_t p = 0; p < _sequenceCount; p++)
+        groupStart[p + 1] += groupStart[p];
+    std::vector<size_t> rows(groupStart.back());
+    {
+        std::vector<size_t> next(groupStart.begin(), groupStart.end() - 1);
+        for(size_t i = 0; i < nRows; i++)
+            if(proteinIndex[i] != PROT_ID_NOT_FOUND) rows[next[proteinIndex[i]]++] = i;
+    }
 
-    // Skip first line (header starting with '>')
-    size_t pos = beg;
-    while(pos < end && _buffer[pos] != '\n' && _buffer[pos] != '\r')
-        ++pos;
+    threads.clear();
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            std::string buffer;
+            for(size_t p = thread; p < _sequenceCount; p += _nThread) {
+                size_t lo = groupStart[p], hi = groupStart[p + 1];
+                if(lo == hi) continue;
+
+                // Sort so rows with the same peptide are adjacent.
+                std::sort(rows.begin() + lo, rows.begin() + hi, [&peptideSeqs](size_t lhs, size_t rhs) {
+                    return peptideSeqs[lhs] < peptideSeqs[rhs];
+                });
+                StringView seq = getSequence(p, buffer);
+                size_t begin = StringView::npos;
+                for(size_t r = lo; r < hi; r++) {
+                    size_t row = rows[r];
+                    const std::string& peptide = peptideSeqs[row];
+                    if(r == lo || peptide != peptideSeqs[rows[r - 1]])
+                        begin = seq.find(StringView(peptide.data(), peptide.size()));
+                    if(begin == StringView::npos) {
+                        result.status[row] = ModifiedResidueTable::Status::PEPTIDE_NOT_FOUND;
+                        continue;
+                    }
+                    int modLoc = modLocs[row];
+                    if(modLoc < 0 || (size_t)modLoc >= peptide.size()) {
+                        result.status[row] = ModifiedResidueTable::Status::OUT_OF_BOUNDS;
+                        continue;
+                    }
+                    result.residue[row] = peptide[modLoc];
+                    result.position[row] = begin + modLoc + 1;
+                    result.status[row] = ModifiedResidueTable::Status::FOUND;
+                }
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
 
-    // Skip newline character(s)
-    while(pos < end && (_buffer[pos] == '\n' || _buffer[pos] == '\r'))
-        ++pos;
+void utils::ModifiedResidueTable::clear()
+{
+    residue.clear();
+    position.clear();
+    status.clear();
+}
 
-    // Parse sequence lines directly from buffer
-    while(pos < end)
-    {
-        char c = _buffer[pos];
-        if(c == '>')
-            break;  // Hit next entry
-        if(c != '\n' && c != '\r')
-            seq += c;
-        ++pos;
+/**
+ \brief Get string representation of modified residue in \p row. <br>
+
+ The string is the same as the one returned by FastaFile::getModifiedResidue.
+ */
+std::string utils::ModifiedResidueTable::str(size_t row) const
+{
+    switch(status.at(row)) {
+        case Status::FOUND: return std::string(1, residue[row]) + std::to_string(position[row]);
+        case Status::PROTEIN_NOT_FOUND: return PROT_SEQ_NOT_FOUND;
+        case Status::PEPTIDE_NOT_FOUND: return PEP_SEQ_NOT_FOUND;
+        case Status::OUT_OF_BOUNDS: return MOD_LOC_OUT_OF_BOUNDS;
     }
+    return MOD_LOC_OUT_OF_BOUNDS;
+}
 
-    return seq;
+/**
+ \brief Add an entry to the index. Its residues must already be appended to _residues.
+ \param header Header line without the leading '>' or line ending.
+ \param beg Beginning offset of entry in buffer.
+ \param end End offset of entry in buffer.
+ \param residuesOffset Offset of first residue of entry in _residues.
+ */
+void utils::FastaFile::_addEntry(StringView header, size_t beg, size_t end, size_t residuesOffset)
+{
+    StringView id = _idExtractor(header);
+    if(!id.empty())
+        _idIndex.insert(id, _sequenceCount);
+    if(_idKeys & (ENTRY_NAME | HEADER_TOKEN)) {
+        StringView token = firstToken(header);
+        if(_idKeys & HEADER_TOKEN)
+            _idIndex.insert(token, _sequenceCount);
+        if(_idKeys & ENTRY_NAME) {
+            size_t first = token.find('|');
+            size_t second = first == StringView::npos ? StringView::npos : token.find('|', first + 1);
+            if(second != StringView::npos && second + 1 < token.size())
+                _idIndex.insert(token.substr(second + 1), _sequenceCount);
+        }
+    }
+    _indexOffsets.push_back(utils::FastaEntry(id.str(), beg, end));
+    _sequenceIndex.emplace_back(residuesOffset, _residueCount() - residuesOffset);
+    _sequenceCount++;
 }
 
 /**
- \brief iterate through _buffer to search for indices of beginning and end of all entries.
+ \brief Index every entry in _buffer and copy its residues to _residues in a single pass. <br>
+
+ Any line starting with '>' begins a new entry. Anything before the first header is ignored.
+ In the DENSE and PACKED_5BIT storage modes the file buffer is released once every entry is indexed.
  */
 void utils::FastaFile::_buildIndex()
 {
-    //iterate through _buffer to search for where entries begin
-    std::vector<size_t> combined, trIdx;
-    utils::getIdxOfSubstr(_buffer, ">sp", combined);
-    utils::getIdxOfSubstr(_buffer, ">tr", trIdx);
+    _sequenceCount = 0;
+    _sequenceIndex.clear();
+    _indexOffsets.clear();
+    _idIndex.clear();
 
-    //combine and sort vectors
-    combined.insert(combined.end(), trIdx.begin(), trIdx.end());
-    combined.push_back(_size); //add index to end of buffer
-    std::sort(combined.begin(), combined.end());
+    const char* pos = _buffer;
+    const char* end = _buffer + _size;
 
-    //build _indexOffsets and pre-parse sequences
-    _sequenceCount = 0;
-    int const scanLen = 20;
-    std::string newID;
-    size_t len = combined.size();
+    // Skip to first header line.
+    while(pos < end && *pos != '>') {
+        const char* lineEnd = (const char*)memchr(pos, '\n', end - pos);
+        pos = lineEnd == nullptr ? end : lineEnd + 1;
+    }
 
-    // Reserve space for sequences to avoid reallocations
-    _sequences.reserve(len > 0 ? len - 1 : 0);
+    // Count the residues first so the arena is allocated once at its final size while the file buffer is held.
+    // Reserving the file size and shrinking after the buffer is freed would need about twice the file size.
+    size_t nResidues = 0;
+    for(const char* line = pos; line < end;) {
+        const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+        if(lineEnd == nullptr) lineEnd = end;
+        if(*line != '>') {
+            const char* residuesEnd = lineEnd;
+            while(residuesEnd > line && residuesEnd[-1] == '\r')
+                --residuesEnd;
+            nResidues += residuesEnd - line;
+        }
+        line = lineEnd == end ? end : lineEnd + 1;
+    }
+    std::string().swap(_residues);
+    std::vector<uint64_t>().swap(_packed);
+    _packedSize = 0;
+    if(_storage == Storage::PACKED_5BIT)
+        _packed.reserve(nResidues / RESIDUES_PER_WORD + 1);
+    else _residues.reserve(nResidues);
 
-    for(size_t i = 0; i < len - 1; i++) //for all but last index in combined
+    while(pos < end)
     {
-        char* c = &_buffer[combined[i] + 4];
-        newID = "";
-        for(int j = 0; j < scanLen; j++)
-        {
-            newID += *c;
-            c += 1;
-            if(*c == '|')
-                break;
+        size_t entryBeg = pos - _buffer;
+        const char* headerEnd = (const char*)memchr(pos, '\n', end - pos);
+        if(headerEnd == nullptr) headerEnd = end;
+        const char* idEnd = headerEnd;
+        while(idEnd > pos + 1 && idEnd[-1] == '\r')
+            --idEnd;
+        StringView header(pos + 1, idEnd - pos - 1);
+        size_t residuesOffset = _residueCount();
+
+        // Copy sequence one line at a time until the next header.
+        pos = headerEnd == end ? end : headerEnd + 1;
+        while(pos < end && *pos != '>') {
+            const char* lineEnd = (const char*)memchr(pos, '\n', end - pos);
+            if(lineEnd == nullptr) lineEnd = end;
+            const char* residuesEnd = lineEnd;
+            while(residuesEnd > pos && residuesEnd[-1] == '\r')
+                --residuesEnd;
+            _appendResidues(pos, residuesEnd - pos);
+            pos = lineEnd == end ? end : lineEnd + 1;
         }
 
-        //add sequence offset to class members
-        _idIndex[newID] = _sequenceCount;
-        _indexOffsets.push_back(utils::FastaEntry(newID, combined[i], combined.at(i + 1)));
+        _addEntry(header, entryBeg, pos - _buffer, residuesOffset);
+    }
+
+    if(_storage != Storage::ARENA)
+        _freeBuffer();
+}
+
+/**
+ \brief Set the function used to get the ID of each entry. Must be called before FastaFile::read.
+ \param format Built in header format.
+ */
+void utils::FastaFile::setIdExtractor(IdFormat format)
+{
+    switch(format) {
+        case IdFormat::UNIPROT: _idExtractor = uniprotId;
+            break;
+        case IdFormat::NCBI: _idExtractor = ncbiId;
+            break;
+        case IdFormat::FIRST_TOKEN: _idExtractor = firstToken;
+            break;
+    }
+}
+
+/**
+ \brief Set the function used to get the ID of each entry. Must be called before FastaFile::read.
+ \param extractor Function returning the ID from a header. An empty ID leaves the entry out of the ID index.
+ */
+void utils::FastaFile::setIdExtractor(IdExtractor extractor)
+{
+    if(!extractor)
+        throw std::invalid_argument("IdExtractor can not be empty!");
+    _idExtractor = std::move(extractor);
+}
+
+//! First whitespace delimited token of \p header.
+utils::StringView utils::FastaFile::firstToken(StringView header)
+{
+    size_t len = 0;
+    while(len < header.size() && !isspace(header[len]))
+        len++;
+    return header.substr(0, len);
+}
+
+/**
+ \brief UniProt accession. <br>
+
+ For sp| and tr| headers the token between the first and second '|' is returned.
+ Other headers, including decoys such as rev_sp|P12345|NAME_HUMAN, return the first token
+ so they do not collide with the target entry.
+ */
+utils::StringView utils::FastaFile::uniprotId(StringView header)
+{
+    StringView token = firstToken(header);
+    if(token.size() > 3 && token[2] == '|' &&
+       ((token[0] == 's' && token[1] == 'p') || (token[0] == 't' && token[1] == 'r'))) {
+        size_t end = token.find('|', 3);
+        return token.substr(3, end == StringView::npos ? StringView::npos : end - 3);
+    }
+    return token;
+}
 
-        // Parse and store sequence during index building
-        _sequences.push_back(_parseSequence(combined[i], combined[i + 1]));
+/**
+ \brief NCBI accession. <br>
 
-        _sequenceCount++;
+ For legacy gi|number|db|accession| headers the accession is returned.
+ Otherwise the first token (NP_000001.1 in >NP_000001.1 protein name) is returned.
+ */
+utils::StringView utils::FastaFile::ncbiId(StringView header)
+{
+    StringView token = firstToken(header);
+    if(token.size() > 3 && token[0] == 'g' && token[1] == 'i' && token[2] == '|') {
+        size_t field = 3;
+        for(int i = 0; i < 2 && field != StringView::npos; i++) {
+            field = token.find('|', field);
+            if(field != StringView::npos) field++;
+        }
+        if(field != StringView::npos && field < token.size()) {
+            size_t end = token.find('|', field);
+            return token.substr(field, end == StringView::npos ? StringView::npos : end - field);
+        }
     }
+    return token;
+}
+
+/**
+ \brief Get an IdExtractor which searches each header with a regular expression. <br>
+
+ The expression is compiled once. If it has a capture group, the first group is the ID,
+ otherwise the whole match is. Headers which do not match are not added to the ID index.
+ \param pattern ECMAScript regular expression.
+ \throws std::regex_error if \p pattern is invalid.
+ */
+utils::FastaFile::IdExtractor utils::FastaFile::regexId(const std::string& pattern)
+{
+    auto re = std::make_shared<const std::regex>(pattern);
+    return [re](StringView header) -> StringView {
+        std::cmatch match;
+        if(!std::regex_search(header.begin(), header.end(), match, *re))
+            return StringView();
+        size_t group = match.size() > 1 && match[1].matched ? 1 : 0;
+        return StringView(match[group].first, match[group].length());
+    };
 }
 
 
@@ -318,7 +766,7 @@ bool utils::FastaFile::read(std::string fname){
 \return true if FastaFile::_buffer is empty.
 */
 bool utils::FastaFile::empty() const{
-    return buffer_empty();
+    return buffer_empty() && _sequenceCount == 0;
 }
 
 size_t utils::FastaFile::getSequenceCount() const{
@@ -340,9 +788,10 @@ If \p n overruns \p ref, the maximum number of characters will be returned.
 \return \p n residues after \p query.
 */
 std::string utils::FastaFile::nAfter(const std::string& query, const std::string& ref_id, unsigned n,
-    bool noExcept){
-    std::string ref = getSequence(ref_id);
-    return utils::nAfter(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
+    bool noExcept) const{
+    std::string buffer;
+    StringView ref = _getSequence(ref_id, buffer);
+    return utils::nAfter(query, (ref == utils::PROT_SEQ_NOT_FOUND ? StringView() : ref), n, noExcept);
 }
 
 /**
@@ -359,24 +808,11 @@ If \p n overruns \p ref, the maximum number of characters will be returned.
 
 \return \p n residues before \p query.
 */
-std::string utils::FastaFile::nBefore(const std::string& query, const std::string& ref_id,
-    unsigned n, bool noExcept){
-    std::string ref = getSequence(ref_id);
-    return utils::nBefore(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
-}
-
-//!const overloaded version of FastaFile::nAfter
-std::string utils::FastaFile::nAfter(const std::string& query, const std::string& ref_id, unsigned n,
-    bool noExcept) const{
-    std::string ref = getSequence(ref_id);
-    return utils::nAfter(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
-}
-
-//!const overloaded version of FastaFile::nBefore
 std::string utils::FastaFile::nBefore(const std::string& query, const std::string& ref_id,
     unsigned n, bool noExcept) const{
-    std::string ref = getSequence(ref_id);
-    return utils::nBefore(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
+    std::string buffer;
+    StringView ref = _getSequence(ref_id, buffer);
+    return utils::nBefore(query, (ref == utils::PROT_SEQ_NOT_FOUND ? StringView() : ref), n, noExcept);
 }
 
 /**
@@ -393,17 +829,179 @@ If \p query not found in \p ref_id, returns std::string::npos.
 
 \return Residue index of nth residue in \p ref.
 */
-size_t utils::FastaFile::indexN(const std::string &query, const std::string &ref_id, unsigned int n, bool noExcept)
+size_t utils::FastaFile::indexN(const std::string &query, const std::string &ref_id, unsigned int n, bool noExcept) const
 {
-    std::string ref = getSequence(ref_id);
-    return utils::indexN(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
+    std::string buffer;
+    StringView ref = _getSequence(ref_id, buffer);
+    return utils::indexN(query, (ref == utils::PROT_SEQ_NOT_FOUND ? StringView() : ref), n, noExcept);
 }
 
-//!const overloaded version of FastaFile::indexN
-size_t utils::FastaFile::indexN(const std::string &query, const std::string &ref_id, unsigned int n, bool noExcept) const
+size_t const utils::DecoyGenerator::CHUNK_RESIDUES;
+
+namespace {
+    //! splitmix64 random number generator. Used instead of the standard engines and distributions,
+    //! which are not guaranteed to give the same sequence on every platform.
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+}
+
+/**
+ \brief Constructor. The cleavage residues are set to trypsin (KR) and the seed to 0.
+ \param method Method used to generate decoy sequences.
+ \param prefix Prefix added to the header of each decoy entry.
+ */
+utils::DecoyGenerator::DecoyGenerator(Method method, std::string prefix)
+{
+    _method = method;
+    _prefix = prefix;
+    _seed = 0;
+    _lineWidth = 60;
+    _includeTargets = true;
+    setCleavageResidues("KR");
+}
+
+/**
+ \brief Set the residues after which the enzyme cleaves for PSEUDO_REVERSE and SHUFFLE.
+ \param residues Cleavage residues. If empty, the whole protein is one segment.
+ */
+void utils::DecoyGenerator::setCleavageResidues(const std::string& residues)
+{
+    std::fill(_cleavage, _cleavage + 256, false);
+    for(char c: residues) {
+        _cleavage[(unsigned char)toupper(c)] = true;
+        _cleavage[(unsigned char)tolower(c)] = true;
+    }
+}
+
+//! Reverse or shuffle \p seq from \p begin to \p end.
+void utils::DecoyGenerator::_permute(std::string& seq, size_t begin, size_t end, uint64_t& state) const
+{
+    if(_method == Method::SHUFFLE) {
+        // Fisher-Yates. The modulo bias is negligible for 64 bit random numbers.
+        for(size_t i = end - begin; i > 1; i--)
+            std::swap(seq[begin + i - 1], seq[begin + splitMix64(state) % i]);
+    }
+    else std::reverse(seq.begin() + begin, seq.begin() + end);
+}
+
+/**
+ \brief Generate decoy sequence of \p target.
+ \param target Target protein sequence.
+ \param index Index of target in FastaFile. Only used to seed SHUFFLE.
+ \param decoy Populated with decoy sequence.
+ */
+void utils::DecoyGenerator::makeDecoy(StringView target, size_t index, std::string& decoy) const
+{
+    decoy.assign(target.begin(), target.end());
+    uint64_t state = _seed;
+    state = splitMix64(state) ^ index;
+    if(_method == Method::REVERSE) {
+        _permute(decoy, 0, decoy.size(), state);
+        return;
+    }
+
+    // Permute each segment, leaving the cleavage residue which ends it in place.
+    size_t segmentBegin = 0;
+    for(size_t i = 0; i < decoy.size(); i++) {
+        if(_cleavage[(unsigned char)decoy[i]]) {
+            _permute(decoy, segmentBegin, i, state);
+            segmentBegin = i + 1;
+        }
+    }
+    _permute(decoy, segmentBegin, decoy.size(), state);
+}
+
+//! Append entry with \p header and \p seq to \p out.
+void utils::DecoyGenerator::_writeEntry(StringView header, StringView seq, std::string& out) const
+{
+    out += '>';
+    out.append(header.data(), header.size());
+    out += '\n';
+    size_t lineWidth = _lineWidth == 0 ? seq.size() : _lineWidth;
+    for(size_t i = 0; i < seq.size(); i += lineWidth) {
+        out.append(seq.data() + i, std::min(lineWidth, seq.size() - i));
+        out += '\n';
+    }
+}
+
+/**
+ \brief Write targets (optionally) and decoys of every entry in \p fasta to \p out. <br>
+
+ Each batch is split into one chunk of about CHUNK_RESIDUES residues for each thread.
+ The threads format their chunks in parallel, then the chunks are written in order.
+ \param fasta Initialized FastaFile.
+ \param out Stream to write to.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ \return true if all entries were written successfully.
+ */
+bool utils::DecoyGenerator::write(const FastaFile& fasta, std::ostream& out, unsigned int nThread) const
+{
+    size_t nProteins = fasta.getSequenceCount();
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nProteins));
+
+    std::vector<std::string> buffers(_nThread);
+    std::vector<std::pair<size_t, size_t> > chunks;
+    for(int pass = _includeTargets ? 0 : 1; pass < 2; pass++) {
+        bool decoys = pass == 1;
+        size_t next = 0;
+        while(next < nProteins) {
+            chunks.clear();
+            while(chunks.size() < _nThread && next < nProteins) {
+                size_t begin = next;
+                size_t residues = 0;
+                while(next < nProteins && residues < CHUNK_RESIDUES)
+                    residues += fasta.getSequenceLength(next++);
+                chunks.emplace_back(begin, next);
+            }
+
+            std::vector<std::thread> threads;
+            for(size_t c = 0; c < chunks.size(); c++) {
+                threads.emplace_back([&, c] {
+                    std::string& buffer = buffers[c];
+                    buffer.clear();
+                    std::string decoy, header, seqBuffer;
+                    for(size_t i = chunks[c].first; i < chunks[c].second; i++) {
+                        // Headers are not available if the FastaFile released its buffer.
+                        header = fasta.getHeader(i).str();
+                        if(header.empty())
+                            header = fasta.getIndexID(i);
+                        StringView seq = fasta.getSequence(i, seqBuffer);
+                        if(decoys) {
+                            makeDecoy(seq, i, decoy);
+                            _writeEntry(_prefix + header, decoy, buffer);
+                        }
+                        else _writeEntry(header, seq, buffer);
+                    }
+                });
+            }
+            for(auto& thread: threads)
+                thread.join();
+
+            for(size_t c = 0; c < chunks.size(); c++)
+                out.write(buffers[c].data(), buffers[c].size());
+            if(!out) return false;
+        }
+    }
+    return (bool)out;
+}
+
+/**
+ \brief Write target-decoy database to \p ofname.
+ \param fasta Initialized FastaFile.
+ \param ofname Path of output file.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ \return false if \p ofname could not be written.
+ */
+bool utils::DecoyGenerator::write(const FastaFile& fasta, const std::string& ofname, unsigned int nThread) const
 {
-    std::string ref = getSequence(ref_id);
-    return utils::indexN(query, (ref == utils::PROT_SEQ_NOT_FOUND ? "" : ref), n, noExcept);
+    std::ofstream outF(ofname, std::ios::out | std::ios::binary);
+    if(!outF) return false;
+    return write(fasta, outF, nThread);
 }
 
 /**
@@ -414,7 +1012,7 @@ size_t utils::FastaFile::indexN(const std::string &query, const std::string &ref
  \param modLoc location of modified residue in peptide
  (where 0 is the beginning of the peptide.)
  */
-std::string utils::getModifiedResidue(const std::string& seq, const std::string& peptideSeq, int modLoc)
+std::string utils::getModifiedResidue(StringView seq, const std::string& peptideSeq, int modLoc)
 {
     if(seq == utils::PROT_SEQ_NOT_FOUND)
         return utils::PROT_SEQ_NOT_FOUND;
@@ -440,7 +1038,7 @@ std::string utils::getModifiedResidue(const std::string& seq, const std::string&
 
 \return false if \p query is not in \p ref, true otherwise.
 */
-bool utils::align(const std::string& query, const std::string& ref, size_t& beg, size_t& end)
+bool utils::align(const std::string& query, StringView ref, size_t& beg, size_t& end)
 {
     size_t match = ref.find(query);
     if(match == std::string::npos) return false;
@@ -465,17 +1063,17 @@ If \p n overruns \p ref, the maximum possible number of characters will be retur
 
 \return \p n residues before \p query.
 */
-std::string utils::nBefore(const std::string& query, const std::string& ref, unsigned n, bool noExcept)
+std::string utils::nBefore(const std::string& query, StringView ref, unsigned n, bool noExcept)
 {
     size_t beg, end;
     if(!utils::align(query, ref, beg, end)){
         if(noExcept) return "";
-        else throw std::out_of_range("query:\n\t" + query + "\nnot in ref:\n\t" + ref);
+        else throw std::out_of_range("query:\n\t" + query + "\nnot in ref:\n\t" + ref.str());
     }
 
     if(beg < n) n = beg;
 
-    return ref.substr(beg - n, n);
+    return ref.substr(beg - n, n).str();
 }
 
 /**
@@ -492,18 +1090,18 @@ If \p n overruns \p ref, the maximum possible number of characters will be retur
 
 \return \p n residues after \p query.
 */
-std::string utils::nAfter(const std::string& query, const std::string& ref, unsigned n, bool noExcept)
+std::string utils::nAfter(const std::string& query, StringView ref, unsigned n, bool noExcept)
 {
     size_t beg, end;
     if(!utils::align(query, ref, beg, end)){
         if(noExcept) return "";
-        else throw std::out_of_range("query:\n\t" + query + "\nnot in ref:\n\t" + ref);
+        else throw std::out_of_range("query:\n\t" + query + "\nnot in ref:\n\t" + ref.str());
     }
 
     end += 1;
     if(end + n > ref.length())
         n = ref.length() - end;
-    return ref.substr(end, n);
+    return ref.substr(end, n).str();
 }
 
 /**
@@ -520,7 +1118,7 @@ If \p query not found in \p ref, returns std::string::npos.
 
 \return Residue index of nth residue in \p ref.
 */
-size_t utils::indexN(const std::string& query, const std::string& ref, size_t n, bool noExcept)
+size_t utils::indexN(const std::string& query, StringView ref, size_t n, bool noExcept)
 {
     size_t beg, end;
     if(!utils::align(query, ref, beg, end)){
@@ -0,0 +1,555 @@
+//
+// fmIndex.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+#include <fmIndex.hpp>
+
+char const utils::FmIndex::MAGIC[8] = {'P', 'U', 'F', 'M', 'I', 'D', 'X', '\0'};
+uint32_t const utils::FmIndex::VERSION;
+size_t const utils::FmIndex::DEFAULT_SA_SAMPLE;
+size_t const utils::FmIndex::CHECKPOINT_INTERVAL;
+int const utils::FmIndex::SIGMA;
+
+static_assert(sizeof(utils::FmIndex::Header) == 128, "Unexpected FmIndex::Header size");
+static_assert(utils::FmIndex::CHECKPOINT_INTERVAL == 64, "Checkpoints must line up with _markBits words");
+
+namespace {
+    uint8_t const TERMINATOR = 0;
+    uint8_t const SEPARATOR = 1;
+
+    bool isLittleEndian() {
+        uint16_t i = 1;
+        return *((const char*)&i) == 1;
+    }
+
+    size_t popcount64(uint64_t x) {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (size_t)((x * 0x0101010101010101ULL) >> 56);
+    }
+
+    //! Is [\p offset, \p offset + \p len) inside a buffer of \p size bytes? Safe from overflow.
+    bool inBounds(uint64_t offset, uint64_t len, uint64_t size) {
+        return offset <= size && len <= size - offset;
+    }
+
+    //! Round \p offset up to the next multiple of 8.
+    uint64_t align8(uint64_t offset) {
+        return (offset + 7) & ~(uint64_t)7;
+    }
+}
+
+/**
+ \brief Constructor.
+ \param fname Path to saved index.
+ */
+utils::FmIndex::FmIndex(std::string fname) : BufferFile(fname)
+{
+    _useMmap = true;
+    _clearSections();
+    _initAlphabet(false);
+}
+
+void utils::FmIndex::_initAlphabet(bool ilEquivalent)
+{
+    std::fill(_code, _code + 256, 0);
+    for(int c = 0; c < 26; c++) {
+        _code['A' + c] = (uint8_t)(c + 2);
+        _code['a' + c] = (uint8_t)(c + 2);
+    }
+    if(ilEquivalent) {
+        _code['L'] = _code['I'];
+        _code['l'] = _code['I'];
+    }
+}
+
+void utils::FmIndex::_clearSections()
+{
+    _header = nullptr;
+    _C = nullptr;
+    _bwt = nullptr;
+    _occ = nullptr;
+    _markBits = nullptr;
+    _markRank = nullptr;
+    _samples = nullptr;
+    _proteinStarts = nullptr;
+}
+
+/**
+ \brief Point sections at an index image in \p data. <br>
+
+ Offsets are checked against \p size, and the checkpoints, symbol counts, samples and protein offsets
+ are checked against the BWT in one pass, so queries on a corrupt index never read outside of it.
+ \throws utils::FileIOError if \p data is not a valid index.
+ */
+void utils::FmIndex::_setSections(const char* data, size_t size)
+{
+    _clearSections();
+    if(!isLittleEndian())
+        throw utils::FileIOError("FmIndex is only supported on little endian systems.");
+    if(size < sizeof(Header))
+        throw utils::FileIOError("Invalid FmIndex header in: " + _fname);
+    const auto* header = (const Header*)data;
+    if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw utils::FileIOError("Invalid FmIndex header in: " + _fname);
+    if(header->version != VERSION)
+        throw utils::FileIOError("Unsupported FmIndex version: " + std::to_string(header->version));
+
+    uint64_t n = header->textLength;
+    uint64_t nWords = n / 64 + 1;
+    if(header->fileSize > size || n == 0 || n >= UINT32_MAX || header->saSampleRate == 0 ||
+       header->sampleCount > n || header->proteinCount >= n ||
+       !inBounds(header->cOffset, (SIGMA + 1) * sizeof(uint64_t), header->fileSize) ||
+       !inBounds(header->bwtOffset, n, header->fileSize) ||
+       !inBounds(header->occOffset, nWords * SIGMA * sizeof(uint32_t), header->fileSize) ||
+       !inBounds(header->markOffset, nWords * sizeof(uint64_t), header->fileSize) ||
+       !inBounds(header->markRankOffset, nWords * sizeof(uint32_t), header->fileSize) ||
+       !inBounds(header->sampleOffset, header->sampleCount * sizeof(uint32_t), header->fileSize) ||
+       !inBounds(header->proteinOffset, (header->proteinCount + 1) * sizeof(uint64_t), header->fileSize))
+        throw utils::FileIOError("Truncated FmIndex: " + _fname);
+    uint64_t offsets[] = {header->cOffset, header->occOffset, header->markOffset, header->markRankOffset,
+                          header->sampleOffset, header->proteinOffset};
+    for(uint64_t offset: offsets)
+        if(offset % 8 != 0) throw utils::FileIOError("Misaligned FmIndex section in: " + _fname);
+
+    // Check that every value used as an index during a query is in range.
+    const auto* C = (const uint64_t*)(data + header->cOffset);
+    const auto* bwt = (const uint8_t*)(data + header->bwtOffset);
+    const auto* occ = (const uint32_t*)(data + header->occOffset);
+    const auto* markBits = (const uint64_t*)(data + header->markOffset);
+    const auto* markRank = (const uint32_t*)(data + header->markRankOffset);
+    const auto* samples = (const uint32_t*)(data + header->sampleOffset);
+    const auto* proteinStarts = (const uint64_t*)(data + header->proteinOffset);
+    uint32_t counts[SIGMA] = {0};
+    uint64_t marked = 0;
+    for(uint64_t i = 0; i <= n; i++) {
+        if(i % CHECKPOINT_INTERVAL == 0) {
+            if(!std::equal(counts, counts + SIGMA, occ + (i / CHECKPOINT_INTERVAL) * SIGMA) ||
+               markRank[i / 64] != marked)
+                throw utils::FileIOError("Invalid FmIndex checkpoint in: " + _fname);
+            marked += popcount64(markBits[i / 64]);
+        }
+        if(i == n) break;
+        if(bwt[i] >= SIGMA)
+            throw utils::FileIOError("Invalid FmIndex BWT in: " + _fname);
+        counts[bwt[i]]++;
+    }
+    if(marked != header->sampleCount)
+        throw utils::FileIOError("Invalid FmIndex sample count in: " + _fname);
+    if(C[0] != 0)
+        throw utils::FileIOError("Invalid FmIndex symbol counts in: " + _fname);
+    for(int c = 0; c < SIGMA; c++)
+        if(C[c + 1] != C[c] + counts[c])
+            throw utils::FileIOError("Invalid FmIndex symbol counts in: " + _fname);
+    for(uint64_t i = 0; i < header->sampleCount; i++)
+        if(samples[i] >= n) throw utils::FileIOError("Invalid FmIndex sample in: " + _fname);
+    if(proteinStarts[0] != 0 || proteinStarts[header->proteinCount] != n - 1)
+        throw utils::FileIOError("Invalid FmIndex protein offsets in: " + _fname);
+    for(uint64_t p = 0; p < header->proteinCount; p++)
+        if(proteinStarts[p + 1] <= proteinStarts[p])
+            throw utils::FileIOError("Invalid FmIndex protein offsets in: " + _fname);
+
+    _header = header;
+    _C = C;
+    _bwt = bwt;
+    _occ = occ;
+    _markBits = markBits;
+    _markRank = markRank;
+    _samples = samples;
+    _proteinStarts = proteinStarts;
+    _initAlphabet(header->flags & IL_EQUIVALENT);
+}
+
+/**
+ \brief Fingerprint of the sequences in \p fasta used to check that a saved index is current.
+ \param fasta Initialized FastaFile.
+ \param residueCount Populated with total length of sequences.
+ \param sourceHash Populated with FNV-1a hash of the length of each sequence.
+ */
+void utils::FmIndex::_fingerprint(const FastaFile& fasta, uint64_t& residueCount, uint64_t& sourceHash)
+{
+    residueCount = 0;
+    sourceHash = 14695981039346656037ULL;
+    size_t nProteins = fasta.getSequenceCount();
+    for(size_t p = 0; p < nProteins; p++) {
+        uint64_t len = fasta.getSequenceLength(p);
+        residueCount += len;
+        for(int byte = 0; byte < 8; byte++) {
+            sourceHash ^= (len >> (byte * 8)) & 0xFF;
+            sourceHash *= 1099511628211ULL;
+        }
+    }
+}
+
+/**
+ \brief Sort the suffixes of \p text by prefix doubling. <br>
+
+ Suffixes are first bucketed by their first 3 symbols. Each round sorts the suffixes in every unsorted
+ group by the rank of the suffix h positions later, which doubles the sorted prefix length.
+ Groups are independent, so they are split between threads. Ranks are only updated after
+ every group in a round is sorted, so threads never read a rank another thread is writing.
+ \param text Text ending with a single TERMINATOR.
+ \param sa Populated with suffix array of \p text.
+ \param nThread Number of threads to use.
+ */
+void utils::FmIndex::_suffixSort(const std::vector<uint8_t>& text, std::vector<uint32_t>& sa, unsigned int nThread)
+{
+    size_t n = text.size();
+    size_t const prefixLen = 3;
+    auto prefixKey = [&text, n](size_t i) {
+        size_t key = 0;
+        for(size_t j = 0; j < prefixLen; j++)
+            key = key * SIGMA + (i + j < n ? text[i + j] : 0);
+        return key;
+    };
+
+    // Counting sort by first symbols. The rank of each suffix is the first row of its group.
+    size_t nBuckets = SIGMA * SIGMA * SIGMA;
+    std::vector<uint32_t> bucketStart(nBuckets + 1, 0);
+    for(size_t i = 0; i < n; i++)
+        bucketStart[prefixKey(i) + 1]++;
+    for(size_t b = 0; b < nBuckets; b++)
+        bucketStart[b + 1] += bucketStart[b];
+    std::vector<uint32_t> rank(n);
+    sa.resize(n);
+    {
+        std::vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+        for(size_t i = 0; i < n; i++) {
+            size_t key = prefixKey(i);
+            rank[i] = bucketStart[key];
+            sa[next[key]++] = (uint32_t)i;
+        }
+    }
+    typedef std::pair<uint32_t, uint32_t> Group;
+    std::vector<Group> groups;
+    for(size_t b = 0; b < nBuckets; b++)
+        if(bucketStart[b + 1] - bucketStart[b] > 1)
+            groups.emplace_back(bucketStart[b], bucketStart[b + 1]);
+    std::vector<uint32_t>().swap(bucketStart);
+
+    // Sort key in high bits and suffix in low bits.
+    std::vector<uint64_t> keys(n);
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    for(size_t h = prefixLen; !groups.empty(); h *= 2) {
+        unsigned int nGroupThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, groups.size()));
+
+        // Members of an unsorted group share a prefix without the terminator, so sa[i] + h < n
+        std::vector<std::thread> threads;
+        for(unsigned int thread = 0; thread < nGroupThread; thread++) {
+            threads.emplace_back([&, thread] {
+                for(size_t g = thread; g < groups.size(); g += nGroupThread) {
+                    for(size_t i = groups[g].first; i < groups[g].second; i++)
+                        keys[i] = ((uint64_t)rank[sa[i] + h] << 32) | sa[i];
+                    std::sort(keys.begin() + groups[g].first, keys.begin() + groups[g].second);
+                    for(size_t i = groups[g].first; i < groups[g].second; i++)
+                        sa[i] = (uint32_t)keys[i];
+                }
+            });
+        }
+        for(auto& thread: threads)
+            thread.join();
+
+        // Split groups and update ranks.
+        std::vector<std::vector<Group> > threadGroups(nGroupThread);
+        threads.clear();
+        for(unsigned int thread = 0; thread < nGroupThread; thread++) {
+            threads.emplace_back([&, thread] {
+                for(size_t g = thread; g < groups.size(); g += nGroupThread) {
+                    uint32_t lo = groups[g].first, hi = groups[g].second;
+                    uint32_t subgroup = lo;
+                    for(uint32_t i = lo; i < hi; i++) {
+                        if(i > lo && (keys[i] >> 32) != (keys[i - 1] >> 32)) {
+                            if(i - subgroup > 1) threadGroups[thread].emplace_back(subgroup, i);
+                            subgroup = i;
+                        }
+                        rank[sa[i]] = subgroup;
+                    }
+                    if(hi - subgroup > 1) threadGroups[thread].emplace_back(subgroup, hi);
+                }
+            });
+        }
+        for(auto& thread: threads)
+            thread.join();
+
+        groups.clear();
+        for(const auto& g: threadGroups)
+            groups.insert(groups.end(), g.begin(), g.end());
+    }
+}
+
+/**
+ \brief Build index of every sequence in \p fasta. Any existing index is discarded.
+ \param fasta Initialized FastaFile.
+ \param ilEquivalent Should I and L be treated as the same residue?
+ \param saSampleRate Suffix array values are stored for every \p saSampleRate text positions.
+ Lower values make FmIndex::locate faster and the index larger.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ \throws std::invalid_argument if \p saSampleRate is 0 or the proteome is too large.
+ */
+void utils::FmIndex::build(const FastaFile& fasta, bool ilEquivalent, size_t saSampleRate, unsigned int nThread)
+{
+    if(saSampleRate == 0)
+        throw std::invalid_argument("saSampleRate must be greater than 0!");
+    _clearSections();
+    _data.clear();
+    _freeBuffer();
+    _initAlphabet(ilEquivalent);
+
+    // Concatenate sequences.
+    size_t nProteins = fasta.getSequenceCount();
+    std::vector<uint64_t> proteinStarts;
+    proteinStarts.reserve(nProteins + 1);
+    std::vector<uint8_t> text;
+    std::string buffer;
+    for(size_t p = 0; p < nProteins; p++) {
+        proteinStarts.push_back(text.size());
+        for(char c: fasta.getSequence(p, buffer)) {
+            uint8_t symbol = _code[(unsigned char)c];
+            text.push_back(symbol == 0 ? SEPARATOR : symbol);
+        }
+        text.push_back(SEPARATOR);
+    }
+    proteinStarts.push_back(text.size());
+    text.push_back(TERMINATOR);
+    size_t n = text.size();
+    if(n >= UINT32_MAX)
+        throw std::invalid_argument("Proteome is too large for FmIndex!");
+
+    std::vector<uint32_t> sa;
+    _suffixSort(text, sa, nThread);
+
+    // Calculate section offsets.
+    size_t nWords = n / 64 + 1;
+    size_t nSamples = 0;
+    for(size_t i = 0; i < n; i++)
+        if(sa[i] % saSampleRate == 0) nSamples++;
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = ilEquivalent ? IL_EQUIVALENT : 0;
+    header.textLength = n;
+    header.proteinCount = nProteins;
+    header.saSampleRate = saSampleRate;
+    header.sampleCount = nSamples;
+    _fingerprint(fasta, header.residueCount, header.sourceHash);
+    header.cOffset = sizeof(Header);
+    header.bwtOffset = align8(header.cOffset + (SIGMA + 1) * sizeof(uint64_t));
+    header.occOffset = align8(header.bwtOffset + n);
+    header.markOffset = align8(header.occOffset + nWords * SIGMA * sizeof(uint32_t));
+    header.markRankOffset = align8(header.markOffset + nWords * sizeof(uint64_t));
+    header.sampleOffset = align8(header.markRankOffset + nWords * sizeof(uint32_t));
+    header.proteinOffset = align8(header.sampleOffset + nSamples * sizeof(uint32_t));
+    header.fileSize = align8(header.proteinOffset + (nProteins + 1) * sizeof(uint64_t));
+
+    _data.assign(header.fileSize / sizeof(uint64_t), 0);
+    char* data = (char*)_data.data();
+    memcpy(data, &header, sizeof(Header));
+    auto* C = (uint64_t*)(data + header.cOffset);
+    auto* bwt = (uint8_t*)(data + header.bwtOffset);
+    auto* occ = (uint32_t*)(data + header.occOffset);
+    auto* markBits = (uint64_t*)(data + header.markOffset);
+    auto* markRank = (uint32_t*)(data + header.markRankOffset);
+    auto* samples = (uint32_t*)(data + header.sampleOffset);
+    memcpy(data + header.proteinOffset, proteinStarts.data(), proteinStarts.size() * sizeof(uint64_t));
+
+    uint32_t counts[SIGMA] = {0};
+    size_t sample = 0;
+    for(size_t i = 0; i < n; i++) {
+        if(i % CHECKPOINT_INTERVAL == 0) {
+            std::copy(counts, counts + SIGMA, occ + (i / CHECKPOINT_INTERVAL) * SIGMA);
+            markRank[i / 64] = (uint32_t)sample;
+        }
+        bwt[i] = sa[i] == 0 ? TERMINATOR : text[sa[i] - 1];
+        counts[bwt[i]]++;
+        if(sa[i] % saSampleRate == 0) {
+            markBits[i / 64] |= (uint64_t)1 << (i % 64);
+            samples[sample++] = sa[i];
+        }
+    }
+    if(n % CHECKPOINT_INTERVAL == 0) {
+        std::copy(counts, counts + SIGMA, occ + (n / CHECKPOINT_INTERVAL) * SIGMA);
+        markRank[n / 64] = (uint32_t)sample;
+    }
+    C[0] = 0;
+    for(int c = 0; c < SIGMA; c++)
+        C[c + 1] = C[c] + counts[c];
+
+    _setSections(data, header.fileSize);
+}
+
+/**
+ \brief Save index to \p ofname.
+ \return false if the index is empty or \p ofname could not be written.
+ */
+bool utils::FmIndex::write(const std::string& ofname) const
+{
+    if(empty()) return false;
+    std::ofstream outF(ofname, std::ios::out | std::ios::binary);
+    if(!outF) return false;
+    outF.write((const char*)_header, _header->fileSize);
+    return (bool)outF;
+}
+
+/**
+ \brief Memory map index saved by FmIndex::write
+ \return false if the file could not be read.
+ \throws utils::FileIOError if the file is not a valid index.
+ */
+bool utils::FmIndex::read()
+{
+    _clearSections();
+    _data.clear();
+    if(!BufferFile::read()) return false;
+    _setSections(_buffer, _size);
+    return true;
+}
+
+bool utils::FmIndex::read(std::string fname)
+{
+    _fname = fname;
+    return FmIndex::read();
+}
+
+/**
+ \brief Check whether the index was built from \p fasta. <br>
+
+ The number of proteins, the total number of residues, and a hash of the length of each sequence
+ are compared, so a FastaFile edited without changing any sequence length is not detected.
+ \param fasta Initialized FastaFile.
+ \return false if the index is empty or was built from a different proteome.
+ */
+bool utils::FmIndex::matches(const FastaFile& fasta) const
+{
+    if(empty() || _header->proteinCount != fasta.getSequenceCount()) return false;
+    uint64_t residueCount, sourceHash;
+    _fingerprint(fasta, residueCount, sourceHash);
+    return _header->residueCount == residueCount && _header->sourceHash == sourceHash;
+}
+
+//! Number of \p c in BWT before \p row.
+size_t utils::FmIndex::_rank(uint8_t c, size_t row) const
+{
+    size_t block = row / CHECKPOINT_INTERVAL;
+    size_t ret = _occ[block * SIGMA + c];
+    for(size_t i = block * CHECKPOINT_INTERVAL; i < row; i++)
+        ret += _bwt[i] == c;
+    return ret;
+}
+
+//! Row of suffix starting one position before the suffix in \p row.
+size_t utils::FmIndex::_lf(size_t row) const
+{
+    uint8_t c = _bwt[row];
+    return _C[c] + _rank(c, row);
+}
+
+/**
+ \brief Backward search for the rows of suffixes starting with \p query.
+ \return false if \p query does not occur.
+ */
+bool utils::FmIndex::_range(StringView query, size_t& lo, size_t& hi) const
+{
+    if(empty() || query.empty()) return false;
+    lo = 0;
+    hi = _header->textLength;
+    for(size_t i = query.size(); i > 0; i--) {
+        uint8_t c = _code[(unsigned char)query[i - 1]];
+        if(c == 0) return false;
+        lo = _C[c] + _rank(c, lo);
+        hi = _C[c] + _rank(c, hi);
+        if(lo >= hi) return false;
+    }
+    return true;
+}
+
+/**
+ \brief Text position of suffix in \p row, found by walking back to the nearest sampled row.
+ \throws utils::FileIOError if no sampled row is found within the sample rate, which only happens if the index is corrupt.
+ */
+size_t utils::FmIndex::_textPosition(size_t row) const
+{
+    size_t steps = 0;
+    while(!((_markBits[row / 64] >> (row % 64)) & 1)) {
+        row = _lf(row);
+        if(++steps >= _header->saSampleRate)
+            throw utils::FileIOError("Corrupt FmIndex: " + _fname);
+    }
+    uint64_t before = _markBits[row / 64] & (((uint64_t)1 << (row % 64)) - 1);
+    return _samples[_markRank[row / 64] + popcount64(before)] + steps;
+}
+
+/**
+ \brief Count occurrences of \p query in all proteins.
+ \param query Peptide sequence. Residues are case insensitive.
+ */
+size_t utils::FmIndex::count(StringView query) const
+{
+    size_t lo, hi;
+    return _range(query, lo, hi) ? hi - lo : 0;
+}
+
+/**
+ \brief Find every occurrence of \p query.
+ \param query Peptide sequence. Residues are case insensitive.
+ \param occurrences Populated with occurrences sorted by protein and start.
+ */
+void utils::FmIndex::locate(StringView query, std::vector<Occurrence>& occurrences) const
+{
+    occurrences.clear();
+    size_t lo, hi;
+    if(!_range(query, lo, hi)) return;
+    occurrences.reserve(hi - lo);
+    const uint64_t* startsEnd = _proteinStarts + _header->proteinCount + 1;
+    for(size_t row = lo; row < hi; row++) {
+        size_t pos = _textPosition(row);
+        size_t protein = std::upper_bound(_proteinStarts, startsEnd, (uint64_t)pos) - _proteinStarts - 1;
+        occurrences.emplace_back(protein, pos - _proteinStarts[protein]);
+    }
+    std::sort(occurrences.begin(), occurrences.end());
+}
+
+/**
+ \brief Get the proteins containing \p query.
+ \param query Peptide sequence. Residues are case insensitive.
+ \param proteins Populated with sorted indices of proteins in FastaFile.
+ */
+void utils::FmIndex::getProteins(StringView query, std::vector<size_t>& proteins) const
+{
+    std::vector<Occurrence> occurrences;
+    locate(query, occurrences);
+    proteins.clear();
+    for(const auto& occurrence: occurrences)
+        if(proteins.empty() || proteins.back() != occurrence.protein)
+            proteins.push_back(occurrence.protein);
+}
@@ -0,0 +1,167 @@
+//
+// centroider.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <msInterface/centroider.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace utils;
+
+namespace {
+    /**
+     \brief Find the vertex of the parabola through 3 points with unequal x spacing.
+
+     \param x0,x1,x2 x values in ascending order.
+     \param y0,y1,y2 y values where \p y1 is the maximum.
+     \param x Populated with x of vertex.
+     \param y Populated with y of vertex.
+     \return false if the points are co-linear or the parabola is not concave down.
+     */
+    inline bool parabolaVertex(double x0, double x1, double x2,
+                               double y0, double y1, double y2,
+                               double& x, double& y)
+    {
+        double d1 = (y1 - y0) / (x1 - x0);
+        double d2 = (y2 - y1) / (x2 - x1);
+        double a = (d2 - d1) / (x2 - x0);
+        if(!(a < 0)) return false;
+
+        // y = y0 + d1 * (x - x0) + a * (x - x0) * (x - x1)
+        x = ((x0 + x1) - d1 / a) / 2;
+        x = std::min(std::max(x, x0), x2);
+        y = y0 + d1 * (x - x0) + a * (x - x0) * (x - x1);
+        return true;
+    }
+}
+
+/**
+ \brief Estimate the noise level of a spectrum as the median of the nonzero intensities.
+
+ \param intensity Intensity array.
+ \param n Length of \p intensity.
+ \return Noise level. 0 if there are no nonzero intensities.
+ */
+double msInterface::Centroider::estimateNoise(const double* intensity, size_t n)
+{
+    std::vector<double> nonzero;
+    nonzero.reserve(n);
+    for(size_t i = 0; i < n; i++)
+        if(intensity[i] > 0) nonzero.push_back(intensity[i]);
+    if(nonzero.empty()) return 0;
+
+    auto mid = nonzero.begin() + nonzero.size() / 2;
+    std::nth_element(nonzero.begin(), mid, nonzero.end());
+    return *mid;
+}
+
+/**
+ \brief Centroid profile mode data points. <br>
+
+ The points are scanned once to mark local maxima above the intensity threshold.
+ The marking pass has no branches so the compiler can vectorize it.
+ The apex of each marked point is then refined in a second pass over only the marked points.
+ A plateau is reported once, at its first point.
+
+ \param mz Profile m/z values sorted in ascending order.
+ \param intensity Profile intensities.
+ \param n Number of profile points.
+ \param outMZ Populated with centroid m/z values. Existing contents are discarded.
+ \param outIntensity Populated with centroid apex intensities. Existing contents are discarded.
+ */
+void msInterface::Centroider::centroid(const double* mz, const double* intensity, size_t n,
+                                       std::vector<double>& outMZ, std::vector<double>& outIntensity) const
+{
+    outMZ.clear();
+    outIntensity.clear();
+    if(n < 3) return;
+
+    double threshold = 0;
+    if(_snThreshold > 0)
+        threshold = _snThreshold * estimateNoise(intensity, n);
+
+    std::vector<uint8_t> isMax(n, 0);
+    size_t nMax = 0;
+    for(size_t i = 1; i < n - 1; i++) {
+        uint8_t m = (intensity[i] > intensity[i - 1]) &
+                    (intensity[i] >= intensity[i + 1]) &
+                    (intensity[i] > threshold);
+        isMax[i] = m;
+        nMax += m;
+    }
+
+    outMZ.reserve(nMax);
+    outIntensity.reserve(nMax);
+    for(size_t i = 1; i < n - 1; i++) {
+        if(!isMax[i]) continue;
+
+        double x = mz[i];
+        double y = intensity[i];
+        double x0 = mz[i - 1], x2 = mz[i + 1];
+        double y0 = intensity[i - 1], y2 = intensity[i + 1];
+        if(_apex == Apex::GAUSSIAN && y0 > 0 && y2 > 0) {
+            double ly;
+            if(parabolaVertex(x0, x, x2, std::log(y0), std::log(y), std::log(y2), x, ly))
+                y = std::exp(ly);
+        }
+        else parabolaVertex(x0, x, x2, y0, y, y2, x, y);
+
+        outMZ.push_back(x);
+        outIntensity.push_back(y);
+    }
+}
+
+/**
+ \brief Centroid \p scan in place. <br>
+
+ Does nothing if \p scan is already centroided.
+ \param scan Profile mode scan.
+ */
+void msInterface::Centroider::centroid(Scan& scan) const
+{
+    if(scan.isCentroided()) return;
+
+    // Scan stores ions as an array of structures. Copy to separate arrays for the centroiding pass.
+    auto& ions = scan.getIons();
+    size_t n = ions.size();
+    std::vector<double> mz(n), intensity(n);
+    for(size_t i = 0; i < n; i++) {
+        mz[i] = ions[i].getMZ();
+        intensity[i] = ions[i].getIntensity();
+    }
+
+    std::vector<double> outMZ, outIntensity;
+    centroid(mz.data(), intensity.data(), n, outMZ, outIntensity);
+
+    ions.clear();
+    ions.reserve(outMZ.size());
+    for(size_t i = 0; i < outMZ.size(); i++)
+        ions.emplace_back(outMZ[i], outIntensity[i]);
+    scan.setCentroided(true);
+    scan.updateRanges();
+}
@@ -0,0 +1,104 @@
+//
+// chromatogram.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <cstdlib>
+
+#include <msInterface/chromatogram.hpp>
+
+using namespace utils;
+
+void msInterface::RunSummary::clear()
+{
+    scanNum.clear();
+    level.clear();
+    rt.clear();
+    tic.clear();
+    basePeakMZ.clear();
+    basePeakIntensity.clear();
+    peakCount.clear();
+    precursorScan.clear();
+    precursorMZ.clear();
+    precursorCharge.clear();
+    isolationLower.clear();
+    isolationUpper.clear();
+}
+
+//! Resize every column to \p n rows.
+void msInterface::RunSummary::resize(size_t n)
+{
+    scanNum.resize(n, 0);
+    level.resize(n, 0);
+    rt.resize(n, 0);
+    tic.resize(n, 0);
+    basePeakMZ.resize(n, 0);
+    basePeakIntensity.resize(n, 0);
+    peakCount.resize(n, 0);
+    precursorScan.resize(n, 0);
+    precursorMZ.resize(n, 0);
+    precursorCharge.resize(n, 0);
+    isolationLower.resize(n, 0);
+    isolationUpper.resize(n, 0);
+}
+
+//! Copy precursor scan, m/z, charge and isolation window of \p precursor into row \p row.
+void msInterface::RunSummary::setPrecursor(size_t row, const PrecursorScan& precursor)
+{
+    // strtoul and strtod return 0 for empty or non numeric values.
+    precursorScan[row] = std::strtoul(precursor.getScan().c_str(), nullptr, 10);
+    precursorMZ[row] = std::strtod(precursor.getMZ().c_str(), nullptr);
+    precursorCharge[row] = precursor.getCharge();
+    isolationLower[row] = precursor.getIsolationLower();
+    isolationUpper[row] = precursor.getIsolationUpper();
+}
+
+/**
+ \brief Get total ion current chromatogram.
+ \param chromatogram Populated with TIC of scans at \p msLevel.
+ \param msLevel MS level of scans to include.
+ */
+void msInterface::RunSummary::getTIC(Chromatogram& chromatogram, int msLevel) const
+{
+    chromatogram.clear();
+    chromatogram.setId("TIC");
+    for(size_t i = 0; i < size(); i++)
+        if(level[i] == msLevel)
+            chromatogram.add(rt[i], tic[i]);
+}
+
+/**
+ \brief Get base peak chromatogram.
+ \param chromatogram Populated with base peak intensity of scans at \p msLevel.
+ \param msLevel MS level of scans to include.
+ */
+void msInterface::RunSummary::getBPC(Chromatogram& chromatogram, int msLevel) const
+{
+    chromatogram.clear();
+    chromatogram.setId("BPC");
+    for(size_t i = 0; i < size(); i++)
+        if(level[i] == msLevel)
+            chromatogram.add(rt[i], basePeakIntensity[i]);
+}
@@ -0,0 +1,132 @@
+//
+// deisotoper.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <msInterface/deisotoper.hpp>
+
+using namespace utils;
+
+double const msInterface::Deisotoper::C13_DIFF = 1.0033548378;
+double const msInterface::Deisotoper::AVERAGINE_ISOTOPE_RATE = 0.000532;
+
+/**
+ \brief Deisotope \p scan in place. <br>
+
+ \p scan should be centroided. Peaks are sorted by m/z afterwards.
+ \param scan Scan to deisotope.
+ \param charges If not nullptr, populated with the charge of the cluster each peak in \p scan came from.
+ Peaks which were not part of a cluster have charge 0.
+ */
+void msInterface::Deisotoper::process(Scan& scan, std::vector<int>* charges) const
+{
+    scan.sortByMZ();
+    const auto& ions = scan.getIons();
+    size_t n = ions.size();
+    std::vector<double> mz(n), intensity(n);
+    for(size_t i = 0; i < n; i++) {
+        mz[i] = ions[i].getMZ();
+        intensity[i] = ions[i].getIntensity();
+    }
+
+    std::vector<bool> used(n, false);
+    std::vector<double> outMZ, outIntensity;
+    std::vector<int> outCharge;
+    outMZ.reserve(n);
+    outIntensity.reserve(n);
+    outCharge.reserve(n);
+    std::vector<size_t> cluster, best;
+    cluster.reserve(_maxPeaks);
+    best.reserve(_maxPeaks);
+
+    for(size_t i = 0; i < n; i++) {
+        if(used[i]) continue;
+        best.clear();
+        int bestCharge = 0;
+        for(int z = _maxCharge; z >= 1; z--) {
+            double lambda = (mz[i] - PROTON_MASS) * z * AVERAGINE_ISOTOPE_RATE;
+            cluster.assign(1, i);
+            for(size_t k = 1; k < _maxPeaks; k++) {
+                double target = mz[i] + (double)k * C13_DIFF / z;
+                double width = _tolerance.width(target);
+
+                // Find closest unused peak to target.
+                size_t next = n;
+                for(size_t j = std::lower_bound(mz.begin() + cluster.back() + 1, mz.end(), target - width) - mz.begin();
+                    j < n && mz[j] <= target + width; j++) {
+                    if(!used[j] && (next == n || std::abs(mz[j] - target) < std::abs(mz[next] - target)))
+                        next = j;
+                }
+                if(next == n) break;
+
+                // Ratio of Poisson probabilities of k and k - 1 heavy isotopes.
+                double expected = lambda / (double)k;
+                double observed = intensity[next] / intensity[cluster.back()];
+                if(!(observed <= expected * _ratioTolerance && observed >= expected / _ratioTolerance)) break;
+                cluster.push_back(next);
+            }
+            if(cluster.size() > best.size()) {
+                best.swap(cluster);
+                bestCharge = z;
+            }
+        }
+
+        if(best.size() >= std::max(_minPeaks, (size_t)2)) {
+            double sum = 0;
+            for(size_t j: best) {
+                used[j] = true;
+                sum += intensity[j];
+            }
+            outMZ.push_back((mz[i] - PROTON_MASS) * bestCharge + PROTON_MASS);
+            outIntensity.push_back(_sumIntensities ? sum : intensity[i]);
+            outCharge.push_back(bestCharge);
+        }
+        else if(_keepUnassigned) {
+            outMZ.push_back(mz[i]);
+            outIntensity.push_back(intensity[i]);
+            outCharge.push_back(0);
+        }
+    }
+
+    // Converting to singly charged m/z changes the order of peaks.
+    std::vector<size_t> order(outMZ.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&outMZ](size_t lhs, size_t rhs){
+        return outMZ[lhs] < outMZ[rhs];
+    });
+
+    auto& outIons = scan.getIons();
+    outIons.clear();
+    if(charges != nullptr) charges->resize(order.size());
+    for(size_t k = 0; k < order.size(); k++) {
+        outIons.emplace_back(outMZ[order[k]], outIntensity[order[k]]);
+        if(charges != nullptr) (*charges)[k] = outCharge[order[k]];
+    }
+    scan.updateRanges();
+}
@@ -143,6 +143,99 @@ int utils::internal::_b64_decode_mio( char *dest,  char *src, size_t size )
     }
 }
 
+/**
+ * Decode bytes \p offset to \p offset + \p size - 1 of base 64 encoded data
+ * without decoding the rest of \p src. <br><br>
+ * Every 4 characters of base 64 encode 3 bytes, so only the blocks containing the requested bytes are decoded.
+ * @param dest Buffer to write \p size decoded bytes to.
+ * @param src Pointer to encoded data. Does not need to be null terminated.
+ * @param srcLen Number of characters in \p src.
+ * @param offset Offset of first byte to decode in the decoded data.
+ * @param size Number of bytes to decode.
+ * @return false if the requested bytes are past the end of \p src.
+ */
+bool utils::internal::_b64_decode_range(char* dest, const char* src, size_t srcLen, size_t offset, size_t size)
+{
+    if(size == 0) return true;
+    size_t firstBlock = offset / 3;
+    size_t lastBlock = (offset + size - 1) / 3;
+    if((lastBlock + 1) * 4 > srcLen) return false;
+
+    // _b64_decode_mio stops at a null character, so copy the blocks into a null terminated buffer.
+    std::string encoded(src + firstBlock * 4, (lastBlock - firstBlock + 1) * 4);
+    std::string decoded((lastBlock - firstBlock + 1) * 3, '\0');
+    size_t decodedLen = (size_t)utils::internal::_b64_decode_mio(&decoded[0], &encoded[0], decoded.size());
+    size_t begin = offset - firstBlock * 3;
+    if(begin + size > decodedLen) return false;
+    memcpy(dest, decoded.data() + begin, size);
+    return true;
+}
+
+/**
+ * Base 64 encode \p size bytes of \p src.
+ * @param dest Buffer to write encoded data to. Must have room for at least 4 * ((\p size + 2) / 3) characters.
+ * @param src Pointer to data to encode.
+ * @param size Number of bytes in \p src.
+ * @return The number of characters written to \p dest.
+ */
+size_t utils::internal::_b64_encode(char* dest, const char* src, size_t size)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    auto* in = (const unsigned char*)src;
+    char* out = dest;
+    size_t i = 0;
+    for(; i + 2 < size; i += 3) {
+        *out++ = table[in[i] >> 2];
+        *out++ = table[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+        *out++ = table[((in[i + 1] & 0x0f) << 2) | (in[i + 2] >> 6)];
+        *out++ = table[in[i + 2] & 0x3f];
+    }
+    if(i < size) {
+        *out++ = table[in[i] >> 2];
+        if(i + 1 < size) {
+            *out++ = table[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+            *out++ = table[(in[i + 1] & 0x0f) << 2];
+        } else {
+            *out++ = table[(in[i] & 0x03) << 4];
+            *out++ = '=';
+        }
+        *out++ = '=';
+    }
+    return (size_t)(out - dest);
+}
+
+/**
+ * Base 64 encode \p size bytes of \p src and append the result to \p dest.
+ * @param dest String to append encoded data to.
+ * @param src Pointer to data to encode.
+ * @param size Number of bytes in \p src.
+ */
+void utils::internal::_b64_encode(std::string& dest, const char* src, size_t size)
+{
+    size_t begin = dest.size();
+    dest.resize(begin + 4 * ((size + 2) / 3));
+    _b64_encode(&dest[begin], src, size);
+}
+
+/**
+ * zlib compress \p size bytes of \p src.
+ * @param dest Overwritten with compressed data.
+ * @param src Pointer to data to compress.
+ * @param size Number of bytes in \p src.
+ */
+void utils::internal::_compress(std::string& dest, const char* src, size_t size)
+{
+#ifdef ENABLE_ZLIB
+    uLongf destLen = compressBound((uLong)size);
+    dest.resize(destLen);
+    if(compress((Bytef*)&dest[0], &destLen, (const Bytef*)src, (uLong)size) != Z_OK)
+        throw std::runtime_error("zlib compression failed!");
+    dest.resize(destLen);
+#else
+    throw std::runtime_error("zlib compression not enabled!");
+#endif
+}
+
 /**
  * Decode 32 bit base 64 binary m/z-int array.
  * The original version of this function was taken from mstoolkit
@@ -207,7 +300,7 @@ void utils::internal::_decode64(msInterface::Scan& scan,
                       size_t peaksCount,
                       bool bigEndian)
 {
-    size_t size = peaksCount * 2 * sizeof(uint32_t);
+    size_t size = peaksCount * 2 * sizeof(uint64_t);
     char *pDecoded = (char *) new char[size];
     memset(pDecoded, 0, size);
 
@@ -393,17 +486,17 @@ void utils::internal::BinaryData::decode(std::vector<double>& d) const
     //zlib decompression
     if(zlib) {
 #ifdef ENABLE_ZLIB
-        if(dataType == DataType::FLOAT_32) {
+        if(numpressLinear || numpressSlof || numpressPic) {
+            //don't know the unzipped size of numpressed data, so assume it to be no larger than unpressed 64-bit data
+            //plus the numpress header. (Linear prediction can be slightly larger for very short arrays.)
+            unzippedLen = peaksCount*sizeof(uint64_t) + 16;
+        } else if(dataType == DataType::FLOAT_32) {
             unzippedLen = peaksCount*sizeof(uint32_t);
         } else if(dataType == DataType::FLOAT_64) {
             unzippedLen = peaksCount*sizeof(uint64_t);
         } else {
-            if(!numpressLinear && !numpressSlof && !numpressPic){
-                std::cerr << "Unknown data format to unzip. Stopping file read." << NEW_LINE;
-                exit(EXIT_FAILURE);
-            }
-            //don't know the unzipped size of numpressed data, so assume it to be no larger than unpressed 64-bit data
-            unzippedLen = peaksCount*sizeof(uint64_t);
+            std::cerr << "Unknown data format to unzip. Stopping file read." << NEW_LINE;
+            exit(EXIT_FAILURE);
         }
 
         unzipped = new Bytef[unzippedLen];
@@ -590,6 +683,12 @@ void utils::internal::BinaryData::processBinaryArray(std::vector<double>& arr, r
     data = std::string(utils::internal::_getFirstChildNode("binary", node)->value());
     bigEndian = false;
 
+    // The same object is used for every array in a spectrum, so reset compression flags from the previous array.
+    zlib = false;
+    numpressLinear = false;
+    numpressSlof = false;
+    numpressPic = false;
+
     //iterate through cvParm(s)
     for (auto *cvParam = node->first_node("cvParam");
          cvParam; cvParam = cvParam->next_sibling("cvParam")) {
@@ -610,6 +709,11 @@ void utils::internal::BinaryData::processBinaryArray(std::vector<double>& arr, r
         else if(utils::internal::_getAttrValStr("accession", cvParam) == "MS:1002746") {
             zlib = true;
             numpressLinear = true;
+        }
+        //MS-Numpress positive integer compression followed by zlib compression
+        else if(utils::internal::_getAttrValStr("accession", cvParam) == "MS:1002747") {
+            zlib = true;
+            numpressPic = true;
         }
          //MS-Numpress short logged float compression followed by zlib compression
         else if(utils::internal::_getAttrValStr("accession", cvParam) == "MS:1002748") {
@@ -0,0 +1,134 @@
+//
+// sha1.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include <msInterface/internal/sha1.hpp>
+
+namespace {
+    inline uint32_t rotl(uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+}
+
+void utils::internal::Sha1::reset()
+{
+    _state[0] = 0x67452301;
+    _state[1] = 0xEFCDAB89;
+    _state[2] = 0x98BADCFE;
+    _state[3] = 0x10325476;
+    _state[4] = 0xC3D2E1F0;
+    _blockLen = 0;
+    _totalLen = 0;
+}
+
+void utils::internal::Sha1::_processBlock(const unsigned char* block)
+{
+    uint32_t w[80];
+    for(int i = 0; i < 16; i++)
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+    for(int i = 16; i < 80; i++)
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3], e = _state[4];
+    for(int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if(i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if(i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if(i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+    _state[4] += e;
+}
+
+//! Add \p len bytes of \p data to digest.
+void utils::internal::Sha1::update(const char* data, size_t len)
+{
+    auto* in = (const unsigned char*)data;
+    _totalLen += len;
+    if(_blockLen > 0) {
+        size_t n = std::min(len, 64 - _blockLen);
+        memcpy(_block + _blockLen, in, n);
+        _blockLen += n;
+        in += n;
+        len -= n;
+        if(_blockLen < 64) return;
+        _processBlock(_block);
+        _blockLen = 0;
+    }
+    for(; len >= 64; len -= 64, in += 64)
+        _processBlock(in);
+    memcpy(_block, in, len);
+    _blockLen = len;
+}
+
+/**
+ \brief Finish digest.
+
+ The digest is reset afterwards.
+ \return Digest as a 40 character lowercase hex string.
+ */
+std::string utils::internal::Sha1::hexDigest()
+{
+    uint64_t bitLen = _totalLen * 8;
+    unsigned char pad[72] = {0x80};
+    size_t padLen = (_blockLen < 56 ? 56 : 120) - _blockLen;
+    update((const char*)pad, padLen);
+    unsigned char lenBytes[8];
+    for(int i = 0; i < 8; i++)
+        lenBytes[i] = (unsigned char)(bitLen >> (56 - i * 8));
+    update((const char*)lenBytes, 8);
+
+    static const char hex[] = "0123456789abcdef";
+    std::string ret;
+    for(uint32_t word : _state)
+        for(int i = 28; i >= 0; i -= 4)
+            ret += hex[(word >> i) & 0xf];
+    reset();
+    return ret;
+}
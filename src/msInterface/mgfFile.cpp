@@ -0,0 +1,199 @@
+//
+// mgfFile.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <msInterface/mgfFile.hpp>
+
+using namespace utils;
+
+/**
+ \brief Check whether the line between \p line and \p eol is the parameter \p name.
+ \param line Beginning of line.
+ \param eol End of line.
+ \param name Parameter name including trailing '='.
+ \param value Set to the beginning of the parameter value if the line matches.
+ \return true if the line is the parameter \p name.
+ */
+bool msInterface::MgfFile::_isParam(const char* line, const char* eol, const char* name, const char*& value)
+{
+    size_t len = strlen(name);
+    if((size_t)(eol - line) < len || memcmp(line, name, len) != 0)
+        return false;
+    value = line + len;
+    return true;
+}
+
+/**
+ \brief Find the scan number of the block between \p begin and \p end.
+ \return The scan number or SCAN_INDEX_NOT_FOUND if the block does not specify one.
+ */
+size_t msInterface::MgfFile::_findScanNumber(const char* begin, const char* end) const
+{
+    size_t titleScan = SCAN_INDEX_NOT_FOUND;
+    const char* it = begin;
+    while(it < end) {
+        auto* eol = (const char*)memchr(it, '\n', end - it);
+        if(eol == nullptr) eol = end;
+        const char* line = it;
+        it = eol + 1;
+
+        // parameters come before the peak list
+        if(isdigit(*line)) break;
+
+        const char* value;
+        long scan;
+        if(_isParam(line, eol, "SCANS=", value)) {
+            if(parseLong(value, eol, scan) != value && scan >= 0)
+                return (size_t)scan;
+        } else if(_isParam(line, eol, "TITLE=", value)) {
+            // e.g. TITLE=sample.1234.1234.2 File:"sample.raw", NativeID:"controllerType=0 controllerNumber=1 scan=1234"
+            const char* scanStr = std::search(value, eol, "scan=", "scan=" + 5);
+            if(scanStr != eol && parseLong(scanStr + 5, eol, scan) != scanStr + 5 && scan >= 0)
+                titleScan = (size_t)scan;
+        }
+    }
+    return titleScan;
+}
+
+void msInterface::MgfFile::_buildIndex()
+{
+    //Check the file type
+    if(fileType != FileType::MGF)
+        throw utils::FileIOError("Incorrect file type for file: " + _fname);
+
+    std::vector<size_t> beginScans, endScans;
+    utils::getIdxOfSubstr(_buffer, "BEGIN IONS", beginScans);
+    utils::getIdxOfSubstr(_buffer, "END IONS", endScans);
+
+    //validate scan indices
+    if(beginScans.size() != endScans.size())
+        throw utils::FileIOError("Unbounded BEGIN IONS block in file: " + _fname);
+    size_t len = beginScans.size();
+    for(size_t i = 0; i < len; i++)
+        if(beginScans[i] >= endScans[i] || (i + 1 < len && endScans[i] >= beginScans[i + 1]))
+            throw utils::FileIOError("Unbounded BEGIN IONS block in file: " + _fname);
+
+    _scanCount = 0;
+    bool useOrdinal = false;
+    for(size_t i = 0; i < len; i++)
+    {
+        size_t scanNum = _findScanNumber(_buffer + beginScans[i], _buffer + endScans[i]);
+        if(scanNum == SCAN_INDEX_NOT_FOUND || _scanMap.find(scanNum) != _scanMap.end())
+            useOrdinal = true;
+        else _scanMap[scanNum] = _scanCount;
+        _offsetIndex.push_back(IntPair(beginScans[i], endScans[i]));
+        _scanCount++;
+    }
+    if(useOrdinal) {
+        _scanMap.clear();
+        for(size_t i = 0; i < _scanCount; i++)
+            _scanMap[i + 1] = i;
+    }
+
+    if(!_scanMap.empty()) {
+        firstScan = _scanMap.begin()->first;
+        lastScan = _scanMap.rbegin()->first;
+    }
+}
+
+/**
+ \brief Get parsed msInterface::Scan from mgf file.
+
+ \param queryScan scan number to search for
+ \param scan empty msInterface::Scan to load scan into
+ \return false if \p queryScan not found, true if successful
+ \throws utils::FileIOError if a peak line is invalid.
+ */
+bool msInterface::MgfFile::_getScan(size_t queryScan, Scan& scan) const
+{
+    scan.clear();
+    scan.getPrecursor().setSample(_parentFileBase);
+    scan.getPrecursor().setFile(_fname);
+    scan.setLevel(2);
+
+    size_t scanIndex = _getScanIndex(queryScan);
+    if(scanIndex == SCAN_INDEX_NOT_FOUND){
+        std::cerr << "queryScan: " << queryScan << ", could not be found in: " << _fname << NEW_LINE;
+        return false;
+    }
+    scan.setScanNum(queryScan);
+
+    const char* it = _buffer + _offsetIndex[scanIndex].first;
+    const char* end = _buffer + _offsetIndex[scanIndex].second;
+    auto& ions = scan.getIons();
+
+    while(it < end)
+    {
+        auto* lineEnd = (const char*)memchr(it, '\n', end - it);
+        if(lineEnd == nullptr) lineEnd = end;
+        const char* eol = lineEnd;
+        if(eol > it && *(eol - 1) == '\r') --eol;
+        const char* line = it;
+        it = lineEnd + 1;
+        if(line == eol) continue;
+
+        if(isdigit(*line)) {
+            double mz, intensity;
+            const char* c = parseDouble(line, eol, mz);
+            while(c < eol && (*c == ' ' || *c == '\t')) ++c;
+            const char* intBegin = c;
+            c = parseDouble(intBegin, eol, intensity);
+            if(c == intBegin) throw utils::FileIOError("Invalid peak in scan " + std::to_string(queryScan) +
+                                                       ": " + std::string(line, eol));
+            ions.emplace_back(mz, intensity);
+            continue;
+        }
+
+        const char* value;
+        if(_isParam(line, eol, "PEPMASS=", value)) {
+            const char* mzEnd = value;
+            while(mzEnd < eol && *mzEnd != ' ' && *mzEnd != '\t') ++mzEnd;
+            scan.getPrecursor().setMZ(std::string(value, mzEnd));
+            while(mzEnd < eol && (*mzEnd == ' ' || *mzEnd == '\t')) ++mzEnd;
+            double intensity;
+            if(parseDouble(mzEnd, eol, intensity) != mzEnd)
+                scan.getPrecursor().setIntensity(intensity);
+        }
+        else if(_isParam(line, eol, "CHARGE=", value)) {
+            // CHARGE=2+ or CHARGE=2+ and 3+. Only the first charge is used.
+            long charge;
+            const char* c = parseLong(value, eol, charge);
+            if(c != value) {
+                scan.getPrecursor().setCharge((int)std::abs(charge));
+                if(c < eol && *c == '-') scan.setPolarity(Polarity::NEGATIVE);
+                else if(c < eol && *c == '+') scan.setPolarity(Polarity::POSITIVE);
+            }
+        }
+        else if(_isParam(line, eol, "RTINSECONDS=", value)) {
+            double rt;
+            if(parseDouble(value, eol, rt) != value)
+                scan.getPrecursor().setRT(rt);
+        }
+    }
+    scan.updateRanges();
+
+    return true;
+}
@@ -29,10 +29,12 @@
 
 using namespace utils;
 
+size_t const msInterface::Ms2File::MAX_FIELDS;
+
 void msInterface::Ms2File::_buildIndex()
 {
     //Check the file type
-    if(fileType != FileType::MS2)
+    if(fileType != (_msLevel == 1 ? FileType::MS1 : FileType::MS2))
         throw utils::FileIOError("Incorrect file type for file: " + _fname);
 
     std::vector<size_t> scanIndecies;
@@ -65,7 +67,11 @@ bool msInterface::Ms2File::getMetaData()
     //find header in buffer and put it into ss
     std::stringstream ss;
     std::string line;
-    size_t end = utils::offset(_buffer, _size, "LastScan") + 100;
+    // If there is no LastScan header, only read up to the first scan.
+    size_t end = utils::offset(_buffer, _size, "LastScan");
+    if(end >= (size_t)_size)
+        end = _offsetIndex.empty() ? _size : _offsetIndex.front().first;
+    else end = std::min(end + 100, (size_t)_size);
     for(size_t i = 0; i < end; i++)
         ss.put(*(_buffer + i));
     std::streampos sLen = std::streampos(ss.str().length());
@@ -88,11 +94,50 @@ bool msInterface::Ms2File::getMetaData()
         }
     }
     
+    // Not every writer includes FirstScan and LastScan. (Especially for .ms1 files.)
+    // If they are missing, use the range of scans found in the index.
+    if(mdCount == 0 && !_scanMap.empty()) {
+        firstScan = _scanMap.begin()->first;
+        lastScan = _scanMap.rbegin()->first;
+        mdCount = MD_NUM;
+    }
+
     //check that md is good
     return firstScan <= lastScan &&
            mdCount == MD_NUM;
 }
 
+/**
+ \brief Split the tab delimited line between \p begin and \p end without copying it.
+ \param begin Beginning of line.
+ \param end End of line.
+ \param fields Populated with pointers to the beginning of each field.
+ \param fieldEnds Populated with pointers to the end of each field.
+ \return Number of fields in line. At most MAX_FIELDS fields are split.
+ */
+size_t msInterface::Ms2File::_splitLine(const char* begin, const char* end,
+                                        const char** fields, const char** fieldEnds)
+{
+    size_t n = 0;
+    const char* it = begin;
+    while(n < MAX_FIELDS) {
+        auto* fieldEnd = (const char*)memchr(it, IN_DELIM, end - it);
+        if(fieldEnd == nullptr) fieldEnd = end;
+        fields[n] = it;
+        fieldEnds[n] = fieldEnd;
+        n++;
+        if(fieldEnd == end) break;
+        it = fieldEnd + 1;
+    }
+    return n;
+}
+
+//! Check whether the \p len characters at \p s are equal to \p key.
+bool msInterface::Ms2File::_isKey(const char* key, const char* s, size_t len)
+{
+    return strlen(key) == len && memcmp(key, s, len) == 0;
+}
+
 /**
  \brief Get parsed msInterface::Spectrum from ms2 file.
  
@@ -101,12 +146,12 @@ bool msInterface::Ms2File::getMetaData()
  \return false if \p queryScan not found, true if successful
  \throws utils::FileIOError if the format of the .ms2 file is invalid.
  */
-bool msInterface::Ms2File::getScan(size_t queryScan, Scan& scan) const
+bool msInterface::Ms2File::_getScan(size_t queryScan, Scan& scan) const
 {
     scan.clear();
     scan.getPrecursor().setSample(_parentFileBase);
     scan.getPrecursor().setFile(_fname);
-    scan.setLevel(2);
+    scan.setLevel(_msLevel);
     if(!((queryScan >= firstScan) && (queryScan <= lastScan))){
         std::cerr << "queryScan not in file scan range!" << NEW_LINE;
         return false;
@@ -121,60 +166,86 @@ bool msInterface::Ms2File::getScan(size_t queryScan, Scan& scan) const
     scanOffset = _offsetIndex[scanIndex].first;
     endOfScan = _offsetIndex[scanIndex].second;
     
-    std::vector<std::string> elems;
-    std::string line;
-    size_t numIons = 0;
-    
-    std::string temp(_buffer + scanOffset,
-                     _buffer + scanOffset + (endOfScan - scanOffset));
-    std::stringstream ss(temp);
-    std::streampos oldPos = ss.tellg();
+    const char* it = _buffer + scanOffset;
+    const char* end = _buffer + endOfScan;
+    const char* fields[MAX_FIELDS];
+    const char* fieldEnds[MAX_FIELDS];
     bool z_found = false;
-    
-    while(utils::safeGetline(ss, line, oldPos))
+    bool inPeaks = false;
+    auto& ions = scan.getIons();
+
+    while(it < end)
     {
-        if(line.empty()) continue;
-        utils::split(line, IN_DELIM, elems);
-        
-        if(elems[0] == "S")
+        // find the end of the current line
+        auto* lineEnd = (const char*)memchr(it, '\n', end - it);
+        if(lineEnd == nullptr) lineEnd = end;
+        const char* eol = lineEnd;
+        if(eol > it && *(eol - 1) == '\r') --eol;
+        const char* line = it;
+        it = lineEnd + 1;
+        if(line == eol) continue;
+
+        if(inPeaks || isdigit(*line))
+        {
+            // Once the first peak is found, every remaining line in the scan is a peak.
+            inPeaks = true;
+            double mz, intensity;
+            const char* c = utils::parseDouble(line, eol, mz);
+            if(c == line) throw utils::FileIOError("Invalid number or elements.");
+            while(c < eol && (*c == ' ' || *c == '\t')) ++c;
+            const char* intBegin = c;
+            c = utils::parseDouble(intBegin, eol, intensity);
+            if(c == intBegin) throw utils::FileIOError("Invalid number or elements.");
+            ions.emplace_back(mz, intensity);
+            continue;
+        }
+
+        size_t nFields = _splitLine(line, eol, fields, fieldEnds);
+
+        // Record type is only recognized if it is the whole first field.
+        char recordType = fieldEnds[0] - fields[0] == 1 ? *fields[0] : '\0';
+        if(recordType == 'S')
         {
-            if(elems.size() != 4)
+            // S lines in .ms1 files do not have a precursor m/z
+            if(!(nFields == 4 || (_msLevel == 1 && nFields == 3)))
                 throw utils::FileIOError("Invalid number or elements.");
-            scan.setScanNum(std::stoi(elems[2]));
-            scan.getPrecursor().setMZ(elems[3]);
+            long scanNum;
+            if(utils::parseLong(fields[2], fieldEnds[2], scanNum) == fields[2])
+                throw utils::FileIOError("Invalid scan number: " + std::string(fields[2], fieldEnds[2]));
+            scan.setScanNum(scanNum);
+            if(nFields == 4)
+                scan.getPrecursor().setMZ(std::string(fields[3], fieldEnds[3]));
         }
-        else if(elems[0] == "I")
+        else if(recordType == 'I')
         {
-            if(elems.size() != 3) throw utils::FileIOError("Invalid number or elements.");
-            if(elems[1] == "RetTime")
-                scan.getPrecursor().setRT(std::stod(elems[2]));
-            else if(elems[1] == "PrecursorInt")
-                scan.getPrecursor().setIntensity(std::stod(elems[2]));
-            else if(elems[1] == "PrecursorFile")
-                scan.getPrecursor().setFile(utils::removeExtension(elems[2]));
-            else if(elems[1] == "PrecursorScan")
-                scan.getPrecursor().setScan(elems[2]);
+            if(nFields != 3) throw utils::FileIOError("Invalid number or elements.");
+            size_t keyLen = fieldEnds[1] - fields[1];
+            double value;
+            if(_isKey("RetTime", fields[1], keyLen)) {
+                if(utils::parseDouble(fields[2], fieldEnds[2], value) == fields[2])
+                    throw utils::FileIOError("Invalid RetTime: " + std::string(fields[2], fieldEnds[2]));
+                scan.getPrecursor().setRT(value);
+            }
+            else if(_isKey("PrecursorInt", fields[1], keyLen)) {
+                if(utils::parseDouble(fields[2], fieldEnds[2], value) == fields[2])
+                    throw utils::FileIOError("Invalid PrecursorInt: " + std::string(fields[2], fieldEnds[2]));
+                scan.getPrecursor().setIntensity(value);
+            }
+            else if(_isKey("PrecursorFile", fields[1], keyLen))
+                scan.getPrecursor().setFile(utils::removeExtension(std::string(fields[2], fieldEnds[2])));
+            else if(_isKey("PrecursorScan", fields[1], keyLen))
+                scan.getPrecursor().setScan(std::string(fields[2], fieldEnds[2]));
         }
-        else if(elems[0] == "Z"){
+        else if(recordType == 'Z'){
             if(!z_found){
-                if(elems.size() != 3) throw utils::FileIOError("");
-                scan.getPrecursor().setCharge(std::stoi(elems[1]));
+                if(nFields != 3) throw utils::FileIOError("");
+                long charge;
+                if(utils::parseLong(fields[1], fieldEnds[1], charge) == fields[1])
+                    throw utils::FileIOError("Invalid charge: " + std::string(fields[1], fieldEnds[1]));
+                scan.getPrecursor().setCharge((int)charge);
                 z_found = true;
             }
         }
-        else if(utils::isInteger(std::string(1, elems[0][0])))
-        {
-            ss.seekg(oldPos);
-            while(utils::safeGetline(ss, line))
-            {
-                if(line.empty()) continue;
-                
-                utils::split(line, ' ', elems);
-                if(elems.size() < 2) throw utils::FileIOError("Invalid number or elements.");
-                scan.getIons().emplace_back(std::stod(elems[0]), std::stod(elems[1]));
-                numIons++;
-            }//end of while
-        }//end of else
     }//end of while
     scan.updateRanges();
     
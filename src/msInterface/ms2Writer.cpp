@@ -0,0 +1,94 @@
+//
+// ms2Writer.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <cstdio>
+#include <ctime>
+
+#include <msInterface/ms2Writer.hpp>
+
+using namespace utils;
+
+bool msInterface::Ms2Writer::_accept(const Scan& scan) const {
+    return scan.getLevel() == 2;
+}
+
+void msInterface::Ms2Writer::_writeHeader(const Scan* firstScan)
+{
+    time_t now = time(nullptr);
+    std::string date = ctime(&now);
+    _write("H\tCreationDate\t" + trim(date) + NEW_LINE);
+    _write(std::string("H\tExtractor\t") + SOFTWARE_NAME + NEW_LINE);
+    _write(std::string("H\tExtractorVersion\t") + SOFTWARE_VERSION + NEW_LINE);
+    if(firstScan != nullptr && !firstScan->getPrecursor().getFile().empty())
+        _write("H\tSourceFile\t" + baseName(firstScan->getPrecursor().getFile()) + NEW_LINE);
+    _write("H\tFirstScan\t");
+    _firstScanOffset = _offset;
+    _write(_pad("0") + NEW_LINE);
+    _write("H\tLastScan\t");
+    _lastScanOffset = _offset;
+    _write(_pad("0") + NEW_LINE);
+}
+
+void msInterface::Ms2Writer::_writeFooter()
+{
+    if(!_index.empty()) {
+        _overwrite(_firstScanOffset, _pad(std::to_string(_minScan)));
+        _overwrite(_lastScanOffset, _pad(std::to_string(_maxScan)));
+    }
+}
+
+void msInterface::Ms2Writer::_encodeScan(const Scan& scan, size_t index, std::string& out) const
+{
+    const PrecursorScan& precursor = scan.getPrecursor();
+    std::string mz = precursor.getMZ().empty() ? "0" : precursor.getMZ();
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "S\t%06zu\t%06zu\t", scan.getScanNum(), scan.getScanNum());
+    out += buffer;
+    out += mz + NEW_LINE;
+    out += "I\tRetTime\t" + _toString(precursor.getRT() / 60) + NEW_LINE;
+    out += "I\tPrecursorInt\t" + _toString(precursor.getIntensity()) + NEW_LINE;
+    if(scan.getIonInjectionTime() != 0)
+        out += "I\tIonInjectionTime\t" + _toString(scan.getIonInjectionTime()) + NEW_LINE;
+    if(precursor.getActivationMethod() != ActivationMethod::UNKNOWN)
+        out += "I\tActivationType\t" + activationToString(precursor.getActivationMethod()) + NEW_LINE;
+    if(!precursor.getFile().empty())
+        out += "I\tPrecursorFile\t" + baseName(precursor.getFile()) + NEW_LINE;
+    if(!precursor.getScan().empty())
+        out += "I\tPrecursorScan\t" + precursor.getScan() + NEW_LINE;
+    // The Z line is left out if the precursor m/z is not a number, since the M+H can not be calculated.
+    double mzValue;
+    if(precursor.getCharge() > 0 && utils::parseDouble(mz.c_str(), mz.c_str() + mz.size(), mzValue) != mz.c_str()) {
+        double mh = (mzValue - PROTON_MASS) * precursor.getCharge() + PROTON_MASS;
+        snprintf(buffer, sizeof(buffer), "Z\t%d\t%.4f\n", precursor.getCharge(), mh);
+        out += buffer;
+    }
+    for(const auto& ion: scan) {
+        int len = snprintf(buffer, sizeof(buffer), "%.*f %.*f\n",
+                           _mzPrecision, ion.getMZ(), _intensityPrecision, ion.getIntensity());
+        out.append(buffer, std::min((size_t)len, sizeof(buffer) - 1));
+    }
+}
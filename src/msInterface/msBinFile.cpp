@@ -0,0 +1,414 @@
+//
+// msBinFile.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <unordered_map>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <msInterface/msBinFile.hpp>
+#include <msInterface/scanPrefetcher.hpp>
+
+using namespace utils;
+
+char const msInterface::MsBinFile::MAGIC[8] = {'P', 'U', 'M', 'S', 'B', 'I', 'N', '\0'};
+uint32_t const msInterface::MsBinFile::VERSION;
+
+static_assert(sizeof(msInterface::MsBinFile::Header) == 64, "Unexpected MsBinFile::Header size");
+static_assert(sizeof(msInterface::MsBinFile::ScanRecord) % 8 == 0, "MsBinFile::ScanRecord must be 8 byte aligned");
+
+namespace {
+    bool isLittleEndian() {
+        uint16_t i = 1;
+        return *((const char*)&i) == 1;
+    }
+
+    //! Pad \p outF with zeros until the next 8 byte boundary.
+    uint64_t alignOutput(std::ofstream& outF, uint64_t offset) {
+        static char const zeros[8] = {0};
+        uint64_t pad = (8 - (offset % 8)) % 8;
+        outF.write(zeros, pad);
+        return offset + pad;
+    }
+
+    /**
+     * Pack m/z or intensity values of \p scan into \p buffer as type \p T.
+     * @param mz Pack m/z values? If false, intensity values are packed.
+     */
+    template<typename T>
+    void packArray(const msInterface::Scan& scan, bool mz, std::string& buffer) {
+        const auto& ions = scan.getIons();
+        buffer.resize(ions.size() * sizeof(T));
+        T* out = (T*)&buffer[0];
+        for(size_t i = 0; i < ions.size(); i++)
+            out[i] = (T)(mz ? ions[i].getMZ() : ions[i].getIntensity());
+    }
+
+    void compressArray(const std::string& data, std::string& compressed) {
+#ifdef ENABLE_ZLIB
+        uLongf len = compressBound(data.size());
+        compressed.resize(len);
+        if(compress((Bytef*)&compressed[0], &len, (const Bytef*)data.data(), data.size()) != Z_OK)
+            throw std::runtime_error("zlib compression failed!");
+        compressed.resize(len);
+#else
+        throw std::runtime_error("zlib compression not enabled!");
+#endif
+    }
+
+    //! Is [\p offset, \p offset + \p len) inside a buffer of \p size bytes? Safe from overflow.
+    bool inBounds(uint64_t offset, uint64_t len, uint64_t size) {
+        return offset <= size && len <= size - offset;
+    }
+
+    /**
+     * Check that the arrays and strings of \p record are inside the file.
+     * @throws utils::FileIOError if \p record is corrupt.
+     */
+    void validateRecord(const msInterface::MsBinFile::ScanRecord& record, const msInterface::MsBinFile::Header& header,
+                        uint64_t fileSize) {
+        bool zlib = header.flags & msInterface::MsBinFile::ZLIB;
+        uint64_t offsets[] = {record.mzOffset, record.intensityOffset};
+        uint64_t nBytes[] = {record.mzBytes, record.intensityBytes};
+        uint64_t widths[] = {header.flags & msInterface::MsBinFile::FLOAT_MZ ? sizeof(float) : sizeof(double),
+                             header.flags & msInterface::MsBinFile::FLOAT_INTENSITY ? sizeof(float) : sizeof(double)};
+        for(int i = 0; i < 2; i++) {
+            if(!inBounds(offsets[i], nBytes[i], fileSize))
+                throw utils::FileIOError("Array of scan " + std::to_string(record.scanNum) + " is outside of MsBinFile.");
+            if(zlib) {
+                // zlib can not compress by more than a factor of 1032, so this bounds the decoded size.
+                if(record.peaksCount > (nBytes[i] + 64) * 1032 / widths[i])
+                    throw utils::FileIOError("Invalid peak count for scan " + std::to_string(record.scanNum));
+            }
+            else if(record.peaksCount > nBytes[i] / widths[i] || record.peaksCount * widths[i] != nBytes[i] ||
+                    offsets[i] % widths[i] != 0)
+                throw utils::FileIOError("Invalid array of scan " + std::to_string(record.scanNum));
+        }
+        for(int i = 0; i < 4; i++) {
+            if(!inBounds(record.stringOffsets[i], record.stringLengths[i], header.stringTableSize))
+                throw utils::FileIOError("String of scan " + std::to_string(record.scanNum) + " is outside of string table.");
+        }
+    }
+
+    uint32_t addString(const std::string& s, std::string& table,
+                       std::unordered_map<std::string, uint32_t>* seen = nullptr) {
+        if(seen) {
+            auto it = seen->find(s);
+            if(it != seen->end()) return it->second;
+        }
+        if(table.size() + s.size() > UINT32_MAX)
+            throw utils::FileIOError("MsBinFile string table is too large!");
+        auto offset = (uint32_t)table.size();
+        table += s;
+        if(seen) (*seen)[s] = offset;
+        return offset;
+    }
+}
+
+void msInterface::MsBinFile::_buildIndex()
+{
+    //Check the file type
+    if(fileType != FileType::MSBIN)
+        throw utils::FileIOError("Incorrect file type for file: " + _fname);
+    if(!isLittleEndian())
+        throw utils::FileIOError("MsBinFile is only supported on little endian systems.");
+
+    if((size_t)_size < sizeof(Header))
+        throw utils::FileIOError("Invalid MsBinFile header in: " + _fname);
+    const auto* header = (const Header*)_buffer;
+    if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw utils::FileIOError("Invalid MsBinFile header in: " + _fname);
+    if(header->version != VERSION)
+        throw utils::FileIOError("Unsupported MsBinFile version: " + std::to_string(header->version));
+    if(header->scanCount > (uint64_t)_size / sizeof(ScanRecord) ||
+       !inBounds(header->scanTableOffset, header->scanCount * sizeof(ScanRecord), _size) ||
+       header->scanTableOffset % 8 != 0 ||
+       !inBounds(header->stringTableOffset, header->stringTableSize, _size))
+        throw utils::FileIOError("Truncated MsBinFile: " + _fname);
+    _flags = header->flags;
+
+    _scanCount = 0;
+    const auto* records = (const ScanRecord*)(_buffer + header->scanTableOffset);
+    for(size_t i = 0; i < header->scanCount; i++) {
+        // Every record is checked once here, so scans can be read without bounds checks.
+        validateRecord(records[i], *header, _size);
+        size_t recordOffset = header->scanTableOffset + i * sizeof(ScanRecord);
+        _scanMap[records[i].scanNum] = _scanCount;
+        _offsetIndex.push_back(IntPair(recordOffset, recordOffset + sizeof(ScanRecord)));
+        _scanCount++;
+    }
+    if(!_scanMap.empty()) {
+        firstScan = _scanMap.begin()->first;
+        lastScan = _scanMap.rbegin()->first;
+    }
+}
+
+const msInterface::MsBinFile::ScanRecord* msInterface::MsBinFile::_getRecord(size_t queryScan) const
+{
+    size_t scanIndex = _getScanIndex(queryScan);
+    if(scanIndex == SCAN_INDEX_NOT_FOUND)
+        return nullptr;
+    return (const ScanRecord*)(_buffer + _offsetIndex[scanIndex].first);
+}
+
+/**
+ * Decode an array of type \p T into \p arr.
+ * @param data Pointer to array in buffer.
+ * @param nBytes Length of array in buffer.
+ * @param peaksCount Number of values in array.
+ * @param zlib Is the array zlib compressed?
+ * @param arr Populated with decoded values.
+ */
+template<typename T>
+void msInterface::MsBinFile::_decodeArray(const char* data, size_t nBytes, size_t peaksCount, bool zlib,
+                                          std::vector<double>& arr)
+{
+    arr.resize(peaksCount);
+    std::vector<T> unzipped;
+    if(zlib) {
+#ifdef ENABLE_ZLIB
+        unzipped.resize(peaksCount);
+        uLongf len = peaksCount * sizeof(T);
+        if(uncompress((Bytef*)unzipped.data(), &len, (const Bytef*)data, nBytes) != Z_OK ||
+           len != peaksCount * sizeof(T))
+            throw utils::FileIOError("Corrupted zlib array in MsBinFile.");
+        data = (const char*)unzipped.data();
+#else
+        throw std::runtime_error("zlib compression not enabled!");
+#endif
+    }
+    else if(nBytes != peaksCount * sizeof(T))
+        throw utils::FileIOError("Corrupted array in MsBinFile.");
+    const T* values = (const T*)data;
+    for(size_t i = 0; i < peaksCount; i++)
+        arr[i] = (double)values[i];
+}
+
+/**
+ \brief Get parsed msInterface::Scan from MsBinFile.
+
+ \param queryScan scan number to search for
+ \param scan empty msInterface::Scan to load scan into
+ \return false if \p queryScan not found, true if successful
+ */
+bool msInterface::MsBinFile::_getScan(size_t queryScan, Scan& scan) const
+{
+    scan.clear();
+    const ScanRecord* record = _getRecord(queryScan);
+    if(record == nullptr){
+        std::cerr << "queryScan: " << queryScan << ", could not be found in: " << _fname << NEW_LINE;
+        return false;
+    }
+
+    const auto* header = (const Header*)_buffer;
+    const char* strings = _buffer + header->stringTableOffset;
+    scan.setScanNum(record->scanNum);
+    scan.setLevel(record->level);
+    scan.setPolarity(static_cast<Polarity>(record->polarity));
+    scan.setIonInjectionTime(record->ionInjectionTime);
+    scan.setIMCV(record->ionMobilityCV);
+    scan.setIsIonMobilityScan(record->isIonMobilityScan != 0);
+    scan.setCentroided(record->profile == 0);
+    PrecursorScan& precursor = scan.getPrecursor();
+    precursor.setRT(record->rt);
+    precursor.setIntensity(record->precursorIntensity);
+    precursor.setCharge(record->charge);
+    precursor.setActivationMethod(static_cast<ActivationMethod>(record->activationMethod));
+    precursor.setMZ(std::string(strings + record->stringOffsets[0], record->stringLengths[0]));
+    precursor.setScan(std::string(strings + record->stringOffsets[1], record->stringLengths[1]));
+    precursor.setFile(std::string(strings + record->stringOffsets[2], record->stringLengths[2]));
+    precursor.setSample(std::string(strings + record->stringOffsets[3], record->stringLengths[3]));
+
+    size_t peaksCount = record->peaksCount;
+    auto& ions = scan.getIons();
+    ions.reserve(peaksCount);
+    bool zlib = _flags & ZLIB;
+    if(!zlib && !(_flags & FLOAT_MZ) && !(_flags & FLOAT_INTENSITY)) {
+        // Fast path. Arrays can be read directly from the buffer.
+        const auto* mz = (const double*)(_buffer + record->mzOffset);
+        const auto* intensity = (const double*)(_buffer + record->intensityOffset);
+        for(size_t i = 0; i < peaksCount; i++)
+            ions.emplace_back(mz[i], intensity[i]);
+    }
+    else {
+        std::vector<double> mz, intensity;
+        if(_flags & FLOAT_MZ)
+            _decodeArray<float>(_buffer + record->mzOffset, record->mzBytes, peaksCount, zlib, mz);
+        else _decodeArray<double>(_buffer + record->mzOffset, record->mzBytes, peaksCount, zlib, mz);
+        if(_flags & FLOAT_INTENSITY)
+            _decodeArray<float>(_buffer + record->intensityOffset, record->intensityBytes, peaksCount, zlib, intensity);
+        else _decodeArray<double>(_buffer + record->intensityOffset, record->intensityBytes, peaksCount, zlib, intensity);
+        for(size_t i = 0; i < peaksCount; i++)
+            ions.emplace_back(mz[i], intensity[i]);
+    }
+    scan.updateRanges();
+    return true;
+}
+
+/**
+ \brief Get pointers to the m/z and intensity arrays of \p queryScan without copying. <br>
+
+ Only possible if the file was written with 64 bit, uncompressed arrays.
+ The pointers are valid as long as the MsBinFile is not modified or destroyed.
+ \param queryScan Scan number.
+ \param mz Set to m/z array.
+ \param intensity Set to intensity array.
+ \param peaksCount Set to length of arrays.
+ \return false if \p queryScan was not found or the arrays are not stored as uncompressed 64 bit floats.
+ */
+bool msInterface::MsBinFile::getPeakArrays(size_t queryScan, const double*& mz, const double*& intensity,
+                                           size_t& peaksCount) const
+{
+    if(_flags != 0) return false;
+    const ScanRecord* record = _getRecord(queryScan);
+    if(record == nullptr) return false;
+    mz = (const double*)(_buffer + record->mzOffset);
+    intensity = (const double*)(_buffer + record->intensityOffset);
+    peaksCount = record->peaksCount;
+    return true;
+}
+
+/**
+ \brief Get peaks in m/z range directly from the memory mapped arrays. <br>
+
+ Files with compressed or 32 bit arrays fall back to decoding the whole scan.
+ */
+bool msInterface::MsBinFile::_getPeaksInRange(size_t queryScan, double lower, double upper,
+                                              std::vector<double>& mz, std::vector<double>& intensity) const
+{
+    const double* mzArray;
+    const double* intensityArray;
+    size_t peaksCount;
+    if(!getPeakArrays(queryScan, mzArray, intensityArray, peaksCount))
+        return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+
+    // Arrays are stored in the order they were read from the input file, which is not always sorted.
+    mz.clear();
+    intensity.clear();
+    std::vector<std::pair<double, double> > peaks;
+    for(size_t i = 0; i < peaksCount; i++)
+        if(mzArray[i] >= lower && mzArray[i] <= upper)
+            peaks.emplace_back(mzArray[i], intensityArray[i]);
+    std::sort(peaks.begin(), peaks.end());
+    for(const auto& peak: peaks) {
+        mz.push_back(peak.first);
+        intensity.push_back(peak.second);
+    }
+    return true;
+}
+
+/**
+ \brief Convert all scans in \p input to a MsBinFile.
+
+ \param input Initialized MsInterface to convert.
+ \param ofname Path of output file.
+ \param floatMZ Store m/z values as 32 bit floats?
+ \param floatIntensity Store intensity values as 32 bit floats?
+ \param zlib Compress m/z and intensity arrays of each scan with zlib?
+ \param nThread Number of threads to use for decoding \p input. If 0, the ScanPrefetcher default is used.
+ \return false if \p ofname could not be opened for writing.
+ */
+bool msInterface::MsBinFile::write(const MsInterface& input, const std::string& ofname,
+                                   bool floatMZ, bool floatIntensity, bool zlib, unsigned int nThread)
+{
+    if(!isLittleEndian())
+        throw utils::FileIOError("MsBinFile is only supported on little endian systems.");
+    std::ofstream outF(ofname, std::ios::out | std::ios::binary);
+    if(!outF) return false;
+
+    std::vector<size_t> scanNums;
+    input.getScanNumbers(scanNums);
+
+    // Reserve space for the header and scan table. They are written last.
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = (floatMZ ? FLOAT_MZ : 0) | (floatIntensity ? FLOAT_INTENSITY : 0) | (zlib ? ZLIB : 0);
+    header.scanTableOffset = sizeof(Header);
+    uint64_t offset = sizeof(Header) + scanNums.size() * sizeof(ScanRecord);
+    outF.write(std::string(offset, '\0').data(), offset);
+
+    std::vector<ScanRecord> records;
+    records.reserve(scanNums.size());
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> repeatedStrings;
+    std::string buffer, compressed;
+    ScanPrefetcher prefetcher(input, scanNums, ScanPrefetcher::DEFAULT_AHEAD, nThread);
+    Scan scan;
+    while(prefetcher.next(scan)) {
+        ScanRecord record{};
+        record.scanNum = scan.getScanNum();
+        record.peaksCount = scan.getIons().size();
+        record.rt = scan.getPrecursor().getRT();
+        record.precursorIntensity = scan.getPrecursor().getIntensity();
+        record.ionInjectionTime = scan.getIonInjectionTime();
+        record.ionMobilityCV = scan.getIMCV();
+        record.level = scan.getLevel();
+        record.polarity = utils::as_integer(scan.getPolarity());
+        record.charge = scan.getPrecursor().getCharge();
+        record.activationMethod = utils::as_integer(scan.getPrecursor().getActivationMethod());
+        record.isIonMobilityScan = scan.isIonMobilityScan();
+        record.profile = !scan.isCentroided();
+
+        // File and sample names are usually the same for every scan so they are only stored once.
+        std::string recordStrings[] = {scan.getPrecursor().getMZ(), scan.getPrecursor().getScan(),
+                                       scan.getPrecursor().getFile(), scan.getPrecursor().getSample()};
+        for(int i = 0; i < 4; i++) {
+            record.stringOffsets[i] = addString(recordStrings[i], strings, i >= 2 ? &repeatedStrings : nullptr);
+            record.stringLengths[i] = (uint32_t)recordStrings[i].size();
+        }
+
+        // write arrays
+        for(int i = 0; i < 2; i++) {
+            bool mz = i == 0;
+            if(mz ? floatMZ : floatIntensity)
+                packArray<float>(scan, mz, buffer);
+            else packArray<double>(scan, mz, buffer);
+            const std::string* data = &buffer;
+            if(zlib) {
+                compressArray(buffer, compressed);
+                data = &compressed;
+            }
+            (mz ? record.mzOffset : record.intensityOffset) = offset;
+            (mz ? record.mzBytes : record.intensityBytes) = data->size();
+            outF.write(data->data(), data->size());
+            offset = alignOutput(outF, offset + data->size());
+        }
+        records.push_back(record);
+    }
+
+    header.scanCount = records.size();
+    header.stringTableOffset = offset;
+    header.stringTableSize = strings.size();
+    outF.write(strings.data(), strings.size());
+
+    outF.seekp(0);
+    outF.write((const char*)&header, sizeof(Header));
+    outF.write((const char*)records.data(), records.size() * sizeof(ScanRecord));
+    return outF.good();
+}
@@ -24,6 +24,9 @@
 // -----------------------------------------------------------------------------
 //
 
+#include <algorithm>
+#include <thread>
+
 #include <msInterface/msInterface.hpp>
 
 using namespace utils;
@@ -33,8 +36,13 @@ msInterface::MsInterface::MsInterface(const msInterface::MsInterface &rhs) : Buf
     copyMetadata(rhs);
     _offsetIndex = rhs._offsetIndex;
     _scanMap = rhs._scanMap;
+    _parentScanMap = rhs._parentScanMap;
     _scanCount = rhs._scanCount;
     fileType = rhs.fileType;
+    if(rhs._scanCache)
+        enableScanCache(rhs._scanCache->getMaxBytes(), rhs._scanCache->getShardCount());
+    if(rhs._centroider)
+        enableCentroiding(*rhs._centroider);
 }
 
 //! Default constructor
@@ -49,13 +57,61 @@ msInterface::MsInterface::MsInterface(std::string fname) : BufferFile(fname) {
 msInterface::MsInterface &msInterface::MsInterface::operator=(const msInterface::MsInterface& rhs) {
     BufferFile::operator=(rhs);
     copyMetadata(rhs);
+    _offsetIndex = rhs._offsetIndex;
+    _scanMap = rhs._scanMap;
+    _parentScanMap = rhs._parentScanMap;
+    _scanCount = rhs._scanCount;
+    fileType = rhs.fileType;
+    if(rhs._scanCache)
+        enableScanCache(rhs._scanCache->getMaxBytes(), rhs._scanCache->getShardCount());
+    else disableScanCache();
+    if(rhs._centroider)
+        enableCentroiding(*rhs._centroider);
+    else disableCentroiding();
     return *this;
 }
 
 void msInterface::MsInterface::clear(){
     _offsetIndex.clear();
     _scanMap.clear();
+    _parentScanMap.clear();
     initMetadata();
+    if(_scanCache) _scanCache->clear();
+}
+
+/**
+ \brief Cache decoded scans so repeated calls to MsInterface::getScan for the same scan skip decoding. <br>
+
+ Any previously cached scans are discarded.
+ \param maxBytes Memory budget of cache in bytes.
+ \param nShards Number of independently locked shards. More shards reduce lock contention when
+ MsInterface::getScan is called from multiple threads.
+ */
+void msInterface::MsInterface::enableScanCache(size_t maxBytes, size_t nShards) {
+    _scanCache.reset(new ScanCache(maxBytes, nShards));
+}
+
+//! Disable scan cache and free any cached scans.
+void msInterface::MsInterface::disableScanCache() {
+    _scanCache.reset();
+}
+
+/**
+ \brief Centroid profile mode scans as they are read. <br>
+
+ After centroiding is enabled, MsInterface::getScan returns centroided peaks for profile mode scans.
+ Scans which are already centroided are not changed. Any previously cached scans are discarded.
+ \param centroider Centroiding parameters.
+ */
+void msInterface::MsInterface::enableCentroiding(const Centroider& centroider) {
+    _centroider.reset(new Centroider(centroider));
+    if(_scanCache) _scanCache->clear();
+}
+
+//! Return profile mode scans unchanged. Any previously cached scans are discarded.
+void msInterface::MsInterface::disableCentroiding() {
+    _centroider.reset();
+    if(_scanCache) _scanCache->clear();
 }
 
 bool msInterface::MsInterface::read(std::string fname) {
@@ -108,6 +164,12 @@ msInterface::MsInterface::FileType msInterface::MsInterface::getFileType(std::st
         return FileType::MZXML;
     else if(ext == "mzml")
         return FileType::MZML;
+    else if(ext == "msbin")
+        return FileType::MSBIN;
+    else if(ext == "ms1")
+        return FileType::MS1;
+    else if(ext == "mgf")
+        return FileType::MGF;
     else return FileType::UNKNOWN;
 }
 
@@ -126,6 +188,28 @@ size_t msInterface::MsInterface::_getScanIndex(size_t scan) const{
     return it->second;
 }
 
+/**
+ \brief Get parsed msInterface::Scan from file. <br>
+
+ If the scan cache is enabled, a cached copy of \p queryScan is returned when available.
+ Otherwise the scan is decoded from the file buffer, centroided if centroiding is enabled,
+ and added to the cache.
+ \param queryScan scan number to search for
+ \param scan empty msInterface::Scan to load scan into
+ \return false if \p queryScan not found, true if successful
+ */
+bool msInterface::MsInterface::getScan(size_t queryScan, Scan& scan) const {
+    if(_scanCache && _scanCache->get(queryScan, scan))
+        return true;
+    if(!_getScan(queryScan, scan))
+        return false;
+    if(_centroider && !scan.isCentroided())
+        _centroider->centroid(scan);
+    if(_scanCache)
+        _scanCache->insert(queryScan, scan);
+    return true;
+}
+
 /**
  \brief Overloaded function with \p queryScan as string
  */
@@ -133,6 +217,184 @@ bool msInterface::MsInterface::getScan(std::string queryScan, Scan& scan) const{
     return getScan(std::stoi(queryScan), scan);
 }
 
+/**
+ \brief Get the peaks in \p queryScan with m/z between \p lower and \p upper. <br>
+
+ Derived classes can override MsInterface::_getPeaksInRange to decode only part of the peak arrays.
+ If centroiding is enabled, peaks are always taken from the centroided scan returned by MsInterface::getScan.
+ \param queryScan Scan number.
+ \param lower Lower m/z bound (inclusive).
+ \param upper Upper m/z bound (inclusive).
+ \param mz Populated with m/z of peaks in range sorted by m/z.
+ \param intensity Populated with intensity of peaks in range.
+ \return false if \p queryScan could not be read.
+ */
+bool msInterface::MsInterface::getPeaksInRange(size_t queryScan, double lower, double upper,
+                                               std::vector<double>& mz, std::vector<double>& intensity) const
+{
+    if(_centroider)
+        return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+    return _getPeaksInRange(queryScan, lower, upper, mz, intensity);
+}
+
+/**
+ \brief Default implementation of MsInterface::getPeaksInRange which reads the whole scan with MsInterface::getScan.
+ */
+bool msInterface::MsInterface::_getPeaksInRange(size_t queryScan, double lower, double upper,
+                                                std::vector<double>& mz, std::vector<double>& intensity) const
+{
+    mz.clear();
+    intensity.clear();
+    Scan scan;
+    if(!getScan(queryScan, scan)) return false;
+    if(!scan.isSorted()) scan.sortByMZ();
+    auto range = scan.peaksInRange(lower, upper);
+    for(auto it = range.first; it != range.second; ++it) {
+        mz.push_back(it->getMZ());
+        intensity.push_back(it->getIntensity());
+    }
+    return true;
+}
+
+/**
+ \brief Populate row \p row of \p summary with summary statistics for \p queryScan. <br>
+
+ The default implementation reads the scan with MsInterface::getScan.
+ Derived classes can override this to avoid decoding the peak arrays.
+ \param queryScan Scan number.
+ \param summary RunSummary to populate. Has already been resized.
+ \param row Row of \p summary to populate.
+ \return false if \p queryScan could not be read.
+ */
+bool msInterface::MsInterface::_summarizeScan(size_t queryScan, RunSummary& summary, size_t row) const
+{
+    Scan scan;
+    if(!getScan(queryScan, scan)) return false;
+
+    double tic = 0, basePeakMZ = 0, basePeakIntensity = 0;
+    for(const auto& ion: scan) {
+        tic += ion.getIntensity();
+        if(ion.getIntensity() > basePeakIntensity) {
+            basePeakIntensity = ion.getIntensity();
+            basePeakMZ = ion.getMZ();
+        }
+    }
+    summary.level[row] = scan.getLevel();
+    summary.rt[row] = scan.getPrecursor().getRT();
+    summary.tic[row] = tic;
+    summary.basePeakMZ[row] = basePeakMZ;
+    summary.basePeakIntensity[row] = basePeakIntensity;
+    summary.peakCount[row] = scan.getIons().size();
+    if(scan.getLevel() > 1)
+        summary.setPrecursor(row, scan.getPrecursor());
+    return true;
+}
+
+/**
+ \brief Get the MS level, retention time, TIC, base peak and peak count of every scan in file. <br>
+
+ Scans are summarized in parallel. Use RunSummary::getTIC and RunSummary::getBPC to get
+ chromatograms from \p summary.
+ \param summary Populated with one row per scan, sorted by scan number.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::MsInterface::summarizeRun(RunSummary& summary, unsigned int nThread) const
+{
+    std::vector<size_t> scans;
+    getScanNumbers(scans);
+    summary.clear();
+    summary.resize(scans.size());
+    for(size_t i = 0; i < scans.size(); i++)
+        summary.scanNum[i] = scans[i];
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, scans.size()));
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < _nThread; t++) {
+        threads.emplace_back([this, t, _nThread, &scans, &summary] {
+            for(size_t i = t; i < scans.size(); i += _nThread)
+                _summarizeScan(scans[i], summary, i);
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
+
+/**
+ \brief Find the parent scan of every MSn scan in \p summary. <br>
+
+ The parent of a scan at MS level n is the precursor scan reported in the file if it is a scan at a
+ lower MS level in \p summary. Otherwise it is the closest preceding scan at MS level n - 1.
+ \param summary RunSummary of a run.
+ \param parents Populated with the scan number of the parent of each row in \p summary.
+ SCAN_INDEX_NOT_FOUND for MS1 scans and scans with no parent.
+ */
+void msInterface::MsInterface::getParentScans(const RunSummary& summary, std::vector<size_t>& parents)
+{
+    parents.assign(summary.size(), SCAN_INDEX_NOT_FOUND);
+    // Index of the last row seen at each MS level.
+    std::vector<size_t> lastRow;
+    for(size_t i = 0; i < summary.size(); i++) {
+        int level = summary.level[i];
+        if(level < 1) continue;
+        if(level > 1) {
+            size_t precursorScan = summary.precursorScan[i];
+            auto it = std::lower_bound(summary.scanNum.begin(), summary.scanNum.end(), precursorScan);
+            if(precursorScan != 0 && it != summary.scanNum.end() && *it == precursorScan
+               && summary.level[it - summary.scanNum.begin()] > 0
+               && summary.level[it - summary.scanNum.begin()] < level)
+                parents[i] = precursorScan;
+            else if((size_t)level - 2 < lastRow.size() && lastRow[level - 2] != SCAN_INDEX_NOT_FOUND)
+                parents[i] = summary.scanNum[lastRow[level - 2]];
+        }
+        if(lastRow.size() < (size_t)level)
+            lastRow.resize(level, SCAN_INDEX_NOT_FOUND);
+        lastRow[level - 1] = i;
+    }
+}
+
+/**
+ \brief Build an index of the parent scan of every MSn scan in file. <br>
+
+ MsInterface::summarizeRun is called first to get the MS level and precursor of each scan.
+ Use the other overload if a RunSummary for the file is already available.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::MsInterface::buildParentIndex(unsigned int nThread)
+{
+    RunSummary summary;
+    summarizeRun(summary, nThread);
+    buildParentIndex(summary);
+}
+
+/**
+ \brief Build an index of the parent scan of every MSn scan in \p summary.
+ \param summary RunSummary of file.
+ */
+void msInterface::MsInterface::buildParentIndex(const RunSummary& summary)
+{
+    std::vector<size_t> parents;
+    getParentScans(summary, parents);
+    _parentScanMap.clear();
+    for(size_t i = 0; i < parents.size(); i++)
+        if(parents[i] != SCAN_INDEX_NOT_FOUND)
+            _parentScanMap[summary.scanNum[i]] = parents[i];
+}
+
+/**
+ \brief Get the scan number of the parent scan of \p queryScan.
+
+ MsInterface::buildParentIndex must be called first.
+ \param queryScan Scan number of MSn scan.
+ \return Parent scan number or SCAN_INDEX_NOT_FOUND if \p queryScan has no known parent.
+ */
+size_t msInterface::MsInterface::getParentScan(size_t queryScan) const
+{
+    auto it = _parentScanMap.find(queryScan);
+    if(it == _parentScanMap.end()) return SCAN_INDEX_NOT_FOUND;
+    return it->second;
+}
+
 /**
  * Get the scan number of the next scan.
  * @param i Current scan.
@@ -158,3 +420,26 @@ size_t msInterface::MsInterface::prevScan(size_t i) const {
         throw std::out_of_range("Scan " + std::to_string(i) + " out of range.");
     return (++curScan)->first;
 }
+
+/**
+ * Get all scan numbers in file in ascending order.
+ * @param scans Populated with scan numbers.
+ */
+void msInterface::MsInterface::getScanNumbers(std::vector<size_t>& scans) const {
+    scans.clear();
+    scans.reserve(_scanMap.size());
+    for(auto& it: _scanMap)
+        scans.push_back(it.first);
+}
+
+/**
+ * Tell the OS that the bytes for \p queryScan will be read soon. <br>
+ * Has no effect unless the file buffer is memory mapped.
+ * @param queryScan Scan number.
+ */
+void msInterface::MsInterface::adviseScan(size_t queryScan) const {
+    size_t scanIndex = _getScanIndex(queryScan);
+    if(scanIndex == SCAN_INDEX_NOT_FOUND) return;
+    adviseWillNeed(_offsetIndex[scanIndex].first,
+                   _offsetIndex[scanIndex].second - _offsetIndex[scanIndex].first);
+}
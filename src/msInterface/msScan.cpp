@@ -25,10 +25,41 @@
 // -----------------------------------------------------------------------------
 //
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <msInterface/msScan.hpp>
 
 using namespace utils;
 
+namespace {
+    //! true if \p candidate is a better match for \p mz than \p best.
+    inline bool isBetterMatch(double candidateMZ, double candidateIntensity, double bestMZ, double bestIntensity,
+                              double mz, msInterface::PeakSelect select)
+    {
+        if(select == msInterface::PeakSelect::MOST_INTENSE)
+            return candidateIntensity > bestIntensity;
+        return std::abs(candidateMZ - mz) < std::abs(bestMZ - mz);
+    }
+
+    //! Index of the first element of \p mz at or after \p begin which is not less than \p lower.
+    inline size_t skipBelow(const msInterface::ScanMZ* mz, size_t begin, size_t n, msInterface::ScanMZ lower)
+    {
+#ifdef __SSE2__
+        // Compare two m/z values at a time until a pair is not entirely below lower.
+        __m128d bound = _mm_set1_pd(lower);
+        while(begin + 2 <= n && _mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(mz + begin), bound)) == 3)
+            begin += 2;
+#endif
+        while(begin < n && mz[begin] < lower) begin++;
+        return begin;
+    }
+}
+
 msInterface::Scan& msInterface::Scan::operator=(const msInterface::Scan& rhs) {
     _maxInt = rhs._maxInt;
     _minInt = rhs._minInt;
@@ -40,6 +71,11 @@ msInterface::Scan& msInterface::Scan::operator=(const msInterface::Scan& rhs) {
     _scanNum = rhs._scanNum;
     _level = rhs._level;
     _polarity = rhs._polarity;
+    _ionInjectionTime = rhs._ionInjectionTime;
+    _ionMobilityCV = rhs._ionMobilityCV;
+    _isIonMobilityScan = rhs._isIonMobilityScan;
+    _centroided = rhs._centroided;
+    _sortState = rhs._sortState;
     return *this;
 }
 
@@ -54,6 +90,30 @@ msInterface::Scan::Scan(const msInterface::Scan& rhs) {
     _scanNum = rhs._scanNum;
     _level = rhs._level;
     _polarity = rhs._polarity;
+    _ionInjectionTime = rhs._ionInjectionTime;
+    _ionMobilityCV = rhs._ionMobilityCV;
+    _isIonMobilityScan = rhs._isIonMobilityScan;
+    _centroided = rhs._centroided;
+    _sortState = rhs._sortState;
+}
+
+//! Exchange the contents of this scan with \p rhs without copying the ions.
+void msInterface::Scan::swap(msInterface::Scan& rhs) {
+    std::swap(_maxInt, rhs._maxInt);
+    std::swap(_minInt, rhs._minInt);
+    std::swap(_minMZ, rhs._minMZ);
+    std::swap(_maxMZ, rhs._maxMZ);
+    std::swap(_mzRange, rhs._mzRange);
+    std::swap(precursorScan, rhs.precursorScan);
+    _ions.swap(rhs._ions);
+    std::swap(_scanNum, rhs._scanNum);
+    std::swap(_level, rhs._level);
+    std::swap(_polarity, rhs._polarity);
+    std::swap(_ionInjectionTime, rhs._ionInjectionTime);
+    std::swap(_ionMobilityCV, rhs._ionMobilityCV);
+    std::swap(_isIonMobilityScan, rhs._isIonMobilityScan);
+    std::swap(_centroided, rhs._centroided);
+    std::swap(_sortState, rhs._sortState);
 }
 
 void msInterface::PrecursorScan::clear() {
@@ -61,8 +121,12 @@ void msInterface::PrecursorScan::clear() {
     _scan.clear();
     _rt = 0;
     _file.clear();
+    _sample.clear();
     _charge = 0;
     _intensity = 0;
+    _activationMethod = ActivationMethod::UNKNOWN;
+    _isolationLower = 0;
+    _isolationUpper = 0;
 }
 
 bool msInterface::PrecursorScan::operator==(const msInterface::PrecursorScan &rhs) const {
@@ -99,6 +163,11 @@ void msInterface::Scan::clear() {
     _level = 0;
     _polarity = Polarity::UNKNOWN;
     _scanNum = std::string::npos;
+    _ionInjectionTime = 0;
+    _ionMobilityCV = 0;
+    _isIonMobilityScan = false;
+    _centroided = true;
+    _sortState = SortState::SORTED;
     precursorScan.clear();
     _ions.clear();
 }
@@ -112,8 +181,9 @@ void msInterface::Scan::setMaxMZ(ScanMZ maxMZ) {
     _mzRange = (_maxMZ - _minMZ);
 }
 
-//! Updates minimum and maximum mz and intensity.
+//! Updates minimum and maximum mz and intensity, and whether ions are sorted by m/z.
 void msInterface::Scan::updateRanges(){
+    _sortState = SortState::SORTED;
     if(!_ions.empty()) {
         _minMZ = _ions.begin()->getMZ();
         _minInt = _ions.begin()->getIntensity();
@@ -121,6 +191,8 @@ void msInterface::Scan::updateRanges(){
         _maxMZ = 0;
 
         for(auto & _ion : _ions) {
+            if (_ion.getMZ() < _maxMZ)
+                _sortState = SortState::UNSORTED;
             if (_ion.getMZ() < _minMZ)
                 _minMZ = _ion.getMZ();
             if (_ion.getMZ() > _maxMZ)
@@ -135,10 +207,14 @@ void msInterface::Scan::updateRanges(){
 }
 
 void msInterface::Scan::add(const ScanIon& ion) {
+    if(_sortState == SortState::SORTED && !_ions.empty() && ion.getMZ() < _ions.back().getMZ())
+        _sortState = SortState::UNSORTED;
     _ions.push_back(ion);
 }
 
 void msInterface::Scan::add(ScanMZ mz, ScanIntensity intensity) {
+    if(_sortState == SortState::SORTED && !_ions.empty() && mz < _ions.back().getMZ())
+        _sortState = SortState::UNSORTED;
     _ions.emplace_back(mz, intensity);
 }
 
@@ -279,3 +355,167 @@ void msInterface::Scan::printIons(std::ostream& out, char sep){
     for(auto & _ion : _ions) out << _ion.getMZ() << sep << _ion.getIntensity() << NEW_LINE;
 }
 
+
+/**
+ * Approximate number of bytes of memory used by scan, including heap allocated ion and string storage.
+ * @return Memory usage in bytes.
+ */
+size_t msInterface::Scan::memoryUsage() const {
+    return sizeof(Scan) +
+           _ions.capacity() * sizeof(ScanIon) +
+           precursorScan.getMZ().capacity() +
+           precursorScan.getScan().capacity() +
+           precursorScan.getFile().capacity() +
+           precursorScan.getSample().capacity();
+}
+
+/**
+ \brief Check whether ions are sorted by m/z. <br>
+
+ The sort state is tracked by Scan::add, Scan::updateRanges and Scan::sortByMZ, so this is
+ usually constant time. After the ions are exposed through a non-const accessor
+ (such as Scan::getIons) the ions are checked in linear time until one of those functions is called.
+ */
+bool msInterface::Scan::isSorted() const {
+    if(_sortState != SortState::UNKNOWN)
+        return _sortState == SortState::SORTED;
+    return std::is_sorted(_ions.begin(), _ions.end(), ScanIon::MZComparison());
+}
+
+//! Sort ions by m/z. Ions with equal m/z keep their relative order.
+void msInterface::Scan::sortByMZ() {
+    if(!isSorted())
+        std::stable_sort(_ions.begin(), _ions.end(), ScanIon::MZComparison());
+    _sortState = SortState::SORTED;
+}
+
+/**
+ \brief Find the peak matching \p mz. <br>
+
+ Uses a binary search if ions are sorted by m/z, otherwise a linear search.
+ \param mz m/z to search for.
+ \param tolerance Match tolerance.
+ \param select Peak to choose if more than one peak is inside the tolerance window.
+ \return Index of matching peak in Scan::getIons or msInterface::PEAK_NOT_FOUND.
+ */
+size_t msInterface::Scan::findPeak(ScanMZ mz, const MZTolerance& tolerance, PeakSelect select) const
+{
+    return _findPeak(mz, tolerance, select, isSorted());
+}
+
+/**
+ \brief Implementation of Scan::findPeak where whether the ions are sorted has already been checked.
+ \param sorted Are ions sorted by m/z? Computed once by the caller, because Scan::isSorted can be O(n).
+ */
+size_t msInterface::Scan::_findPeak(ScanMZ mz, const MZTolerance& tolerance, PeakSelect select, bool sorted) const
+{
+    double width = tolerance.width(mz);
+    ScanMZ lower = mz - width;
+    ScanMZ upper = mz + width;
+    size_t begin = 0;
+    if(sorted)
+        begin = std::lower_bound(_ions.begin(), _ions.end(), lower, ScanIon::MZComparison()) - _ions.begin();
+
+    size_t ret = PEAK_NOT_FOUND;
+    for(size_t i = begin; i < _ions.size(); i++) {
+        ScanMZ peakMZ = _ions[i].getMZ();
+        if(peakMZ > upper) {
+            if(sorted) break;
+            continue;
+        }
+        if(peakMZ < lower) continue;
+        if(ret == PEAK_NOT_FOUND ||
+           isBetterMatch(peakMZ, _ions[i].getIntensity(), _ions[ret].getMZ(), _ions[ret].getIntensity(), mz, select))
+            ret = i;
+    }
+    return ret;
+}
+
+/**
+ \brief Get the ions with m/z in the closed range [\p lower, \p upper].
+
+ \param lower Lower m/z bound.
+ \param upper Upper m/z bound.
+ \return Pair of iterators to the first ion in range and one past the last ion in range.
+ \throws std::runtime_error if ions are not sorted by m/z.
+ */
+std::pair<msInterface::Scan::IonsType::const_iterator, msInterface::Scan::IonsType::const_iterator>
+msInterface::Scan::peaksInRange(ScanMZ lower, ScanMZ upper) const
+{
+    if(!isSorted())
+        throw std::runtime_error("Scan ions are not sorted by m/z! Call Scan::sortByMZ first.");
+    auto begin = std::lower_bound(_ions.begin(), _ions.end(), lower, ScanIon::MZComparison());
+    auto end = std::upper_bound(begin, _ions.end(), upper, [](ScanMZ mz, const ScanIon& ion){
+        return mz < ion.getMZ();
+    });
+    return std::make_pair(begin, end);
+}
+
+/**
+ \brief Find the matching peak for each m/z in \p queries. <br>
+
+ When there are few queries compared to the number of ions, each query is found with a binary search.
+ Otherwise the ion m/z and intensities are copied to contiguous arrays and the queries and ions are
+ walked through together in a single linear merge. Where SSE2 is available, ions below each query window
+ are skipped two at a time. Ions do not need to be sorted.
+ \param queries m/z values to search for sorted in ascending order.
+ \param tolerance Match tolerance.
+ \param matches Populated with the index in Scan::getIons of the peak matching each query,
+ or msInterface::PEAK_NOT_FOUND.
+ \param select Peak to choose if more than one peak is inside the tolerance window.
+ \throws std::invalid_argument if \p queries are not sorted.
+ */
+void msInterface::Scan::matchPeaks(const std::vector<ScanMZ>& queries, const MZTolerance& tolerance,
+                                   std::vector<size_t>& matches, PeakSelect select) const
+{
+    if(!std::is_sorted(queries.begin(), queries.end()))
+        throw std::invalid_argument("Scan::matchPeaks queries must be sorted!");
+    size_t nQueries = queries.size();
+    size_t nIons = _ions.size();
+    matches.assign(nQueries, PEAK_NOT_FOUND);
+    if(nQueries == 0 || nIons == 0) return;
+
+    bool sorted = isSorted();
+    if(sorted && (double)nQueries * std::log2((double)nIons + 1) < (double)nIons) {
+        for(size_t q = 0; q < nQueries; q++)
+            matches[q] = _findPeak(queries[q], tolerance, select, true);
+        return;
+    }
+
+    // Copy ions to separate m/z and intensity arrays, sorting by m/z if necessary.
+    std::vector<size_t> order;
+    std::vector<ScanMZ> mz(nIons);
+    std::vector<ScanIntensity> intensity(nIons);
+    if(!sorted) {
+        order.resize(nIons);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs){
+            return _ions[lhs].getMZ() < _ions[rhs].getMZ();
+        });
+    }
+    for(size_t i = 0; i < nIons; i++) {
+        const ScanIon& ion = _ions[sorted ? i : order[i]];
+        mz[i] = ion.getMZ();
+        intensity[i] = ion.getIntensity();
+    }
+
+    // Both bounds increase with the query m/z, so the first candidate ion never moves backwards.
+    std::vector<ScanMZ> lower(nQueries), upper(nQueries);
+    for(size_t q = 0; q < nQueries; q++) {
+        double width = tolerance.width(queries[q]);
+        lower[q] = queries[q] - width;
+        upper[q] = queries[q] + width;
+    }
+    size_t begin = 0;
+    for(size_t q = 0; q < nQueries; q++) {
+        begin = skipBelow(mz.data(), begin, nIons, lower[q]);
+        size_t best = PEAK_NOT_FOUND;
+        for(size_t i = begin; i < nIons && mz[i] <= upper[q]; i++) {
+            if(best == PEAK_NOT_FOUND ||
+               isBetterMatch(mz[i], intensity[i], mz[best], intensity[best], queries[q], select))
+                best = i;
+        }
+        if(best != PEAK_NOT_FOUND)
+            matches[q] = sorted ? best : order[best];
+    }
+}
@@ -0,0 +1,270 @@
+//
+// msWriter.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <cstdio>
+#include <exception>
+#include <limits>
+
+#include <msInterface/msWriter.hpp>
+#include <msInterface/scanPrefetcher.hpp>
+#include <msInterface/internal/sha1.hpp>
+
+// Set from the project version by CMake
+#ifndef PEPTIDE_UTILS_VERSION
+#define PEPTIDE_UTILS_VERSION "UNKNOWN"
+#endif
+
+using namespace utils;
+
+size_t const msInterface::MsWriter::DEFAULT_BATCH_SIZE;
+size_t const msInterface::MsWriter::PLACEHOLDER_WIDTH;
+char const* const msInterface::MsWriter::SOFTWARE_NAME = "peptideUtils";
+char const* const msInterface::MsWriter::SOFTWARE_VERSION = PEPTIDE_UTILS_VERSION;
+
+/**
+ \brief Constructor.
+ \param nThread Number of threads to use to encode scans. If 0, \p std::thread::hardware_concurrency() threads are used.
+ \param batchSize Number of scans to encode at a time.
+ */
+msInterface::MsWriter::MsWriter(unsigned int nThread, size_t batchSize)
+{
+    _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    if(_nThread == 0) _nThread = 1;
+    _batch = std::vector<Scan>(std::max(batchSize, (size_t)1));
+    _encoded = std::vector<std::string>(_batch.size());
+    _batchCount = 0;
+    _offset = 0;
+    _headerWritten = false;
+    _minScan = std::numeric_limits<size_t>::max();
+    _maxScan = 0;
+}
+
+/**
+ \brief Open \p fname for writing. Any existing file is overwritten.
+ \param fname Path of file to write.
+ \return true if the file was successfully opened.
+ */
+bool msInterface::MsWriter::open(const std::string& fname)
+{
+    if(_out.is_open()) close();
+    _fname = fname;
+    _out.open(fname, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    _offset = 0;
+    _headerWritten = false;
+    _batchCount = 0;
+    _index.clear();
+    _minScan = std::numeric_limits<size_t>::max();
+    _maxScan = 0;
+    return _out.is_open();
+}
+
+/**
+ \brief Add \p scan to the file. <br>
+
+ \p scan is copied into the current batch and is written when the batch is full or MsWriter::close is called.
+ \param scan Scan to write.
+ \return false if \p scan can not be represented in the output format and was skipped.
+ \throws utils::FileIOError if the file is not open.
+ */
+bool msInterface::MsWriter::write(const Scan& scan)
+{
+    if(!_out.is_open())
+        throw FileIOError("Output file is not open!");
+    if(!_accept(scan)) return false;
+    _batch[_batchCount++] = scan;
+    if(_batchCount == _batch.size())
+        _flush();
+    return true;
+}
+
+/**
+ \brief Write every scan in \p file in ascending scan number order.
+ \param file Initialized MsInterface to read scans from.
+ \return Number of scans written.
+ */
+size_t msInterface::MsWriter::write(const MsInterface& file)
+{
+    ScanPrefetcher prefetcher(file);
+    Scan scan;
+    size_t nWritten = 0;
+    while(prefetcher.next(scan))
+        if(write(scan)) nWritten++;
+    return nWritten;
+}
+
+//! Write any buffered scans, the file footer and close the file.
+void msInterface::MsWriter::close()
+{
+    if(!_out.is_open()) return;
+    _flush();
+    if(!_headerWritten) {
+        _writeHeader(nullptr);
+        _headerWritten = true;
+    }
+    _writeFooter();
+    _out.close();
+}
+
+//! Encode the scans in the current batch in parallel and write them to the file in order.
+void msInterface::MsWriter::_flush()
+{
+    if(!_headerWritten) {
+        _writeHeader(_batchCount > 0 ? &_batch[0] : nullptr);
+        _headerWritten = true;
+    }
+    if(_batchCount == 0) return;
+
+    size_t firstIndex = _index.size();
+    unsigned int nThread = (unsigned int)std::min((size_t)_nThread, _batchCount);
+    std::vector<std::exception_ptr> errors(nThread);
+    auto encode = [this, firstIndex, nThread, &errors](unsigned int thread) {
+        try {
+            for(size_t i = thread; i < _batchCount; i += nThread) {
+                _encoded[i].clear();
+                _encodeScan(_batch[i], firstIndex + i, _encoded[i]);
+            }
+        } catch(...) {
+            errors[thread] = std::current_exception();
+        }
+    };
+    if(nThread == 1) encode(0);
+    else {
+        std::vector<std::thread> threads;
+        for(unsigned int i = 0; i < nThread; i++)
+            threads.emplace_back(encode, i);
+        for(auto& t: threads)
+            t.join();
+    }
+    for(auto& e: errors)
+        if(e) std::rethrow_exception(e);
+
+    for(size_t i = 0; i < _batchCount; i++) {
+        size_t scanNum = _batch[i].getScanNum();
+        size_t begin = _encoded[i].find_first_not_of(" \t\r\n");
+        _index.emplace_back(scanNum, _offset + (begin == std::string::npos ? 0 : begin));
+        _minScan = std::min(_minScan, scanNum);
+        _maxScan = std::max(_maxScan, scanNum);
+        _write(_encoded[i]);
+    }
+    _batchCount = 0;
+}
+
+void msInterface::MsWriter::_write(const std::string& s)
+{
+    _out.write(s.data(), s.size());
+    _offset += s.size();
+}
+
+/**
+ \brief Overwrite bytes already written to the file. The output position is restored afterwards.
+ \param offset Offset in file to begin writing at.
+ \param s String to write.
+ */
+void msInterface::MsWriter::_overwrite(size_t offset, const std::string& s)
+{
+    _out.seekp(offset);
+    _out.write(s.data(), s.size());
+    _out.seekp(0, std::ios::end);
+}
+
+//! SHA-1 digest of everything written to the file so far.
+std::string msInterface::MsWriter::_sha1()
+{
+    _out.flush();
+    _out.seekg(0);
+    internal::Sha1 sha1;
+    std::vector<char> buffer(1 << 20);
+    size_t remaining = _offset;
+    while(remaining > 0) {
+        size_t n = std::min(remaining, buffer.size());
+        _out.read(buffer.data(), n);
+        if((size_t)_out.gcount() != n)
+            throw FileIOError("Failed to read back: " + _fname);
+        sha1.update(buffer.data(), n);
+        remaining -= n;
+    }
+    _out.seekp(0, std::ios::end);
+    return sha1.hexDigest();
+}
+
+//! Right pad \p s with spaces to \p width.
+std::string msInterface::MsWriter::_pad(std::string s, size_t width)
+{
+    if(s.size() < width) s.append(width - s.size(), ' ');
+    return s;
+}
+
+//! Escape \p s for use in XML text or an attribute value.
+std::string msInterface::MsWriter::_escapeXml(const std::string& s)
+{
+    std::string ret;
+    ret.reserve(s.size());
+    for(char c: s) {
+        switch(c) {
+            case '&': ret += "&amp;";
+                break;
+            case '<': ret += "&lt;";
+                break;
+            case '>': ret += "&gt;";
+                break;
+            case '"': ret += "&quot;";
+                break;
+            case '\'': ret += "&apos;";
+                break;
+            default: ret += c;
+        }
+    }
+    return ret;
+}
+
+std::string msInterface::MsWriter::_toString(double value, int precision)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    return std::string(buffer);
+}
+
+/**
+ \brief Calculate total ion current and base peak of \p scan.
+ \param scan Scan to summarize.
+ \param tic Set to sum of ion intensities.
+ \param basePeakMZ Set to m/z of most intense ion.
+ \param basePeakInt Set to intensity of most intense ion.
+ */
+void msInterface::MsWriter::_summarize(const Scan& scan, double& tic, double& basePeakMZ, double& basePeakInt)
+{
+    tic = 0;
+    basePeakMZ = 0;
+    basePeakInt = 0;
+    for(const auto& ion: scan) {
+        tic += ion.getIntensity();
+        if(ion.getIntensity() > basePeakInt) {
+            basePeakInt = ion.getIntensity();
+            basePeakMZ = ion.getMZ();
+        }
+    }
+}
@@ -25,6 +25,8 @@
 // -----------------------------------------------------------------------------
 //
 
+#include <algorithm>
+
 #include <msInterface/mzMLFile.hpp>
 
 using namespace utils;
@@ -99,6 +101,148 @@ void msInterface::MzMLFile::_buildIndex()
     firstScan = _scanMap.begin()->first;
     lastScan = _scanMap.rbegin()->first;
     assert(firstScan <= lastScan);
+
+    // Chromatograms always come after the spectra, so there is no need to search from the beginning of the file.
+    _chromatogramIndex.clear();
+    _chromatogramIds.clear();
+    size_t chromatogramStart = endScans.empty() ? 0 : endScans.back();
+    std::vector<size_t> beginChromatograms;
+    std::vector<size_t> endChromatograms;
+    getIdxOfSubstr(_buffer + chromatogramStart, "<chromatogram ", beginChromatograms);
+    getIdxOfSubstr(_buffer + chromatogramStart, "</chromatogram>", endChromatograms);
+    if(beginChromatograms.size() > endChromatograms.size())
+        throw InvalidXmlFile("Unbounded <chromatogram> in file: " + _fname);
+    for(size_t i = 0; i < beginChromatograms.size(); i++)
+    {
+        char* c = _buffer + chromatogramStart + beginChromatograms[i];
+        char* id = strstr(c, "id=\"");
+        char* endNode = strchr(c, '>');
+        if(id == nullptr || id >= endNode)
+            throw InvalidXmlFile("Not able to find required attribute \'id\' in <chromatogram>");
+        id += 4;
+        char* endId = strchr(id, '\"');
+        if(endId == nullptr || endId >= endNode)
+            throw InvalidXmlFile("Unterminated \'id\' attribute in <chromatogram>");
+        _chromatogramIds.emplace_back(id, endId);
+        _chromatogramIndex.push_back(IntPair(chromatogramStart + beginChromatograms[i],
+                                             chromatogramStart + endChromatograms[i]));
+    }
+}
+
+/**
+ \brief Decode the binary data arrays of a <spectrum> or <chromatogram> node.
+
+ \param root <spectrum> or <chromatogram> node.
+ \param xAccession Accession of the x axis array. (MS:1000514 for m/z, MS:1000595 for time)
+ \param xName Name of x axis array to use in error messages.
+ \param id Spectrum or chromatogram id to use in error messages.
+ \param x Populated with x axis array.
+ \param intensity Populated with intensity array.
+ \param xUnit If not nullptr, populated with the unitAccession of the x axis array.
+ \throws InvalidXmlFile if only one of the arrays is found or the arrays have different lengths.
+ */
+void msInterface::MzMLFile::_decodeArrays(rapidxml::xml_node<>* root, const char* xAccession, const char* xName,
+                                          const std::string& id, std::vector<double>& x, std::vector<double>& intensity,
+                                          std::string* xUnit)
+{
+    x.clear();
+    intensity.clear();
+    auto* binaryDataArrayNode = internal::_getFirstChildNode("binaryDataArrayList", root);
+    bool parsed_x = false, parsed_intensity = false;
+    internal::BinaryData binaryParser;
+    size_t defaultArrayLength = internal::_getAttrValInt("defaultArrayLength", root);
+    binaryParser.setPeaksCount(defaultArrayLength);
+    for(auto* node = binaryDataArrayNode->first_node("binaryDataArray");
+        node; node = node->next_sibling("binaryDataArray")) {
+        for(auto* cvParam = node->first_node("cvParam"); cvParam; cvParam = cvParam->next_sibling("cvParam")){
+            std::string accession = internal::_getAttrValStr("accession", cvParam);
+            if(accession == xAccession) {
+                if(xUnit != nullptr) {
+                    auto* unit = cvParam->first_attribute("unitAccession");
+                    *xUnit = unit ? unit->value() : "";
+                }
+                binaryParser.processBinaryArray(x, node);
+                parsed_x = true;
+                break;
+            }
+            else if(accession == "MS:1000515") { // intensity array
+                binaryParser.processBinaryArray(intensity, node);
+                parsed_intensity = true;
+                break;
+            }
+        }
+    }
+    size_t len = x.size();
+    if(len > 0) {
+        if(!(parsed_x && parsed_intensity))
+            throw InvalidXmlFile("ERROR In: " + id +"\n\tNever found array(s) for: " +
+                                 (parsed_x ? "" : xName) + (!parsed_intensity && !parsed_x ? " or " : "") +
+                                 (parsed_intensity ? "" : "intensity"));
+        if(len != intensity.size())
+            throw InvalidXmlFile("ERROR In: " + id +"\n\t" + xName + " and intensity lengths do not match! " +
+                                 xName + ": " + std::to_string(len) + ", int: " + std::to_string(intensity.size()));
+    }
+}
+
+/**
+ \brief Parse the first precursor in a \p <precursorList> node.
+ \param precursorList \p <precursorList> node.
+ \param precursor Populated with precursor scan, m/z, charge, intensity, activation method and isolation window.
+ */
+void msInterface::MzMLFile::_parsePrecursor(rapidxml::xml_node<>* precursorList, PrecursorScan& precursor) const
+{
+    // precursor scan
+    auto* precursorNode = internal::_getFirstChildNode("precursor", precursorList);
+    std::string precursorScanName;
+    try {
+        precursorScanName = internal::_getAttrValStr("spectrumRef", precursorNode);
+    } catch (utils::InvalidXmlFile) {
+        precursorScanName = "";
+    }
+    // auto* spectruRef = precursorNode->first_attribute("spectrumRef");
+    precursor.setScan(precursorScanName.empty() ? "" : _parseScan(precursorScanName));
+
+    //isolation window
+    double isolationTarget = 0, lowerOffset = 0, upperOffset = 0;
+    auto* isolationWindow = precursorNode->first_node("isolationWindow");
+    for(auto* iter = isolationWindow ? isolationWindow->first_node("cvParam") : nullptr;
+        iter; iter = iter->next_sibling("cvParam")) {
+        std::string accession = internal::_getAttrValStr("accession", iter);
+        if(accession == "MS:1000827") //isolation window target m/z
+            isolationTarget = internal::_getAttrValdouble("value", iter);
+        else if(accession == "MS:1000828") //isolation window lower offset
+            lowerOffset = internal::_getAttrValdouble("value", iter);
+        else if(accession == "MS:1000829") //isolation window upper offset
+            upperOffset = internal::_getAttrValdouble("value", iter);
+    }
+
+    //selectedIon
+    for(auto* iter = internal::_getFirstChildNode("cvParam",
+                                                  internal::_getFirstChildNode("selectedIon",
+                                                  internal::_getFirstChildNode("selectedIonList", precursorNode)));
+        iter; iter = iter->next_sibling("cvParam")) {
+        std::string accession = internal::_getAttrValStr("accession", iter);
+        if(accession == "MS:1000744") { //precursor m/z
+            precursor.setMZ(internal::_getAttrValStr("value", iter));
+            if(isolationTarget == 0)
+                isolationTarget = internal::_getAttrValdouble("value", iter);
+        }
+        else if(accession == "MS:1000041") //precursor charge
+            precursor.setCharge(internal::_getAttrValInt("value", iter));
+        else if(accession == "MS:1000042") //precursor intensity
+            precursor.setIntensity(internal::_getAttrValdouble("value", iter));
+    }
+
+    //activation method
+    msInterface::ActivationMethod am = ActivationMethod::UNKNOWN;
+    for(auto* iter = internal::_getFirstChildNode("cvParam", internal::_getFirstChildNode("activation", precursorNode));
+        iter; iter = iter->next_sibling("cvParam")){
+            am = msInterface::oboToActivation(internal::_getAttrValStr("accession", iter));
+            if(am != ActivationMethod::UNKNOWN) break;
+    }
+    precursor.setActivationMethod(am);
+    if(lowerOffset > 0 || upperOffset > 0)
+        precursor.setIsolationWindow(isolationTarget - lowerOffset, isolationTarget + upperOffset);
 }
 
 /**
@@ -108,7 +252,7 @@ void msInterface::MzMLFile::_buildIndex()
  \param scan empty msInterface::Spectrum to load scan into
  \return false if \p queryScan not found, true if successful
  */
-bool msInterface::MzMLFile::getScan(size_t queryScan, msInterface::Scan& scan) const
+bool msInterface::MzMLFile::_getScan(size_t queryScan, msInterface::Scan& scan) const
 {
     scan.clear();
     scan.getPrecursor().setSample(_parentFileBase);
@@ -156,7 +300,9 @@ bool msInterface::MzMLFile::getScan(size_t queryScan, msInterface::Scan& scan) c
             scan.setIsIonMobilityScan(true);
         }
         else if(accession == "MS:1000128") //profile scan
-            throw InvalidXmlFile("Profile spectra are not supported!");
+            scan.setCentroided(false);
+        else if(accession == "MS:1000127") //centroid scan
+            scan.setCentroided(true);
     }
 
     //get RT
@@ -181,80 +327,300 @@ bool msInterface::MzMLFile::getScan(size_t queryScan, msInterface::Scan& scan) c
 
     //Find the precursorList node
     auto* precursorNode = root->first_node("precursorList");
-    if(precursorNode) {
-        // precursor scan
-        precursorNode = internal::_getFirstChildNode("precursor", precursorNode);
-        std::string precursorScanName;
-        try {
-            precursorScanName = internal::_getAttrValStr("spectrumRef", precursorNode);
-        } catch (utils::InvalidXmlFile) {
-            precursorScanName = "";
+    if(precursorNode)
+        _parsePrecursor(precursorNode, scan.getPrecursor());
+
+    //decode scan ions
+    std::vector<double> mzArray, intensityArray;
+    _decodeArrays(root, "MS:1000514", "m/z", "scan " + idLine, mzArray, intensityArray);
+    size_t len = mzArray.size();
+    scan.getIons().reserve(len);
+    for(size_t i = 0; i < len; i++)
+        scan.add(mzArray[i], intensityArray[i]);
+
+    scan.updateRanges();
+    delete [] c;
+    return true;
+}
+
+
+/**
+ \brief Summarize scan using the cvParams in the spectrum header. <br>
+
+ Only the part of the spectrum before the binary data arrays is parsed.
+ The arrays are decoded only if the total ion current or base peak cvParams are missing.
+ If centroiding is enabled, the default implementation is used so the statistics describe the centroided peaks.
+ */
+bool msInterface::MzMLFile::_summarizeScan(size_t queryScan, RunSummary& summary, size_t row) const
+{
+    if(_centroider)
+        return MsInterface::_summarizeScan(queryScan, summary, row);
+
+    size_t scanIndex = _getScanIndex(queryScan);
+    if(scanIndex == SCAN_INDEX_NOT_FOUND) return false;
+    const char* begin = _buffer + _offsetIndex[scanIndex].first;
+    const char* end = _buffer + _offsetIndex[scanIndex].second;
+
+    // Close the spectrum after the header to get a valid xml document.
+    const char* headerEnd = strstr(begin, "<binaryDataArrayList");
+    if(headerEnd == nullptr || headerEnd > end) headerEnd = end;
+    std::string header(begin, headerEnd);
+    header += "</spectrum>";
+    rapidxml::xml_document<> doc;
+    doc.parse<0>(&header[0]);
+    rapidxml::xml_node<>* root = doc.first_node();
+
+    bool foundTIC = false, foundBasePeakMZ = false, foundBasePeakIntensity = false;
+    for(auto *child = internal::_getFirstChildNode("cvParam", root); child; child = child->next_sibling("cvParam")) {
+        std::string accession = internal::_getAttrValStr("accession", child);
+        if(accession == "MS:1000511") //ms level
+            summary.level[row] = internal::_getAttrValInt("value", child);
+        else if(accession == "MS:1000285") { //total ion current
+            summary.tic[row] = internal::_getAttrValdouble("value", child);
+            foundTIC = true;
         }
-        // auto* spectruRef = precursorNode->first_attribute("spectrumRef");
-        scan.getPrecursor().setScan(_parseScan(precursorScanName));
-
-        //selectedIon
-        for(auto* iter = internal::_getFirstChildNode("cvParam",
-                                                      internal::_getFirstChildNode("selectedIon",
-                                                      internal::_getFirstChildNode("selectedIonList", precursorNode)));
-            iter; iter = iter->next_sibling("cvParam")) {
-            std::string accession = internal::_getAttrValStr("accession", iter);
-            if(accession == "MS:1000744") //precursor m/z
-                scan.getPrecursor().setMZ(internal::_getAttrValStr("value", iter));
-            else if(accession == "MS:1000041") //precursor charge
-                scan.getPrecursor().setCharge(internal::_getAttrValInt("value", iter));
-            else if(accession == "MS:1000042") //precursor intensity
-                scan.getPrecursor().setIntensity(internal::_getAttrValdouble("value", iter));
+        else if(accession == "MS:1000504") { //base peak m/z
+            summary.basePeakMZ[row] = internal::_getAttrValdouble("value", child);
+            foundBasePeakMZ = true;
         }
+        else if(accession == "MS:1000505") { //base peak intensity
+            summary.basePeakIntensity[row] = internal::_getAttrValdouble("value", child);
+            foundBasePeakIntensity = true;
+        }
+    }
+    summary.peakCount[row] = internal::_getAttrValUL("defaultArrayLength", root);
 
-        //activation method
-        msInterface::ActivationMethod am = ActivationMethod::UNKNOWN;
-        for(auto* iter = internal::_getFirstChildNode("cvParam", internal::_getFirstChildNode("activation", precursorNode));
-            iter; iter = iter->next_sibling("cvParam")){
-                am = msInterface::oboToActivation(internal::_getAttrValStr("accession", iter));
-                if(am != ActivationMethod::UNKNOWN) break;
+    auto* scanList = root->first_node("scanList");
+    if(scanList){
+        for(auto* cvParam = internal::_getFirstChildNode("scan", scanList)->first_node("cvParam");
+            cvParam; cvParam = cvParam->next_sibling("cvParam")){
+            if(internal::_getAttrValStr("accession", cvParam) == "MS:1000016") // Retention time
+                summary.rt[row] = internal::_obo_to_seconds(internal::_getAttrValdouble("value", cvParam),
+                                                            internal::_getAttrValStr("unitAccession", cvParam));
         }
-        scan.getPrecursor().setActivationMethod(am);
     }
 
-    //decode scan ions
-    auto* binaryDataArrayNode = internal::_getFirstChildNode("binaryDataArrayList", root);
+    auto* precursorList = root->first_node("precursorList");
+    if(precursorList) {
+        PrecursorScan precursor;
+        _parsePrecursor(precursorList, precursor);
+        summary.setPrecursor(row, precursor);
+    }
+    if(foundTIC && foundBasePeakMZ && foundBasePeakIntensity)
+        return true;
+
+    // Fall back to decoding the arrays.
+    std::string spectrum(begin, end + 11);
+    rapidxml::xml_document<> spectrumDoc;
+    spectrumDoc.parse<0>(&spectrum[0]);
     std::vector<double> mzArray, intensityArray;
-    bool parsed_mz = false, parsed_intensity = false;
-    internal::BinaryData binaryParser;
-    size_t defaultArrayLength = internal::_getAttrValInt("defaultArrayLength", root);
-    binaryParser.setPeaksCount(defaultArrayLength);
-    for(auto* node = binaryDataArrayNode->first_node("binaryDataArray");
-        node; node = node->next_sibling("binaryDataArray")) {
-        for(auto* cvParam = node->first_node("cvParam"); cvParam; cvParam = cvParam->next_sibling("cvParam")){
-            std::string accession = internal::_getAttrValStr("accession", cvParam);
-            if(accession == "MS:1000514") { // m/z array
-                binaryParser.processBinaryArray(mzArray, node);
-                parsed_mz = true;
-                break;
-            }
-            else if(accession == "MS:1000515") { // intensity array
-                binaryParser.processBinaryArray(intensityArray, node);
-                parsed_intensity = true;
-                break;
-            }
+    _decodeArrays(spectrumDoc.first_node(), "MS:1000514", "m/z", "scan " + std::to_string(queryScan),
+                  mzArray, intensityArray);
+    double tic = 0, basePeakMZ = 0, basePeakIntensity = 0;
+    for(size_t i = 0; i < mzArray.size(); i++) {
+        tic += intensityArray[i];
+        if(intensityArray[i] > basePeakIntensity) {
+            basePeakIntensity = intensityArray[i];
+            basePeakMZ = mzArray[i];
         }
     }
-    size_t len = mzArray.size();
-    if(len > 0) {
-        if(!(parsed_mz && parsed_intensity))
-            throw InvalidXmlFile("ERROR In scan: " + idLine +"\n\tNever found array(s) for: " +
-                                 (parsed_mz ? "" : "m/z") + (!parsed_intensity && !parsed_mz ? " or " : "") +
-                                 (parsed_intensity ? "" : "intensity"));
-        if(len != intensityArray.size())
-            throw InvalidXmlFile("ERROR In scan: " + idLine +"\n\tMZ and intensity lengths do not match! m/z: " +
-                                  std::to_string(len) + ", int: " + std::to_string(intensityArray.size()));
-        for(size_t i = 0; i < len; i++)
-            scan.add(mzArray[i], intensityArray[i]);
+    summary.tic[row] = tic;
+    summary.basePeakMZ[row] = basePeakMZ;
+    summary.basePeakIntensity[row] = basePeakIntensity;
+    summary.peakCount[row] = mzArray.size();
+    return true;
+}
+
+//! Number of elements in array. 0 if the array is compressed or the encoded length is not a multiple of 4.
+size_t msInterface::MzMLFile::EncodedArray::length() const
+{
+    if(width == 0 || size % 4 != 0) return 0;
+    size_t nBytes = size / 4 * 3;
+    for(size_t i = size; i > 0 && data[i - 1] == '='; i--)
+        nBytes--;
+    return nBytes / width;
+}
+
+//! Decode element \p i of array.
+double msInterface::MzMLFile::EncodedArray::at(size_t i) const
+{
+    char bytes[8];
+    if(!internal::_b64_decode_range(bytes, data, size, i * width, width))
+        throw InvalidXmlFile("Binary array index " + std::to_string(i) + " out of range!");
+    if(width == 4) {
+        uint32_t value32;
+        memcpy(&value32, bytes, 4);
+        value32 = (uint32_t)internal::_dtohl(value32, false);
+        float ret;
+        memcpy(&ret, &value32, 4);
+        return ret;
     }
+    uint64_t value64;
+    memcpy(&value64, bytes, 8);
+    value64 = internal::_dtohl(value64, false);
+    double ret;
+    memcpy(&ret, &value64, 8);
+    return ret;
+}
 
-    scan.updateRanges();
-    delete [] c;
+/**
+ \brief Find the m/z and intensity arrays of a spectrum without decoding them.
+
+ \param begin Beginning of spectrum in buffer.
+ \param end End of spectrum in buffer.
+ \param mz Populated with location of m/z array.
+ \param intensity Populated with location of intensity array.
+ \return false if either array was not found.
+ */
+bool msInterface::MzMLFile::_findEncodedArrays(const char* begin, const char* end,
+                                                EncodedArray& mz, EncodedArray& intensity)
+{
+    static const std::string arrayTag = "<binaryDataArray ";
+    static const std::string binaryTag = "<binary>";
+    static const std::string binaryEndTag = "</binary>";
+    static const char* compression[] = {"\"MS:1000574\"", "\"MS:1002312\"", "\"MS:1002313\"", "\"MS:1002314\"",
+                                        "\"MS:1002746\"", "\"MS:1002747\"", "\"MS:1002748\""};
+    bool foundMZ = false, foundIntensity = false;
+    const char* pos = begin;
+    while(true) {
+        const char* arrayBegin = std::search(pos, end, arrayTag.begin(), arrayTag.end());
+        if(arrayBegin == end) break;
+        const char* dataBegin = std::search(arrayBegin, end, binaryTag.begin(), binaryTag.end());
+        if(dataBegin == end) return false;
+        const char* dataEnd = std::search(dataBegin, end, binaryEndTag.begin(), binaryEndTag.end());
+        if(dataEnd == end) return false;
+        pos = dataEnd;
+
+        std::string header(arrayBegin, dataBegin);
+        EncodedArray array;
+        array.data = dataBegin + binaryTag.size();
+        array.size = dataEnd - array.data;
+        if(header.find("\"MS:1000523\"") != std::string::npos) array.width = 8; //64-bit float
+        else if(header.find("\"MS:1000521\"") != std::string::npos) array.width = 4; //32-bit float
+        for(const char* accession: compression)
+            if(header.find(accession) != std::string::npos) array.width = 0;
+
+        if(header.find("\"MS:1000514\"") != std::string::npos) { //m/z array
+            mz = array;
+            foundMZ = true;
+        }
+        else if(header.find("\"MS:1000515\"") != std::string::npos) { //intensity array
+            intensity = array;
+            foundIntensity = true;
+        }
+    }
+    return foundMZ && foundIntensity;
+}
+
+/**
+ \brief Get peaks in m/z range by decoding only the part of the arrays which is needed. <br>
+
+ For uncompressed arrays, the m/z array is binary searched for \p lower one element at a time,
+ then elements are decoded until the m/z passes \p upper. Only the matching slice of the intensity array is decoded.
+ The mzML specification does not require m/z arrays to be sorted, so every decoded m/z is checked against the
+ elements decoded before it. If any are out of order, the whole scan is decoded with MsInterface::_getPeaksInRange.
+ An unsorted array is only detected if the disorder falls on an element which is decoded.
+ Compressed arrays also fall back to decoding the whole scan.
+ */
+bool msInterface::MzMLFile::_getPeaksInRange(size_t queryScan, double lower, double upper,
+                                             std::vector<double>& mz, std::vector<double>& intensity) const
+{
+    size_t scanIndex = _getScanIndex(queryScan);
+    if(scanIndex == SCAN_INDEX_NOT_FOUND) return false;
+    const char* begin = _buffer + _offsetIndex[scanIndex].first;
+    const char* end = _buffer + _offsetIndex[scanIndex].second;
+
+    EncodedArray mzArray, intensityArray;
+    if(!_findEncodedArrays(begin, end, mzArray, intensityArray) ||
+       mzArray.length() == 0 || mzArray.length() != intensityArray.length())
+        return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+
+    mz.clear();
+    intensity.clear();
+    size_t len = mzArray.length();
+
+    // Every probe of the binary search must fall between the values at the current bounds.
+    double lowValue = mzArray.at(0);
+    double maxValue = mzArray.at(len - 1);
+    double highValue = maxValue;
+    if(lowValue > highValue)
+        return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+    size_t first = 0, last = len;
+    while(first < last) {
+        size_t mid = first + (last - first) / 2;
+        double value = mzArray.at(mid);
+        if(value < lowValue || value > highValue)
+            return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+        if(value < lower) {
+            first = mid + 1;
+            lowValue = value;
+        }
+        else {
+            last = mid;
+            highValue = value;
+        }
+    }
+    for(size_t i = first; i < len; i++) {
+        double value = mzArray.at(i);
+        if(value < lowValue || value > maxValue || (!mz.empty() && value < mz.back())) {
+            mz.clear();
+            return MsInterface::_getPeaksInRange(queryScan, lower, upper, mz, intensity);
+        }
+        if(value > upper) break;
+        mz.push_back(value);
+    }
+    for(size_t i = 0; i < mz.size(); i++)
+        intensity.push_back(intensityArray.at(first + i));
+    return true;
+}
+
+/**
+ \brief Get chromatogram from file.
+
+ \param index Index of chromatogram in file.
+ \param chromatogram Populated with chromatogram. Times are converted to seconds.
+ \return false if \p index is out of range.
+ */
+bool msInterface::MzMLFile::getChromatogram(size_t index, Chromatogram& chromatogram) const
+{
+    chromatogram.clear();
+    if(index >= _chromatogramIndex.size()) {
+        std::cerr << "Chromatogram index: " << index << " out of range!" << NEW_LINE;
+        return false;
+    }
+    chromatogram.setId(_chromatogramIds[index]);
+
+    size_t begin = _chromatogramIndex[index].first;
+    size_t end = _chromatogramIndex[index].second + 15;
+    std::string chromatogram_s(_buffer + begin, end - begin);
+    rapidxml::xml_document<> doc;
+    doc.parse<0>(&chromatogram_s[0]);
+
+    std::string timeUnit;
+    _decodeArrays(doc.first_node(), "MS:1000595", "time", _chromatogramIds[index],
+                  chromatogram.getTime(), chromatogram.getIntensity(), &timeUnit);
+    if(!timeUnit.empty()) {
+        double toSeconds = internal::_obo_to_seconds(1, timeUnit);
+        for(auto& time: chromatogram.getTime())
+            time *= toSeconds;
+    }
     return true;
 }
 
+/**
+ \brief Get chromatogram from file.
+
+ \param id id attribute of chromatogram. (For example "TIC")
+ \param chromatogram Populated with chromatogram. Times are converted to seconds.
+ \return false if \p id is not found.
+ */
+bool msInterface::MzMLFile::getChromatogram(const std::string& id, Chromatogram& chromatogram) const
+{
+    auto it = std::find(_chromatogramIds.begin(), _chromatogramIds.end(), id);
+    if(it == _chromatogramIds.end()) {
+        chromatogram.clear();
+        std::cerr << "Chromatogram: " << id << " could not be found in: " << _fname << NEW_LINE;
+        return false;
+    }
+    return getChromatogram((size_t)(it - _chromatogramIds.begin()), chromatogram);
+}
@@ -0,0 +1,308 @@
+//
+// mzMLWriter.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <cstring>
+#include <stdexcept>
+
+#include <msInterface/mzMLWriter.hpp>
+#include <msInterface/internal/base64_utils.hpp>
+
+using namespace utils;
+
+namespace {
+    std::string cvParam(const std::string& accession, const std::string& name, const std::string& value = "") {
+        return "<cvParam cvRef=\"MS\" accession=\"" + accession + "\" name=\"" + name + "\" value=\"" + value + "\"/>";
+    }
+
+    std::string cvParam(const std::string& accession, const std::string& name, const std::string& value,
+                        const std::string& unitAccession, const std::string& unitName) {
+        std::string unitCvRef = unitAccession.substr(0, unitAccession.find(':'));
+        return "<cvParam cvRef=\"MS\" accession=\"" + accession + "\" name=\"" + name + "\" value=\"" + value +
+               "\" unitCvRef=\"" + unitCvRef + "\" unitAccession=\"" + unitAccession + "\" unitName=\"" + unitName + "\"/>";
+    }
+
+    std::string activationName(msInterface::ActivationMethod am) {
+        switch(am) {
+            case msInterface::ActivationMethod::CID: return "collision-induced dissociation";
+            case msInterface::ActivationMethod::MPD: return "photodissociation";
+            case msInterface::ActivationMethod::ECD: return "electron capture dissociation";
+            case msInterface::ActivationMethod::PQD: return "pulsed q dissociation";
+            case msInterface::ActivationMethod::ETD: return "electron transfer dissociation";
+            case msInterface::ActivationMethod::HCD: return "beam-type collision-induced dissociation";
+            default: return "dissociation method";
+        }
+    }
+}
+
+std::string msInterface::MzMLWriter::_spectrumID(const std::string& scanNum) {
+    return "controllerType=0 controllerNumber=1 scan=" + scanNum;
+}
+
+void msInterface::MzMLWriter::_writeHeader(const Scan* firstScan)
+{
+    std::string software = std::string(SOFTWARE_NAME);
+    _write("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+           "<indexedmzML xmlns=\"http://psi.hupo.org/ms/mzml\""
+           " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+           " xsi:schemaLocation=\"http://psi.hupo.org/ms/mzml http://psidev.info/files/ms/mzML/xsd/mzML1.1.2_idx.xsd\">\n"
+           "  <mzML xmlns=\"http://psi.hupo.org/ms/mzml\""
+           " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+           " xsi:schemaLocation=\"http://psi.hupo.org/ms/mzml http://psidev.info/files/ms/mzML/xsd/mzML1.1.0.xsd\""
+           " version=\"1.1.0\">\n"
+           "    <cvList count=\"2\">\n"
+           "      <cv id=\"MS\" fullName=\"Proteomics Standards Initiative Mass Spectrometry Ontology\""
+           " version=\"4.1.0\" URI=\"https://raw.githubusercontent.com/HUPO-PSI/psi-ms-CV/master/psi-ms.obo\"/>\n"
+           "      <cv id=\"UO\" fullName=\"Unit Ontology\" version=\"09:04:2014\""
+           " URI=\"https://raw.githubusercontent.com/bio-ontology-research-group/unit-ontology/master/unit.obo\"/>\n"
+           "    </cvList>\n"
+           "    <fileDescription>\n"
+           "      <fileContent>\n"
+           "        " + cvParam("MS:1000294", "mass spectrum") + "\n"
+           "      </fileContent>\n");
+    std::string sourceFile = firstScan == nullptr ? "" : firstScan->getPrecursor().getFile();
+    if(!sourceFile.empty()) {
+        _write("      <sourceFileList count=\"1\">\n"
+               "        <sourceFile id=\"SF1\" name=\"" + _escapeXml(baseName(sourceFile)) + "\" location=\"file://" +
+               _escapeXml(sourceFile.substr(0, sourceFile.size() - baseName(sourceFile).size())) + "\"/>\n"
+               "      </sourceFileList>\n");
+    }
+    _write("    </fileDescription>\n"
+           "    <softwareList count=\"1\">\n"
+           "      <software id=\"" + software + "\" version=\"" + SOFTWARE_VERSION + "\">\n"
+           "        " + cvParam("MS:1000799", "custom unreleased software tool", software) + "\n"
+           "      </software>\n"
+           "    </softwareList>\n"
+           "    <instrumentConfigurationList count=\"1\">\n"
+           "      <instrumentConfiguration id=\"IC1\">\n"
+           "        " + cvParam("MS:1000031", "instrument model") + "\n"
+           "      </instrumentConfiguration>\n"
+           "    </instrumentConfigurationList>\n"
+           "    <dataProcessingList count=\"1\">\n"
+           "      <dataProcessing id=\"" + software + "_conversion\">\n"
+           "        <processingMethod order=\"0\" softwareRef=\"" + software + "\">\n"
+           "          " + cvParam("MS:1000544", "Conversion to mzML") + "\n"
+           "        </processingMethod>\n"
+           "      </dataProcessing>\n"
+           "    </dataProcessingList>\n"
+           "    <run id=\"run1\" defaultInstrumentConfigurationRef=\"IC1\">\n"
+           "      <spectrumList ");
+    _spectrumCountOffset = _offset;
+    _write(_pad("count=\"0\"") + "defaultDataProcessingRef=\"" + software + "_conversion\">\n");
+}
+
+void msInterface::MzMLWriter::_writeFooter()
+{
+    _write("      </spectrumList>\n"
+           "    </run>\n"
+           "  </mzML>\n"
+           "  ");
+    size_t indexListOffset = _offset;
+    _write("<indexList count=\"1\">\n"
+           "    <index name=\"spectrum\">\n");
+    for(const auto& scan: _index)
+        _write("      <offset idRef=\"" + _spectrumID(std::to_string(scan.first)) + "\">" +
+               std::to_string(scan.second) + "</offset>\n");
+    _write("    </index>\n"
+           "  </indexList>\n"
+           "  <indexListOffset>" + std::to_string(indexListOffset) + "</indexListOffset>\n"
+           "  <fileChecksum>");
+    _overwrite(_spectrumCountOffset, _pad("count=\"" + std::to_string(_index.size()) + "\""));
+    _write(_sha1() + "</fileChecksum>\n"
+           "</indexedmzML>\n");
+}
+
+void msInterface::MzMLWriter::_encodeScan(const Scan& scan, size_t index, std::string& out) const
+{
+    const PrecursorScan& precursor = scan.getPrecursor();
+    double tic, basePeakMZ, basePeakInt;
+    _summarize(scan, tic, basePeakMZ, basePeakInt);
+    size_t peaksCount = scan.getIons().size();
+
+    out += "        <spectrum index=\"" + std::to_string(index) + "\" id=\"" +
+           _spectrumID(std::to_string(scan.getScanNum())) + "\" defaultArrayLength=\"" + std::to_string(peaksCount) + "\">\n";
+    out += "          " + cvParam("MS:1000511", "ms level", std::to_string(scan.getLevel())) + "\n";
+    out += "          " + (scan.getLevel() == 1 ? cvParam("MS:1000579", "MS1 spectrum") : cvParam("MS:1000580", "MSn spectrum")) + "\n";
+    out += "          " + (scan.isCentroided() ? cvParam("MS:1000127", "centroid spectrum") : cvParam("MS:1000128", "profile spectrum")) + "\n";
+    if(scan.getPolarity() == Polarity::POSITIVE)
+        out += "          " + cvParam("MS:1000130", "positive scan") + "\n";
+    else if(scan.getPolarity() == Polarity::NEGATIVE)
+        out += "          " + cvParam("MS:1000129", "negative scan") + "\n";
+    if(peaksCount > 0) {
+        out += "          " + cvParam("MS:1000504", "base peak m/z", _toString(basePeakMZ), "MS:1000040", "m/z") + "\n";
+        out += "          " + cvParam("MS:1000505", "base peak intensity", _toString(basePeakInt),
+                                      "MS:1000131", "number of detector counts") + "\n";
+        out += "          " + cvParam("MS:1000528", "lowest observed m/z", _toString(scan.getMinMZ()), "MS:1000040", "m/z") + "\n";
+        out += "          " + cvParam("MS:1000527", "highest observed m/z", _toString(scan.getMaxMZ()), "MS:1000040", "m/z") + "\n";
+    }
+    out += "          " + cvParam("MS:1000285", "total ion current", _toString(tic)) + "\n";
+
+    out += "          <scanList count=\"1\">\n";
+    out += "            " + cvParam("MS:1000795", "no combination") + "\n";
+    out += "            <scan>\n";
+    out += "              " + cvParam("MS:1000016", "scan start time", _toString(precursor.getRT()), "UO:0000010", "second") + "\n";
+    if(scan.getIonInjectionTime() != 0)
+        out += "              " + cvParam("MS:1000927", "ion injection time", _toString(scan.getIonInjectionTime()),
+                                          "UO:0000028", "millisecond") + "\n";
+    if(scan.isIonMobilityScan())
+        out += "              " + cvParam("MS:1001581", "FAIMS compensation voltage", _toString(scan.getIMCV()),
+                                          "UO:0000218", "volt") + "\n";
+    out += "            </scan>\n";
+    out += "          </scanList>\n";
+
+    if(scan.getLevel() > 1) {
+        out += "          <precursorList count=\"1\">\n";
+        out += "            <precursor";
+        if(!precursor.getScan().empty())
+            out += " spectrumRef=\"" + _spectrumID(_escapeXml(precursor.getScan())) + "\"";
+        out += ">\n";
+        if(precursor.hasIsolationWindow()) {
+            double halfWidth = (precursor.getIsolationUpper() - precursor.getIsolationLower()) / 2;
+            out += "              <isolationWindow>\n";
+            out += "                " + cvParam("MS:1000827", "isolation window target m/z",
+                                                _toString(precursor.getIsolationLower() + halfWidth), "MS:1000040", "m/z") + "\n";
+            out += "                " + cvParam("MS:1000828", "isolation window lower offset",
+                                                _toString(halfWidth), "MS:1000040", "m/z") + "\n";
+            out += "                " + cvParam("MS:1000829", "isolation window upper offset",
+                                                _toString(halfWidth), "MS:1000040", "m/z") + "\n";
+            out += "              </isolationWindow>\n";
+        }
+        out += "              <selectedIonList count=\"1\">\n";
+        out += "                <selectedIon>\n";
+        out += "                  " + cvParam("MS:1000744", "selected ion m/z", _escapeXml(precursor.getMZ()), "MS:1000040", "m/z") + "\n";
+        if(precursor.getCharge() > 0)
+            out += "                  " + cvParam("MS:1000041", "charge state", std::to_string(precursor.getCharge())) + "\n";
+        out += "                  " + cvParam("MS:1000042", "peak intensity", _toString(precursor.getIntensity()),
+                                              "MS:1000131", "number of detector counts") + "\n";
+        out += "                </selectedIon>\n";
+        out += "              </selectedIonList>\n";
+        out += "              <activation>\n";
+        std::string activation = precursor.getActivationMethod() == ActivationMethod::UNKNOWN ? "MS:1000044" :
+                                 activationToOBO(precursor.getActivationMethod());
+        out += "                " + cvParam(activation, activationName(precursor.getActivationMethod())) + "\n";
+        out += "              </activation>\n";
+        out += "            </precursor>\n";
+        out += "          </precursorList>\n";
+    }
+
+    std::vector<double> mz, intensity;
+    mz.reserve(peaksCount);
+    intensity.reserve(peaksCount);
+    for(const auto& ion: scan) {
+        mz.push_back(ion.getMZ());
+        intensity.push_back(ion.getIntensity());
+    }
+    out += "          <binaryDataArrayList count=\"2\">\n";
+    _encodeArray(mz, _mzDoublePrecision, _mzNumpress,
+                 cvParam("MS:1000514", "m/z array", "", "MS:1000040", "m/z"), out);
+    _encodeArray(intensity, _intensityDoublePrecision, _intensityNumpress,
+                 cvParam("MS:1000515", "intensity array", "", "MS:1000131", "number of detector counts"), out);
+    out += "          </binaryDataArrayList>\n";
+    out += "        </spectrum>\n";
+}
+
+/**
+ \brief Encode a single binaryDataArray.
+ \param values Array to encode.
+ \param doublePrecision Write array as 64 bit floats. Ignored if array is numpress encoded.
+ \param numpress Numpress compression to use.
+ \param arrayCvParam cvParam for the array type.
+ \param out String to append \<binaryDataArray\> to.
+ */
+void msInterface::MzMLWriter::_encodeArray(const std::vector<double>& values, bool doublePrecision, Numpress numpress,
+                                           const std::string& arrayCvParam, std::string& out) const
+{
+    std::string data;
+    size_t n = values.size();
+    if(numpress != Numpress::NONE) {
+        // numpress encoding is no more than 5 bytes per value plus a small header.
+        data.resize(n * 5 + 16);
+        auto* result = (unsigned char*)&data[0];
+        size_t len = 0;
+        try {
+            if(numpress == Numpress::LINEAR) {
+                double fixedPoint = ms::numpress::MSNumpress::optimalLinearFixedPoint(values.data(), n);
+                len = ms::numpress::MSNumpress::encodeLinear(values.data(), n, result, fixedPoint);
+            } else if(numpress == Numpress::PIC)
+                len = ms::numpress::MSNumpress::encodePic(values.data(), n, result);
+            else if(numpress == Numpress::SLOF) {
+                double fixedPoint = ms::numpress::MSNumpress::optimalSlofFixedPoint(values.data(), n);
+                len = ms::numpress::MSNumpress::encodeSlof(values.data(), n, result, fixedPoint);
+            }
+        } catch(const char* e) {
+            throw std::runtime_error(std::string("MS-Numpress encoding failed: ") + e);
+        }
+        data.resize(len);
+        doublePrecision = true;
+    } else {
+        size_t wordSize = doublePrecision ? sizeof(double) : sizeof(float);
+        data.resize(n * wordSize);
+        char* it = &data[0];
+        // mzML binary arrays are little endian. The readers make the same host byte order assumption.
+        for(double value: values) {
+            if(doublePrecision)
+                memcpy(it, &value, wordSize);
+            else {
+                auto f = (float)value;
+                memcpy(it, &f, wordSize);
+            }
+            it += wordSize;
+        }
+    }
+    if(_zlib) {
+        std::string compressed;
+        internal::_compress(compressed, data.data(), data.size());
+        data.swap(compressed);
+    }
+
+    std::string compression;
+    switch(numpress) {
+        case Numpress::NONE:
+            compression = _zlib ? cvParam("MS:1000574", "zlib compression") : cvParam("MS:1000576", "no compression");
+            break;
+        case Numpress::LINEAR:
+            compression = _zlib ? cvParam("MS:1002746", "MS-Numpress linear prediction compression followed by zlib compression") :
+                                  cvParam("MS:1002312", "MS-Numpress linear prediction compression");
+            break;
+        case Numpress::PIC:
+            compression = _zlib ? cvParam("MS:1002747", "MS-Numpress positive integer compression followed by zlib compression") :
+                                  cvParam("MS:1002313", "MS-Numpress positive integer compression");
+            break;
+        case Numpress::SLOF:
+            compression = _zlib ? cvParam("MS:1002748", "MS-Numpress short logged float compression followed by zlib compression") :
+                                  cvParam("MS:1002314", "MS-Numpress short logged float compression");
+            break;
+    }
+
+    std::string encoded;
+    internal::_b64_encode(encoded, data.data(), data.size());
+    out += "            <binaryDataArray encodedLength=\"" + std::to_string(encoded.size()) + "\">\n";
+    out += "              " + (doublePrecision ? cvParam("MS:1000523", "64-bit float") : cvParam("MS:1000521", "32-bit float")) + "\n";
+    out += "              " + compression + "\n";
+    out += "              " + arrayCvParam + "\n";
+    out += "              <binary>" + encoded + "</binary>\n";
+    out += "            </binaryDataArray>\n";
+}
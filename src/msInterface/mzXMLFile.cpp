@@ -100,7 +100,7 @@ void msInterface::MzXMLFile::_buildIndex()
  \param scan empty utils::msInterface::Spectrum to load scan into
  \return false if \p queryScan not found, true if successful
  */
-bool msInterface::MzXMLFile::getScan(size_t queryScan, msInterface::Scan& scan) const
+bool msInterface::MzXMLFile::_getScan(size_t queryScan, msInterface::Scan& scan) const
 {
     scan.clear();
     scan.getPrecursor().setSample(_parentFileBase);
@@ -145,6 +145,8 @@ bool msInterface::MzXMLFile::getScan(size_t queryScan, msInterface::Scan& scan)
             peaksCount = std::stol(attr->value());
         else if(utils::internal::_isAttr("msLevel", attr->name()))
             scan.setLevel(std::stoi(attr->value()));
+        else if(utils::internal::_isAttr("centroided", attr->name()))
+            scan.setCentroided(*attr->value() != '0');
         else if(utils::internal::_isAttr("polarity", attr->name())) {
             char polarity = *attr->value();
             Polarity setPolarity = Polarity::UNKNOWN;
@@ -158,6 +160,7 @@ bool msInterface::MzXMLFile::getScan(size_t queryScan, msInterface::Scan& scan)
     //iterate through scan child nodes
     for(node = node->first_node(); node; node = node->next_sibling()) {
         if(utils::internal::_isVal(node->name(), "precursorMz")){
+            double windowWideness = 0;
             for(auto *attr = node->first_attribute(); attr; attr = attr->next_attribute()) {
                 if(utils::internal::_isAttr("precursorIntensity", attr->name()))
                     scan.getPrecursor().setIntensity(std::stod(attr->value()));
@@ -165,8 +168,16 @@ bool msInterface::MzXMLFile::getScan(size_t queryScan, msInterface::Scan& scan)
                     scan.getPrecursor().setCharge(std::stoi(attr->value()));
                 else if(utils::internal::_isAttr("activationMethod", attr->name()))
                     scan.getPrecursor().setActivationMethod(msInterface::strToActivation(std::string(attr->value())));
+                else if(utils::internal::_isAttr("precursorScanNum", attr->name()))
+                    scan.getPrecursor().setScan(std::string(attr->value(), attr->value_size()));
+                else if(utils::internal::_isAttr("windowWideness", attr->name()))
+                    windowWideness = std::stod(attr->value());
             }
             scan.getPrecursor().setMZ(std::string(node->value()));
+            if(windowWideness > 0) {
+                double mz = std::stod(node->value());
+                scan.getPrecursor().setIsolationWindow(mz - windowWideness / 2, mz + windowWideness / 2);
+            }
         }
         else if(utils::internal::_isVal(node->name(), "peaks"))
         {
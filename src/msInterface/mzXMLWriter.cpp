@@ -0,0 +1,140 @@
+//
+// mzXMLWriter.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <cstring>
+
+#include <msInterface/mzXMLWriter.hpp>
+#include <msInterface/internal/base64_utils.hpp>
+
+using namespace utils;
+
+void msInterface::MzXMLWriter::_writeHeader(const Scan* firstScan)
+{
+    _write("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+           "<mzXML xmlns=\"http://sashimi.sourceforge.net/schema_revision/mzXML_3.2\"\n"
+           " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+           " xsi:schemaLocation=\"http://sashimi.sourceforge.net/schema_revision/mzXML_3.2"
+           " http://sashimi.sourceforge.net/schema_revision/mzXML_3.2/mzXML_idx_3.2.xsd\">\n"
+           " <msRun ");
+    _scanCountOffset = _offset;
+    _write(_pad("scanCount=\"0\"") + ">\n");
+    std::string parentFile = firstScan == nullptr ? "" : baseName(firstScan->getPrecursor().getFile());
+    _write("  <parentFile fileName=\"" + _escapeXml(parentFile) + "\" fileType=\"RAWData\""
+           " fileSha1=\"0000000000000000000000000000000000000000\"/>\n");
+    _write(std::string("  <dataProcessing>\n"
+           "   <software type=\"conversion\" name=\"") + SOFTWARE_NAME + "\" version=\"" + SOFTWARE_VERSION + "\"/>\n"
+           "  </dataProcessing>\n");
+}
+
+void msInterface::MzXMLWriter::_writeFooter()
+{
+    _write(" </msRun>\n ");
+    size_t indexOffset = _offset;
+    _write("<index name=\"scan\">\n");
+    for(const auto& scan: _index)
+        _write("  <offset id=\"" + std::to_string(scan.first) + "\">" + std::to_string(scan.second) + "</offset>\n");
+    _write(" </index>\n");
+    _write(" <indexOffset>" + std::to_string(indexOffset) + "</indexOffset>\n");
+    _write(" <sha1>");
+    _overwrite(_scanCountOffset, _pad("scanCount=\"" + std::to_string(_index.size()) + "\""));
+    _write(_sha1() + "</sha1>\n</mzXML>\n");
+}
+
+void msInterface::MzXMLWriter::_encodeScan(const Scan& scan, size_t index, std::string& out) const
+{
+    const PrecursorScan& precursor = scan.getPrecursor();
+    double tic, basePeakMZ, basePeakInt;
+    _summarize(scan, tic, basePeakMZ, basePeakInt);
+    size_t peaksCount = scan.getIons().size();
+
+    out += "  <scan num=\"" + std::to_string(scan.getScanNum()) + "\"\n";
+    out += std::string("        centroided=\"") + (scan.isCentroided() ? "1" : "0") + "\"\n";
+    out += "        msLevel=\"" + std::to_string(scan.getLevel()) + "\"\n";
+    out += "        peaksCount=\"" + std::to_string(peaksCount) + "\"\n";
+    if(scan.getPolarity() != Polarity::UNKNOWN)
+        out += std::string("        polarity=\"") + (scan.getPolarity() == Polarity::POSITIVE ? "+" : "-") + "\"\n";
+    out += "        retentionTime=\"PT" + _toString(precursor.getRT()) + "S\"\n";
+    if(peaksCount > 0) {
+        out += "        lowMz=\"" + _toString(scan.getMinMZ()) + "\"\n";
+        out += "        highMz=\"" + _toString(scan.getMaxMZ()) + "\"\n";
+        out += "        basePeakMz=\"" + _toString(basePeakMZ) + "\"\n";
+        out += "        basePeakIntensity=\"" + _toString(basePeakInt) + "\"\n";
+    }
+    out += "        totIonCurrent=\"" + _toString(tic) + "\">\n";
+
+    if(scan.getLevel() > 1) {
+        out += "   <precursorMz";
+        if(!precursor.getScan().empty())
+            out += " precursorScanNum=\"" + _escapeXml(precursor.getScan()) + "\"";
+        out += " precursorIntensity=\"" + _toString(precursor.getIntensity()) + "\"";
+        if(precursor.getCharge() > 0)
+            out += " precursorCharge=\"" + std::to_string(precursor.getCharge()) + "\"";
+        if(precursor.getActivationMethod() != ActivationMethod::UNKNOWN)
+            out += " activationMethod=\"" + activationToString(precursor.getActivationMethod()) + "\"";
+        if(precursor.hasIsolationWindow())
+            out += " windowWideness=\"" + _toString(precursor.getIsolationUpper() - precursor.getIsolationLower()) + "\"";
+        out += ">" + _escapeXml(precursor.getMZ()) + "</precursorMz>\n";
+    }
+
+    // interleave m/z and intensity in network byte order
+    size_t wordSize = _doublePrecision ? sizeof(uint64_t) : sizeof(uint32_t);
+    std::string data(peaksCount * 2 * wordSize, '\0');
+    char* it = &data[0];
+    for(const auto& ion: scan) {
+        double values[] = {ion.getMZ(), ion.getIntensity()};
+        for(double value: values) {
+            if(_doublePrecision) {
+                uint64_t i;
+                memcpy(&i, &value, sizeof(i));
+                i = internal::_dtohl(i, true);
+                memcpy(it, &i, sizeof(i));
+            } else {
+                auto f = (float)value;
+                uint32_t i;
+                memcpy(&i, &f, sizeof(i));
+                i = (uint32_t)internal::_dtohl(i, true);
+                memcpy(it, &i, sizeof(i));
+            }
+            it += wordSize;
+        }
+    }
+    size_t compressedLen = 0;
+    if(_zlib) {
+        std::string compressed;
+        internal::_compress(compressed, data.data(), data.size());
+        data.swap(compressed);
+        compressedLen = data.size();
+    }
+
+    out += std::string("   <peaks compressionType=\"") + (_zlib ? "zlib" : "none") + "\"";
+    out += " compressedLen=\"" + std::to_string(compressedLen) + "\"";
+    out += std::string(" precision=\"") + (_doublePrecision ? "64" : "32") + "\"";
+    out += " byteOrder=\"network\" contentType=\"m/z-int\">";
+    internal::_b64_encode(out, data.data(), data.size());
+    out += "</peaks>\n";
+    out += "  </scan>\n";
+}
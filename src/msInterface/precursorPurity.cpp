@@ -0,0 +1,148 @@
+//
+// precursorPurity.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <thread>
+
+#include <msInterface/precursorPurity.hpp>
+#include <msInterface/deisotoper.hpp>
+
+using namespace utils;
+
+void msInterface::PurityResult::clear()
+{
+    scanNum.clear();
+    parentScan.clear();
+    purity.clear();
+}
+
+/**
+ \brief Calculate precursor purity in a single isolation window.
+
+ \param ms1 Parent scan.
+ \param precursorMZ Precursor m/z.
+ \param charge Precursor charge. If 0, only peaks matching \p precursorMZ count toward the precursor.
+ \param lower Lower m/z bound of isolation window.
+ \param upper Upper m/z bound of isolation window.
+ \return Fraction of intensity in isolation window from the precursor isotope envelope. 0 if the window is empty.
+ */
+double msInterface::PurityCalculator::purity(const Scan& ms1, double precursorMZ, int charge,
+                                             double lower, double upper) const
+{
+    double isotopeSpacing = charge > 0 ? Deisotoper::C13_DIFF / charge : 0;
+    double total = 0, matched = 0;
+    for(const auto& ion: ms1.getIons()) {
+        double mz = ion.getMZ();
+        if(mz < lower || mz > upper) continue;
+        total += ion.getIntensity();
+
+        double expected = precursorMZ;
+        if(charge > 0)
+            expected += std::round((mz - precursorMZ) / isotopeSpacing) * isotopeSpacing;
+        if(std::fabs(mz - expected) <= _tolerance.width(expected))
+            matched += ion.getIntensity();
+    }
+    return total > 0 ? matched / total : 0;
+}
+
+/**
+ \brief Calculate precursor purity of every MS2 scan in \p file. <br>
+
+ MsInterface::summarizeRun is called first to get the precursor and isolation window of each scan.
+ Use the other overload if a RunSummary for \p file is already available.
+ \param file Initialized MsInterface.
+ \param result Populated with one row per MS2 scan.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::PurityCalculator::compute(const MsInterface& file, PurityResult& result, unsigned int nThread) const
+{
+    RunSummary summary;
+    file.summarizeRun(summary, nThread);
+    compute(file, summary, result, nThread);
+}
+
+/**
+ \brief Calculate precursor purity of every MS2 scan in \p file.
+
+ \param file Initialized MsInterface.
+ \param summary RunSummary of \p file.
+ \param result Populated with one row per MS2 scan.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::PurityCalculator::compute(const MsInterface& file, const RunSummary& summary,
+                                            PurityResult& result, unsigned int nThread) const
+{
+    result.clear();
+    std::vector<size_t> parents;
+    MsInterface::getParentScans(summary, parents);
+
+    // Group rows of MS2 scans by parent MS1 scan.
+    std::vector<size_t> ms2Rows;
+    std::map<size_t, std::vector<size_t> > groupMap;
+    for(size_t i = 0; i < summary.size(); i++) {
+        if(summary.level[i] != 2) continue;
+        size_t resultRow = ms2Rows.size();
+        ms2Rows.push_back(i);
+        result.scanNum.push_back(summary.scanNum[i]);
+        result.parentScan.push_back(parents[i]);
+        if(parents[i] != SCAN_INDEX_NOT_FOUND)
+            groupMap[parents[i]].push_back(resultRow);
+    }
+    result.purity.assign(ms2Rows.size(), 0);
+    std::vector<std::pair<size_t, std::vector<size_t> > > groups(groupMap.begin(), groupMap.end());
+    size_t nGroups = groups.size();
+    if(nGroups == 0) return;
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nGroups));
+    std::vector<std::thread> threads;
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            Scan ms1;
+            for(size_t g = thread; g < nGroups; g += _nThread) {
+                if(!file.getScan(groups[g].first, ms1)) continue;
+                for(size_t resultRow: groups[g].second) {
+                    size_t row = ms2Rows[resultRow];
+                    double precursorMZ = summary.precursorMZ[row];
+                    if(precursorMZ <= 0) continue;
+                    double lower = summary.isolationLower[row];
+                    double upper = summary.isolationUpper[row];
+                    if(upper <= lower) {
+                        lower = precursorMZ - _isolationWidth / 2;
+                        upper = precursorMZ + _isolationWidth / 2;
+                    }
+                    result.purity[resultRow] = purity(ms1, precursorMZ, summary.precursorCharge[row], lower, upper);
+                }
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
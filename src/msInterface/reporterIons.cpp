@@ -0,0 +1,292 @@
+//
+// reporterIons.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include <msInterface/reporterIons.hpp>
+#include <msInterface/deisotoper.hpp>
+
+using namespace utils;
+
+void msInterface::ReporterResult::clear()
+{
+    scanNum.clear();
+    channels.clear();
+    intensity.clear();
+}
+
+/**
+ \brief Constructor.
+ \param plex Labeling reagent.
+ \param tolerance m/z tolerance of reporter ions.
+ */
+msInterface::ReporterIonExtractor::ReporterIonExtractor(Plex plex, const MZTolerance& tolerance)
+{
+    getChannels(plex, _channels);
+    _tolerance = tolerance;
+    _peakSelect = PeakSelect::MOST_INTENSE;
+    _msLevel = 2;
+}
+
+/**
+ \brief Constructor.
+ \param channels Reporter ion channels.
+ \param tolerance m/z tolerance of reporter ions.
+ */
+msInterface::ReporterIonExtractor::ReporterIonExtractor(std::vector<ReporterChannel> channels, const MZTolerance& tolerance)
+    : _channels(std::move(channels))
+{
+    _tolerance = tolerance;
+    _peakSelect = PeakSelect::MOST_INTENSE;
+    _msLevel = 2;
+}
+
+/**
+ \brief Get the reporter ion channels of a labeling reagent.
+ \param plex Labeling reagent.
+ \param channels Populated with channels sorted by m/z.
+ */
+void msInterface::ReporterIonExtractor::getChannels(Plex plex, std::vector<ReporterChannel>& channels)
+{
+    static const std::vector<ReporterChannel> tmtPro = {
+        {"126", 126.127726}, {"127N", 127.124761}, {"127C", 127.131081}, {"128N", 128.128116},
+        {"128C", 128.134436}, {"129N", 129.131471}, {"129C", 129.137790}, {"130N", 130.134825},
+        {"130C", 130.141145}, {"131N", 131.138180}, {"131C", 131.144500}, {"132N", 132.141535},
+        {"132C", 132.147855}, {"133N", 133.144890}, {"133C", 133.151210}, {"134N", 134.148245},
+        {"134C", 134.154565}, {"135N", 135.151600}};
+
+    channels.clear();
+    switch(plex) {
+        case Plex::ITRAQ4:
+            channels = {{"114", 114.1112}, {"115", 115.1083}, {"116", 116.1116}, {"117", 117.1150}};
+            break;
+        case Plex::ITRAQ8:
+            channels = {{"113", 113.1078}, {"114", 114.1112}, {"115", 115.1082}, {"116", 116.1116},
+                        {"117", 117.1149}, {"118", 118.1120}, {"119", 119.1153}, {"121", 121.1220}};
+            break;
+        case Plex::TMT6:
+            channels = {{"126", 126.127726}, {"127", 127.124761}, {"128", 128.134436},
+                        {"129", 129.131471}, {"130", 130.141145}, {"131", 131.138180}};
+            break;
+        case Plex::TMT10:
+            channels.assign(tmtPro.begin(), tmtPro.begin() + 10);
+            channels.back().name = "131";
+            break;
+        case Plex::TMT11:
+            channels.assign(tmtPro.begin(), tmtPro.begin() + 11);
+            break;
+        case Plex::TMTPRO16:
+            channels.assign(tmtPro.begin(), tmtPro.begin() + 16);
+            break;
+        case Plex::TMTPRO18:
+            channels = tmtPro;
+            break;
+    }
+}
+
+/**
+ \brief Enable impurity correction with an explicit impurity matrix.
+ \param matrix Row major n x n matrix where n is the number of channels.
+ Element [i * n + j] is the fraction of the signal of channel j which is observed in channel i.
+ \throws std::invalid_argument if \p matrix has the wrong size or is singular.
+ */
+void msInterface::ReporterIonExtractor::setImpurityMatrix(const std::vector<double>& matrix)
+{
+    size_t n = _channels.size();
+    if(matrix.size() != n * n)
+        throw std::invalid_argument("Impurity matrix must have " + std::to_string(n * n) + " elements!");
+
+    // LU factorization with partial pivoting.
+    std::vector<double> lu = matrix;
+    std::vector<size_t> pivot(n);
+    for(size_t i = 0; i < n; i++) pivot[i] = i;
+    for(size_t k = 0; k < n; k++) {
+        size_t maxRow = k;
+        for(size_t i = k + 1; i < n; i++)
+            if(std::fabs(lu[i * n + k]) > std::fabs(lu[maxRow * n + k])) maxRow = i;
+        if(std::fabs(lu[maxRow * n + k]) < 1e-12)
+            throw std::invalid_argument("Impurity matrix is singular!");
+        if(maxRow != k) {
+            for(size_t j = 0; j < n; j++)
+                std::swap(lu[k * n + j], lu[maxRow * n + j]);
+            std::swap(pivot[k], pivot[maxRow]);
+        }
+        for(size_t i = k + 1; i < n; i++) {
+            lu[i * n + k] /= lu[k * n + k];
+            for(size_t j = k + 1; j < n; j++)
+                lu[i * n + j] -= lu[i * n + k] * lu[k * n + j];
+        }
+    }
+    _lu = std::move(lu);
+    _pivot = std::move(pivot);
+}
+
+/**
+ \brief Enable impurity correction using the isotope impurities from a reagent product data sheet. <br>
+
+ The impurity of a channel at each isotope offset is assigned to the channel closest to
+ the channel m/z + offset * Deisotoper::C13_DIFF. Impurities with no channel at the offset are lost.
+ \param impurities For each channel, the percentage of its signal at the -2, -1, +1 and +2 isotope offsets.
+ \throws std::invalid_argument if \p impurities does not have 4 values for each channel.
+ */
+void msInterface::ReporterIonExtractor::setImpurities(const std::vector<std::vector<double> >& impurities)
+{
+    static const int offsets[] = {-2, -1, 1, 2};
+    static const double channelTolerance = 0.02;
+    size_t n = _channels.size();
+    if(impurities.size() != n)
+        throw std::invalid_argument("Impurities must be given for " + std::to_string(n) + " channels!");
+
+    std::vector<double> matrix(n * n, 0);
+    for(size_t j = 0; j < n; j++) {
+        if(impurities[j].size() != 4)
+            throw std::invalid_argument("Impurities of channel " + _channels[j].name + " must have 4 values!");
+        double diagonal = 1;
+        for(size_t k = 0; k < 4; k++) {
+            double fraction = impurities[j][k] / 100;
+            diagonal -= fraction;
+            double target = _channels[j].mz + offsets[k] * Deisotoper::C13_DIFF;
+            size_t closest = n;
+            for(size_t i = 0; i < n; i++) {
+                if(i == j || std::fabs(_channels[i].mz - target) > channelTolerance) continue;
+                if(closest == n || std::fabs(_channels[i].mz - target) < std::fabs(_channels[closest].mz - target))
+                    closest = i;
+            }
+            if(closest != n)
+                matrix[closest * n + j] += fraction;
+        }
+        matrix[j * n + j] += diagonal;
+    }
+    setImpurityMatrix(matrix);
+}
+
+/**
+ \brief Correct reporter intensities for isotope impurities in place. Does nothing if impurity correction is disabled.
+ \param intensities Pointer to one intensity for each channel.
+ */
+void msInterface::ReporterIonExtractor::correct(double* intensities) const
+{
+    if(_lu.empty()) return;
+    size_t n = _channels.size();
+    std::vector<double> x(n);
+    for(size_t i = 0; i < n; i++) {
+        x[i] = intensities[_pivot[i]];
+        for(size_t j = 0; j < i; j++)
+            x[i] -= _lu[i * n + j] * x[j];
+    }
+    for(size_t i = n; i-- > 0;) {
+        for(size_t j = i + 1; j < n; j++)
+            x[i] -= _lu[i * n + j] * x[j];
+        x[i] /= _lu[i * n + i];
+    }
+    for(size_t i = 0; i < n; i++)
+        intensities[i] = std::max(0.0, x[i]);
+}
+
+//! Find the reporter peak of each channel in sorted peak arrays and write its intensity to \p out.
+void msInterface::ReporterIonExtractor::_extractScan(const std::vector<double>& mz, const std::vector<double>& intensity,
+                                                     double* out) const
+{
+    for(size_t c = 0; c < _channels.size(); c++) {
+        double target = _channels[c].mz;
+        double width = _tolerance.width(target);
+        size_t best = PEAK_NOT_FOUND;
+        for(size_t i = std::lower_bound(mz.begin(), mz.end(), target - width) - mz.begin();
+            i < mz.size() && mz[i] <= target + width; i++) {
+            if(best == PEAK_NOT_FOUND ||
+               (_peakSelect == PeakSelect::MOST_INTENSE && intensity[i] > intensity[best]) ||
+               (_peakSelect == PeakSelect::CLOSEST && std::fabs(mz[i] - target) < std::fabs(mz[best] - target)))
+                best = i;
+        }
+        out[c] = best == PEAK_NOT_FOUND ? 0 : intensity[best];
+    }
+    correct(out);
+}
+
+/**
+ \brief Extract reporter ion intensities from every scan at the selected MS level. <br>
+
+ MsInterface::summarizeRun is called first to find the MS level of each scan.
+ Use the other overload if a RunSummary for \p file is already available.
+ \param file Initialized MsInterface.
+ \param result Populated with one row per scan.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::ReporterIonExtractor::extract(const MsInterface& file, ReporterResult& result, unsigned int nThread) const
+{
+    RunSummary summary;
+    file.summarizeRun(summary, nThread);
+    extract(file, summary, result, nThread);
+}
+
+/**
+ \brief Extract reporter ion intensities from every scan at the selected MS level.
+
+ \param file Initialized MsInterface.
+ \param summary RunSummary of \p file.
+ \param result Populated with one row per scan.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::ReporterIonExtractor::extract(const MsInterface& file, const RunSummary& summary,
+                                                ReporterResult& result, unsigned int nThread) const
+{
+    result.clear();
+    for(const auto& channel: _channels)
+        result.channels.push_back(channel.name);
+    for(size_t i = 0; i < summary.size(); i++)
+        if(summary.level[i] == _msLevel) result.scanNum.push_back(summary.scanNum[i]);
+    size_t nScans = result.scanNum.size();
+    size_t nChannels = _channels.size();
+    result.intensity.assign(nScans * nChannels, 0);
+    if(nScans == 0 || nChannels == 0) return;
+
+    // m/z range spanning every channel
+    double lower = _channels.front().mz, upper = _channels.front().mz;
+    for(const auto& channel: _channels) {
+        lower = std::min(lower, channel.mz - _tolerance.width(channel.mz));
+        upper = std::max(upper, channel.mz + _tolerance.width(channel.mz));
+    }
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nScans));
+    std::vector<std::thread> threads;
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            std::vector<double> mz, intensity;
+            for(size_t s = thread; s < nScans; s += _nThread) {
+                if(!file.getPeaksInRange(result.scanNum[s], lower, upper, mz, intensity)) continue;
+                _extractScan(mz, intensity, &result.intensity[s * nChannels]);
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
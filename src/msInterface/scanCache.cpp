@@ -0,0 +1,134 @@
+//
+// scanCache.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <msInterface/scanCache.hpp>
+
+using namespace utils;
+
+size_t const msInterface::ScanCache::DEFAULT_SHARDS;
+
+/**
+ \brief Constructor.
+ \param maxBytes Total memory budget of cache in bytes.
+ \param nShards Number of independently locked shards.
+ */
+msInterface::ScanCache::ScanCache(size_t maxBytes, size_t nShards) : _hits(0), _misses(0), _evictions(0)
+{
+    if(nShards == 0) nShards = 1;
+    _maxBytes = maxBytes;
+    _shardBytes = maxBytes / nShards;
+    for(size_t i = 0; i < nShards; i++)
+        _shards.emplace_back(new Shard());
+}
+
+/**
+ \brief Copy cached scan into \p scan and mark it as most recently used.
+ \param scanNum Scan number to look up.
+ \param scan Populated with cached scan if found.
+ \return true if \p scanNum was in the cache.
+ */
+bool msInterface::ScanCache::get(size_t scanNum, Scan& scan)
+{
+    Shard& shard = _getShard(scanNum);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(scanNum);
+    if(it == shard.map.end()){
+        _misses++;
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    scan = it->second->second;
+    _hits++;
+    return true;
+}
+
+/**
+ \brief Add \p scan to the cache, evicting least recently used scans if the shard is over budget. <br>
+
+ Scans larger than the budget of a single shard are not cached.
+ \param scanNum Scan number to use as key.
+ \param scan Scan to copy into the cache.
+ */
+void msInterface::ScanCache::insert(size_t scanNum, const Scan& scan)
+{
+    size_t scanBytes = scan.memoryUsage();
+    if(scanBytes > _shardBytes) return;
+
+    Shard& shard = _getShard(scanNum);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(scanNum);
+    if(it != shard.map.end()) {
+        shard.bytes -= it->second->second.memoryUsage();
+        shard.lru.erase(it->second);
+        shard.map.erase(it);
+    }
+
+    // The copy may be smaller than scan if scan has excess capacity.
+    shard.lru.emplace_front(scanNum, scan);
+    shard.map[scanNum] = shard.lru.begin();
+    shard.bytes += shard.lru.front().second.memoryUsage();
+
+    while(shard.bytes > _shardBytes) {
+        shard.bytes -= shard.lru.back().second.memoryUsage();
+        shard.map.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+        _evictions++;
+    }
+}
+
+//! Remove all scans from cache. Hit and miss counters are not reset.
+void msInterface::ScanCache::clear()
+{
+    for(auto& shard: _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->lru.clear();
+        shard->map.clear();
+        shard->bytes = 0;
+    }
+}
+
+//! Number of scans currently in cache.
+size_t msInterface::ScanCache::size() const
+{
+    size_t ret = 0;
+    for(auto& shard: _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        ret += shard->map.size();
+    }
+    return ret;
+}
+
+//! Current memory usage of cached scans in bytes.
+size_t msInterface::ScanCache::getBytes() const
+{
+    size_t ret = 0;
+    for(auto& shard: _shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        ret += shard->bytes;
+    }
+    return ret;
+}
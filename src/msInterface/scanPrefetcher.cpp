@@ -0,0 +1,202 @@
+//
+// scanPrefetcher.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <msInterface/scanPrefetcher.hpp>
+
+using namespace utils;
+
+size_t const msInterface::ScanPrefetcher::DEFAULT_AHEAD;
+
+/**
+ \brief Prefetch every scan in \p file in ascending scan number order.
+
+ \param file Initialized MsInterface to read scans from.
+ \param nAhead Maximum number of decoded scans to hold ahead of the consumer.
+ \param nThread Number of decoding threads. If 0, one less than \p std::thread::hardware_concurrency() threads are used.
+ */
+msInterface::ScanPrefetcher::ScanPrefetcher(const MsInterface& file, size_t nAhead, unsigned int nThread) : _file(file)
+{
+    _file.getScanNumbers(_scans);
+    _init(nAhead, nThread);
+}
+
+/**
+ \brief Prefetch \p scans from \p file.
+
+ \param file Initialized MsInterface to read scans from.
+ \param scans Scan numbers to iterate through in the order they should be returned.
+ \param nAhead Maximum number of decoded scans to hold ahead of the consumer.
+ \param nThread Number of decoding threads. If 0, one less than \p std::thread::hardware_concurrency() threads are used.
+ */
+msInterface::ScanPrefetcher::ScanPrefetcher(const MsInterface& file, const std::vector<size_t>& scans,
+                                            size_t nAhead, unsigned int nThread) : _file(file), _scans(scans)
+{
+    _init(nAhead, nThread);
+}
+
+/**
+ \brief Prefetch every scan in \p file in ascending scan number order and apply \p transform to each scan.
+
+ \param file Initialized MsInterface to read scans from.
+ \param transform Function applied to each scan on the decoding threads. Must be safe to call concurrently.
+ \param nAhead Maximum number of decoded scans to hold ahead of the consumer.
+ \param nThread Number of decoding threads. If 0, one less than \p std::thread::hardware_concurrency() threads are used.
+ */
+msInterface::ScanPrefetcher::ScanPrefetcher(const MsInterface& file, Transform transform,
+                                            size_t nAhead, unsigned int nThread)
+    : _file(file), _transform(std::move(transform))
+{
+    _file.getScanNumbers(_scans);
+    _init(nAhead, nThread);
+}
+
+/**
+ \brief Prefetch \p scans from \p file and apply \p transform to each scan.
+
+ \param file Initialized MsInterface to read scans from.
+ \param scans Scan numbers to iterate through in the order they should be returned.
+ \param transform Function applied to each scan on the decoding threads. Must be safe to call concurrently.
+ \param nAhead Maximum number of decoded scans to hold ahead of the consumer.
+ \param nThread Number of decoding threads. If 0, one less than \p std::thread::hardware_concurrency() threads are used.
+ */
+msInterface::ScanPrefetcher::ScanPrefetcher(const MsInterface& file, const std::vector<size_t>& scans,
+                                            Transform transform, size_t nAhead, unsigned int nThread)
+    : _file(file), _transform(std::move(transform)), _scans(scans)
+{
+    _init(nAhead, nThread);
+}
+
+msInterface::ScanPrefetcher::~ScanPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _slotFree.notify_all();
+    for(auto& thread: _threads)
+        thread.join();
+}
+
+void msInterface::ScanPrefetcher::_init(size_t nAhead, unsigned int nThread)
+{
+    _nextDecode = 0;
+    _nextConsume = 0;
+    _stop = false;
+    _slots = std::vector<Slot>(std::max(nAhead, (size_t)1));
+
+    unsigned int _nThread = nThread;
+    if(_nThread == 0) {
+        unsigned int nCores = std::thread::hardware_concurrency();
+        _nThread = nCores > 1 ? nCores - 1 : 1;
+    }
+    _nThread = (unsigned int)std::min((size_t)_nThread, std::min(_slots.size(), _scans.size()));
+    for(unsigned int i = 0; i < _nThread; i++)
+        _threads.emplace_back(&ScanPrefetcher::_worker, this);
+}
+
+//! Decode scans until all scans have been decoded or the prefetcher is destroyed.
+void msInterface::ScanPrefetcher::_worker()
+{
+    size_t nSlots = _slots.size();
+    size_t nScans = _scans.size();
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true) {
+        _slotFree.wait(lock, [this, nSlots, nScans]{
+            return _stop || _nextDecode >= nScans || _nextDecode < _nextConsume + nSlots;
+        });
+        if(_stop || _nextDecode >= nScans) return;
+
+        size_t i = _nextDecode++;
+        Slot& slot = _slots[i % nSlots];
+        slot.state = SlotState::DECODING;
+        lock.unlock();
+
+        // Start paging in the scan which will go into this slot next time around the ring.
+        if(i + nSlots < nScans)
+            _file.adviseScan(_scans[i + nSlots]);
+
+        bool found = false;
+        std::exception_ptr error;
+        try {
+            found = _file.getScan(_scans[i], slot.scan);
+            if(found && _transform)
+                _transform(slot.scan);
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        slot.found = found;
+        slot.error = error;
+        slot.state = SlotState::READY;
+        _slotReady.notify_all();
+
+        // Scans after a failed scan are never returned, so stop decoding them.
+        if(error) {
+            _stop = true;
+            _slotFree.notify_all();
+        }
+    }
+}
+
+/**
+ \brief Get the next scan. <br>
+
+ Scans which MsInterface::getScan could not find are skipped.
+ If decoding a scan threw an exception, it is rethrown when that scan is reached,
+ after every scan before it has been returned. There are no more scans after an exception.
+ \param scan Populated with next scan.
+ \return false if there are no more scans.
+ \throws Any exception thrown by MsInterface::getScan or the transform while decoding the next scan.
+ */
+bool msInterface::ScanPrefetcher::next(Scan& scan)
+{
+    size_t nSlots = _slots.size();
+    while(_nextConsume < _scans.size()) {
+        Slot& slot = _slots[_nextConsume % nSlots];
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _slotReady.wait(lock, [&slot]{ return slot.state == SlotState::READY; });
+        }
+
+        // The slot can not be reused by a worker until _nextConsume is incremented.
+        bool found = slot.found;
+        std::exception_ptr error = slot.error;
+        slot.error = nullptr;
+        if(found && !error) scan.swap(slot.scan);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            slot.state = SlotState::EMPTY;
+            _nextConsume = error ? _scans.size() : _nextConsume + 1;
+        }
+        _slotFree.notify_all();
+        if(error) std::rethrow_exception(error);
+        if(found) return true;
+    }
+    return false;
+}
@@ -0,0 +1,146 @@
+//
+// scanPreprocessor.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+#include <msInterface/scanPreprocessor.hpp>
+
+using namespace utils;
+
+//! Get the m/z windows around the precursor and neutral losses of \p scan which should be removed.
+void msInterface::ScanPreprocessor::_removalWindows(const Scan& scan,
+                                                    std::vector<std::pair<double, double> >& windows) const
+{
+    windows.clear();
+    if(!_removePrecursor || scan.getLevel() < 2) return;
+
+    const std::string precursorMZ = scan.getPrecursor().getMZ();
+    double mz = 0;
+    const char* begin = precursorMZ.c_str();
+    if(utils::parseDouble(begin, begin + precursorMZ.size(), mz) == begin) return;
+
+    int charge = std::max(scan.getPrecursor().getCharge(), 1);
+    windows.emplace_back(mz, mz);
+    for(double loss: _neutralLosses)
+        windows.emplace_back(mz - loss / charge, mz - loss / charge);
+    for(auto& window: windows) {
+        double width = _precursorTolerance.width(window.first);
+        window.first -= width;
+        window.second += width;
+    }
+}
+
+/**
+ \brief Apply the configured stages to \p scan. <br>
+
+ Peaks are sorted by m/z if the top N filter is enabled. The surviving peaks are compacted to the front
+ of the peak array as it is scanned. When the scan moves into a new top N window, the peaks kept from
+ the previous window are reduced to the \p n most intense, keeping their m/z order.
+ \param scan Scan to process in place.
+ */
+void msInterface::ScanPreprocessor::process(Scan& scan) const
+{
+    std::vector<std::pair<double, double> > windows;
+    _removalWindows(scan, windows);
+    if(_topN > 0) scan.sortByMZ();
+
+    auto& ions = scan.getIons();
+    std::vector<ScanIntensity> scratch;
+    size_t out = 0;
+    size_t windowStart = 0;
+    long currentWindow = 0;
+
+    // Keep only the _topN most intense peaks in [windowStart, out)
+    auto finishWindow = [&]() {
+        size_t count = out - windowStart;
+        if(_topN == 0 || count <= _topN) return;
+        scratch.resize(count);
+        for(size_t i = 0; i < count; i++)
+            scratch[i] = ions[windowStart + i].getIntensity();
+        std::nth_element(scratch.begin(), scratch.begin() + (_topN - 1), scratch.end(), std::greater<ScanIntensity>());
+        ScanIntensity threshold = scratch[_topN - 1];
+        size_t nAbove = (size_t)std::count_if(scratch.begin(), scratch.end(),
+                                               [threshold](ScanIntensity x){ return x > threshold; });
+        size_t nTies = _topN - nAbove;
+        size_t kept = windowStart;
+        for(size_t i = windowStart; i < out; i++) {
+            ScanIntensity intensity = ions[i].getIntensity();
+            if(intensity > threshold || (intensity == threshold && nTies > 0 && nTies--))
+                ions[kept++] = ions[i];
+        }
+        out = kept;
+    };
+
+    for(size_t i = 0; i < ions.size(); i++) {
+        ScanMZ mz = ions[i].getMZ();
+        if(mz < _minMZ || mz > _maxMZ) continue;
+        bool remove = false;
+        for(const auto& window: windows) {
+            if(mz >= window.first && mz <= window.second) {
+                remove = true;
+                break;
+            }
+        }
+        if(remove) continue;
+
+        if(_topN > 0) {
+            long window = (long)std::floor(mz / _windowWidth);
+            if(out == windowStart) currentWindow = window;
+            else if(window != currentWindow) {
+                finishWindow();
+                windowStart = out;
+                currentWindow = window;
+            }
+        }
+        ions[out++] = ions[i];
+    }
+    finishWindow();
+    ions.resize(out);
+
+    switch(_normalization) {
+        case Normalization::SQRT:
+            for(auto& ion: ions)
+                ion.setIntensity(std::sqrt(std::max(ion.getIntensity(), (ScanIntensity)0)));
+            break;
+        case Normalization::RANK: {
+            std::vector<size_t> order(ions.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&ions](size_t lhs, size_t rhs){
+                return ions[lhs].getIntensity() < ions[rhs].getIntensity();
+            });
+            double n = (double)ions.size();
+            for(size_t rank = 0; rank < order.size(); rank++)
+                ions[order[rank]].setIntensity((ScanIntensity)((double)(rank + 1) / n));
+            break;
+        }
+        default: break;
+    }
+    scan.updateRanges();
+}
@@ -0,0 +1,214 @@
+//
+// spectralSimilarity.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
+#include <msInterface/spectralSimilarity.hpp>
+
+using namespace utils;
+
+namespace {
+    double const PI = 3.14159265358979323846;
+
+    /**
+     \brief Score every element of \p targets on \p nThread threads.
+     \param compare Function which scores one target.
+     */
+    template<typename T, typename F>
+    void compareMany(const std::vector<T>& targets, std::vector<msInterface::SimilarityScores>& scores,
+                     unsigned int nThread, F compare)
+    {
+        scores.resize(targets.size());
+        unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+        _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, targets.size()));
+        std::vector<std::thread> threads;
+        for(unsigned int t = 0; t < _nThread; t++) {
+            threads.emplace_back([&targets, &scores, &compare, t, _nThread] {
+                for(size_t i = t; i < targets.size(); i += _nThread)
+                    scores[i] = compare(targets[i]);
+            });
+        }
+        for(auto& thread: threads)
+            thread.join();
+    }
+}
+
+msInterface::PreparedSpectrum::PreparedSpectrum(const Scan& scan)
+{
+    const auto& ions = scan.getIons();
+    _mz.resize(ions.size());
+    _intensity.resize(ions.size());
+    if(scan.isSorted()) {
+        for(size_t i = 0; i < ions.size(); i++) {
+            _mz[i] = ions[i].getMZ();
+            _intensity[i] = ions[i].getIntensity();
+        }
+    }
+    else {
+        std::vector<size_t> order(ions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&ions](size_t lhs, size_t rhs){
+            return ions[lhs].getMZ() < ions[rhs].getMZ();
+        });
+        for(size_t i = 0; i < ions.size(); i++) {
+            _mz[i] = ions[order[i]].getMZ();
+            _intensity[i] = ions[order[i]].getIntensity();
+        }
+    }
+    _init();
+}
+
+/**
+ \brief Prepare spectrum from separate m/z and intensity arrays.
+ \param mz m/z array sorted in ascending order.
+ \param intensity Intensity array.
+ \param n Number of peaks.
+ */
+msInterface::PreparedSpectrum::PreparedSpectrum(const double* mz, const double* intensity, size_t n)
+    : _mz(mz, mz + n), _intensity(intensity, intensity + n)
+{
+    _init();
+}
+
+//! Compute normalized intensity vectors.
+void msInterface::PreparedSpectrum::_init()
+{
+    size_t n = _intensity.size();
+    double sum = 0, sumSquares = 0;
+    for(size_t i = 0; i < n; i++) {
+        sum += _intensity[i];
+        sumSquares += _intensity[i] * _intensity[i];
+    }
+    double norm = std::sqrt(sumSquares);
+
+    _unit.resize(n);
+    _probability.resize(n);
+    _xLogX.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        _unit[i] = norm > 0 ? _intensity[i] / norm : 0;
+        _probability[i] = sum > 0 ? _intensity[i] / sum : 0;
+        _xLogX[i] = _probability[i] > 0 ? _probability[i] * std::log(_probability[i]) : 0;
+    }
+}
+
+/**
+ \brief Compute similarity scores between two spectra. <br>
+
+ Peaks are aligned one to one in a single pass over both sorted peak lists.
+ When the peaks at the front of both lists are within \p tolerance they are paired,
+ otherwise the peak with the smaller m/z is skipped. The scores are then computed in one
+ loop over the aligned pairs.
+
+ Because only aligned peaks contribute to the entropy similarity, it is computed as
+ sum((a + b) * ln(a + b) - a * ln(a) - b * ln(b)) / ln(4) over the aligned pairs,
+ where a and b are the intensities of each spectrum divided by their sum.
+ \param lhs First spectrum.
+ \param rhs Second spectrum.
+ \param tolerance Fragment m/z tolerance.
+ \return Similarity scores.
+ */
+msInterface::SimilarityScores msInterface::compareSpectra(const PreparedSpectrum& lhs, const PreparedSpectrum& rhs,
+                                                          const MZTolerance& tolerance)
+{
+    SimilarityScores scores;
+    size_t nLhs = lhs._mz.size();
+    size_t nRhs = rhs._mz.size();
+    if(nLhs == 0 || nRhs == 0) return scores;
+
+    // Align peaks
+    std::vector<size_t> lhsIndex, rhsIndex;
+    lhsIndex.reserve(std::min(nLhs, nRhs));
+    rhsIndex.reserve(std::min(nLhs, nRhs));
+    const double* lhsMZ = lhs._mz.data();
+    const double* rhsMZ = rhs._mz.data();
+    for(size_t i = 0, j = 0; i < nLhs && j < nRhs;) {
+        double diff = lhsMZ[i] - rhsMZ[j];
+        if(std::abs(diff) <= tolerance.width(lhsMZ[i])) {
+            lhsIndex.push_back(i++);
+            rhsIndex.push_back(j++);
+        }
+        else if(diff < 0) i++;
+        else j++;
+    }
+
+    // Score aligned pairs
+    size_t nMatched = lhsIndex.size();
+    double dot = 0, cosine = 0, entropy = 0;
+    for(size_t k = 0; k < nMatched; k++) {
+        size_t i = lhsIndex[k], j = rhsIndex[k];
+        dot += lhs._intensity[i] * rhs._intensity[j];
+        cosine += lhs._unit[i] * rhs._unit[j];
+        double sum = lhs._probability[i] + rhs._probability[j];
+        if(sum > 0)
+            entropy += sum * std::log(sum) - lhs._xLogX[i] - rhs._xLogX[j];
+    }
+
+    scores.matchedPeaks = nMatched;
+    scores.dotProduct = dot;
+    scores.cosine = std::min(std::max(cosine, 0.0), 1.0);
+    scores.spectralContrastAngle = 1 - 2 * std::acos(scores.cosine) / PI;
+    scores.entropy = std::min(std::max(entropy / std::log(4.0), 0.0), 1.0);
+    return scores;
+}
+
+//! Overloaded function which prepares \p lhs and \p rhs before comparing them.
+msInterface::SimilarityScores msInterface::compareSpectra(const Scan& lhs, const Scan& rhs,
+                                                          const MZTolerance& tolerance)
+{
+    return compareSpectra(PreparedSpectrum(lhs), PreparedSpectrum(rhs), tolerance);
+}
+
+/**
+ \brief Compare query to each scan in \p scans in parallel.
+ \param scans Scans to compare query to.
+ \param scores Populated with scores for each scan in \p scans.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::SimilarityQuery::compare(const std::vector<Scan>& scans, std::vector<SimilarityScores>& scores,
+                                           unsigned int nThread) const
+{
+    compareMany(scans, scores, nThread, [this](const Scan& scan){
+        return compareSpectra(_query, PreparedSpectrum(scan), _tolerance);
+    });
+}
+
+/**
+ \brief Compare query to each spectrum in \p spectra in parallel.
+ \param spectra Prepared spectra to compare query to.
+ \param scores Populated with scores for each spectrum in \p spectra.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::SimilarityQuery::compare(const std::vector<PreparedSpectrum>& spectra,
+                                           std::vector<SimilarityScores>& scores, unsigned int nThread) const
+{
+    compareMany(spectra, scores, nThread, [this](const PreparedSpectrum& spectrum){
+        return compareSpectra(_query, spectrum, _tolerance);
+    });
+}
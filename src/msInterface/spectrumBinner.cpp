@@ -0,0 +1,222 @@
+//
+// spectrumBinner.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <msInterface/spectrumBinner.hpp>
+
+using namespace utils;
+
+/**
+ \brief Constructor.
+ \param binWidth Width of each bin in m/z.
+ \param offset Offset of bin boundaries as a fraction of \p binWidth.
+ \param minMZ Lower m/z bound of first bin.
+ \param maxMZ Upper m/z bound of last bin.
+ \param transform Transformation applied to each peak intensity.
+ \param aggregate How intensities of peaks in the same bin are combined.
+ \throws std::invalid_argument if \p binWidth is not positive, \p maxMZ is not greater than \p minMZ,
+ or there would be more than 2^32 bins.
+ */
+msInterface::SpectrumBinner::SpectrumBinner(double binWidth, double offset, double minMZ, double maxMZ,
+                                            Transform transform, Aggregate aggregate)
+{
+    if(!(binWidth > 0))
+        throw std::invalid_argument("Bin width must be greater than 0!");
+    if(!(maxMZ > minMZ))
+        throw std::invalid_argument("maxMZ must be greater than minMZ!");
+    _binWidth = binWidth;
+    _offset = offset;
+    _minMZ = minMZ;
+    _maxMZ = maxMZ;
+    _transform = transform;
+    _aggregate = aggregate;
+
+    double nBins = std::ceil((_maxMZ - _minMZ) / _binWidth + _offset);
+    if(nBins > (double)std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("Too many bins!");
+    _nBins = nBins > 0 ? (size_t)nBins : 0;
+}
+
+long msInterface::SpectrumBinner::binIndex(double mz) const {
+    return (long)std::floor((mz - _minMZ) / _binWidth + _offset);
+}
+
+float msInterface::SpectrumBinner::_transformIntensity(double intensity) const
+{
+    switch(_transform) {
+        case Transform::SQRT: return (float)std::sqrt(std::max(intensity, 0.0));
+        case Transform::LOG1P: return (float)std::log1p(std::max(intensity, 0.0));
+        default: return (float)intensity;
+    }
+}
+
+/**
+ \brief Bin \p scan into a dense vector.
+ \param scan Scan to bin.
+ \param out Array of at least SpectrumBinner::size() elements. Every element is overwritten.
+ */
+void msInterface::SpectrumBinner::binDense(const Scan& scan, float* out) const
+{
+    std::fill(out, out + _nBins, 0.0f);
+    long nBins = (long)_nBins;
+    for(const auto& ion: scan.getIons()) {
+        long bin = binIndex(ion.getMZ());
+        if(bin < 0 || bin >= nBins) continue;
+        float value = _transformIntensity(ion.getIntensity());
+        if(_aggregate == Aggregate::SUM) out[bin] += value;
+        else out[bin] = std::max(out[bin], value);
+    }
+}
+
+/**
+ \brief Bin \p scan into a sparse vector.
+ \param scan Scan to bin.
+ \param indices Populated with the index of each non empty bin in ascending order.
+ \param values Populated with the value of each bin in \p indices.
+ */
+void msInterface::SpectrumBinner::binSparse(const Scan& scan, std::vector<uint32_t>& indices,
+                                            std::vector<float>& values) const
+{
+    indices.clear();
+    values.clear();
+    long nBins = (long)_nBins;
+    std::vector<std::pair<uint32_t, float> > peaks;
+    peaks.reserve(scan.getIons().size());
+    for(const auto& ion: scan.getIons()) {
+        long bin = binIndex(ion.getMZ());
+        if(bin < 0 || bin >= nBins) continue;
+        peaks.emplace_back((uint32_t)bin, _transformIntensity(ion.getIntensity()));
+    }
+
+    // Peaks in the same bin are adjacent if the scan is sorted.
+    if(!scan.isSorted()) {
+        std::stable_sort(peaks.begin(), peaks.end(), [](const std::pair<uint32_t, float>& lhs,
+                                                        const std::pair<uint32_t, float>& rhs){
+            return lhs.first < rhs.first;
+        });
+    }
+    for(const auto& peak: peaks) {
+        if(!indices.empty() && indices.back() == peak.first) {
+            if(_aggregate == Aggregate::SUM) values.back() += peak.second;
+            else values.back() = std::max(values.back(), peak.second);
+        }
+        else {
+            indices.push_back(peak.first);
+            values.push_back(peak.second);
+        }
+    }
+}
+
+/**
+ \brief Bin scans from \p file into a dense row major matrix in parallel.
+ \param file Initialized MsInterface.
+ \param scans Scan numbers to bin. Row i of \p out is scans[i].
+ \param out Array of at least scans.size() * SpectrumBinner::size() elements.
+ Rows for scans which could not be read are set to 0.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::SpectrumBinner::binDense(const MsInterface& file, const std::vector<size_t>& scans, float* out,
+                                           unsigned int nThread) const
+{
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, scans.size()));
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < _nThread; t++) {
+        threads.emplace_back([this, &file, &scans, out, t, _nThread] {
+            Scan scan;
+            for(size_t i = t; i < scans.size(); i += _nThread) {
+                float* row = out + i * _nBins;
+                if(file.getScan(scans[i], scan)) binDense(scan, row);
+                else std::fill(row, row + _nBins, 0.0f);
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
+
+/**
+ \brief Bin scans from \p file into a sparse matrix in parallel. <br>
+
+ Each scan is decoded and binned once. After the number of non empty bins in every row is known
+ the rows are copied into the final arrays in parallel.
+ \param file Initialized MsInterface.
+ \param scans Scan numbers to bin. Row i of \p matrix is scans[i].
+ Rows for scans which could not be read are empty.
+ \param matrix Populated with binned scans.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::SpectrumBinner::binSparse(const MsInterface& file, const std::vector<size_t>& scans,
+                                            CsrMatrix& matrix, unsigned int nThread) const
+{
+    size_t nRows = scans.size();
+    matrix.clear();
+    matrix.nCols = _nBins;
+    matrix.indptr.assign(nRows + 1, 0);
+
+    std::vector<std::vector<uint32_t> > rowIndices(nRows);
+    std::vector<std::vector<float> > rowValues(nRows);
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nRows));
+
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < _nThread; t++) {
+        threads.emplace_back([this, &file, &scans, &rowIndices, &rowValues, t, _nThread] {
+            Scan scan;
+            for(size_t i = t; i < scans.size(); i += _nThread) {
+                if(file.getScan(scans[i], scan))
+                    binSparse(scan, rowIndices[i], rowValues[i]);
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+
+    for(size_t i = 0; i < nRows; i++)
+        matrix.indptr[i + 1] = matrix.indptr[i] + rowIndices[i].size();
+    matrix.indices.resize(matrix.indptr.back());
+    matrix.data.resize(matrix.indptr.back());
+
+    threads.clear();
+    for(unsigned int t = 0; t < _nThread; t++) {
+        threads.emplace_back([&matrix, &rowIndices, &rowValues, t, _nThread] {
+            for(size_t i = t; i < rowIndices.size(); i += _nThread) {
+                std::copy(rowIndices[i].begin(), rowIndices[i].end(), matrix.indices.begin() + matrix.indptr[i]);
+                std::copy(rowValues[i].begin(), rowValues[i].end(), matrix.data.begin() + matrix.indptr[i]);
+                std::vector<uint32_t>().swap(rowIndices[i]);
+                std::vector<float>().swap(rowValues[i]);
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
@@ -0,0 +1,207 @@
+//
+// xicExtractor.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <thread>
+
+#include <msInterface/xicExtractor.hpp>
+
+using namespace utils;
+
+void msInterface::XicResult::clear()
+{
+    scanNum.clear();
+    rt.clear();
+    targetOffsets.clear();
+    firstScan.clear();
+    intensity.clear();
+}
+
+/**
+ \brief Get the extracted ion chromatogram for \p target.
+ \param target Index of target.
+ \param chromatogram Populated with chromatogram.
+ */
+void msInterface::XicResult::getXic(size_t target, Chromatogram& chromatogram) const
+{
+    chromatogram.clear();
+    chromatogram.setId(std::to_string(target));
+    size_t begin = targetOffsets.at(target);
+    size_t end = targetOffsets.at(target + 1);
+    for(size_t i = begin; i < end; i++)
+        chromatogram.add(rt[firstScan[target] + (i - begin)], intensity[i]);
+}
+
+/**
+ \brief Extract ion chromatograms for every target. <br>
+
+ MsInterface::summarizeRun is called first to find the MS1 scans and their retention times.
+ Use the other overload if a RunSummary for \p file is already available.
+ \param file Initialized MsInterface.
+ \param result Populated with chromatograms.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::XicExtractor::extract(const MsInterface& file, XicResult& result, unsigned int nThread) const
+{
+    RunSummary summary;
+    file.summarizeRun(summary, nThread);
+    extract(file, summary, result, nThread);
+}
+
+/**
+ \brief Extract ion chromatograms for every target.
+
+ \param file Initialized MsInterface.
+ \param summary RunSummary of \p file.
+ \param result Populated with chromatograms.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void msInterface::XicExtractor::extract(const MsInterface& file, const RunSummary& summary,
+                                        XicResult& result, unsigned int nThread) const
+{
+    result.clear();
+
+    // MS1 scans in retention time order
+    std::vector<size_t> ms1Rows;
+    for(size_t i = 0; i < summary.size(); i++)
+        if(summary.level[i] == 1) ms1Rows.push_back(i);
+    std::stable_sort(ms1Rows.begin(), ms1Rows.end(), [&summary](size_t lhs, size_t rhs){
+        return summary.rt[lhs] < summary.rt[rhs];
+    });
+    size_t nScans = ms1Rows.size();
+    for(size_t row: ms1Rows) {
+        result.scanNum.push_back(summary.scanNum[row]);
+        result.rt.push_back(summary.rt[row]);
+    }
+
+    // Find the range of scans each target covers and lay out the output.
+    size_t nTargets = _targets.size();
+    std::vector<size_t> lastScan(nTargets);
+    result.firstScan.resize(nTargets);
+    result.targetOffsets.resize(nTargets + 1);
+    result.targetOffsets[0] = 0;
+    for(size_t t = 0; t < nTargets; t++) {
+        size_t first = std::lower_bound(result.rt.begin(), result.rt.end(), _targets[t].rtMin) - result.rt.begin();
+        size_t last = std::upper_bound(result.rt.begin(), result.rt.end(), _targets[t].rtMax) - result.rt.begin();
+        if(last < first) last = first;
+        result.firstScan[t] = first;
+        lastScan[t] = last;
+        result.targetOffsets[t + 1] = result.targetOffsets[t] + (last - first);
+    }
+    result.intensity.assign(result.targetOffsets.back(), 0);
+    if(nScans == 0 || nTargets == 0) return;
+
+    // m/z windows of targets sorted by lower bound
+    std::vector<size_t> order(nTargets);
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<double> lower(nTargets), upper(nTargets);
+    for(size_t t = 0; t < nTargets; t++) {
+        double tolerance = _targets[t].mz * _targets[t].ppm / 1e6;
+        lower[t] = _targets[t].mz - tolerance;
+        upper[t] = _targets[t].mz + tolerance;
+    }
+    std::sort(order.begin(), order.end(), [&lower](size_t lhs, size_t rhs){
+        return lower[lhs] < lower[rhs];
+    });
+    std::vector<size_t> rank(nTargets);
+    for(size_t i = 0; i < nTargets; i++)
+        rank[order[i]] = i;
+    auto byRank = [&rank](size_t lhs, size_t rhs){
+        return rank[lhs] < rank[rhs];
+    };
+
+    // Targets in the order they become active.
+    std::vector<size_t> byFirstScan(order);
+    std::stable_sort(byFirstScan.begin(), byFirstScan.end(), [&result](size_t lhs, size_t rhs){
+        return result.firstScan[lhs] < result.firstScan[rhs];
+    });
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nScans));
+    std::vector<std::thread> threads;
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            Scan scan;
+            std::vector<double> mz, intensity;
+            // Targets covering the current scan in order of increasing lower bound.
+            std::vector<size_t> active, arriving, merged;
+            size_t next = 0;
+            for(size_t s = thread; s < nScans; s += _nThread) {
+                arriving.clear();
+                for(; next < nTargets && result.firstScan[byFirstScan[next]] <= s; next++)
+                    if(lastScan[byFirstScan[next]] > s) arriving.push_back(byFirstScan[next]);
+                active.erase(std::remove_if(active.begin(), active.end(), [&lastScan, s](size_t t){
+                    return lastScan[t] <= s;
+                }), active.end());
+                if(!arriving.empty()) {
+                    std::sort(arriving.begin(), arriving.end(), byRank);
+                    merged.clear();
+                    std::merge(active.begin(), active.end(), arriving.begin(), arriving.end(),
+                               std::back_inserter(merged), byRank);
+                    active.swap(merged);
+                }
+                if(active.empty() || !file.getScan(result.scanNum[s], scan)) continue;
+
+                const auto& ions = scan.getIons();
+                mz.resize(ions.size());
+                intensity.resize(ions.size());
+                for(size_t i = 0; i < ions.size(); i++) {
+                    mz[i] = ions[i].getMZ();
+                    intensity[i] = ions[i].getIntensity();
+                }
+                if(!std::is_sorted(mz.begin(), mz.end())) {
+                    std::vector<size_t> peakOrder(mz.size());
+                    std::iota(peakOrder.begin(), peakOrder.end(), 0);
+                    std::sort(peakOrder.begin(), peakOrder.end(), [&mz](size_t lhs, size_t rhs){
+                        return mz[lhs] < mz[rhs];
+                    });
+                    for(size_t i = 0; i < peakOrder.size(); i++) {
+                        mz[i] = ions[peakOrder[i]].getMZ();
+                        intensity[i] = ions[peakOrder[i]].getIntensity();
+                    }
+                }
+
+                // Targets are visited in order of increasing lower bound, so the first peak
+                // which could match the next target never moves backwards.
+                auto peak = mz.begin();
+                for(size_t t: active) {
+                    peak = std::lower_bound(peak, mz.end(), lower[t]);
+                    if(peak == mz.end()) break;
+
+                    double sum = 0;
+                    for(auto it = peak; it != mz.end() && *it <= upper[t]; ++it)
+                        sum += intensity[it - mz.begin()];
+                    result.intensity[result.targetOffsets[t] + (s - result.firstScan[t])] = sum;
+                }
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+}
@@ -0,0 +1,250 @@
+//
+// peptideMapper.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#include <numeric>
+
+#include <peptideMapper.hpp>
+
+uint32_t const utils::PeptideMapper::NONE;
+uint32_t const utils::PeptideMapper::ROOT;
+int const utils::PeptideMapper::ALPHABET_SIZE;
+
+/**
+ \brief Constructor. PeptideMapper::build must be called before mapping.
+ \param ilEquivalent Should I and L be treated as the same residue?
+ */
+utils::PeptideMapper::PeptideMapper(bool ilEquivalent)
+{
+    _ilEquivalent = ilEquivalent;
+    _initAlphabet();
+    build(std::vector<std::string>());
+}
+
+/**
+ \brief Construct automaton for \p peptides.
+ \param peptides Peptide sequences to search for.
+ \param ilEquivalent Should I and L be treated as the same residue?
+ */
+utils::PeptideMapper::PeptideMapper(const std::vector<std::string>& peptides, bool ilEquivalent)
+{
+    _ilEquivalent = ilEquivalent;
+    _initAlphabet();
+    build(peptides);
+}
+
+void utils::PeptideMapper::_initAlphabet()
+{
+    std::fill(_code, _code + 256, -1);
+    for(int c = 0; c < ALPHABET_SIZE; c++) {
+        _code['A' + c] = (int8_t)c;
+        _code['a' + c] = (int8_t)c;
+    }
+    if(_ilEquivalent) {
+        _code['L'] = _code['I'];
+        _code['l'] = _code['I'];
+    }
+}
+
+/**
+ \brief Build automaton for \p peptides, replacing any existing peptides. <br>
+
+ The trie is built level by level from the sorted peptides, so the children of each state
+ are created consecutively and no per node containers are needed.
+ \param peptides Peptide sequences. Residues are case insensitive.
+ \throws std::invalid_argument if a peptide is empty or contains a character other than A-Z.
+ */
+void utils::PeptideMapper::build(const std::vector<std::string>& peptides)
+{
+    size_t nPeptides = peptides.size();
+    if(nPeptides >= NONE)
+        throw std::invalid_argument("Too many peptides!");
+
+    // Convert peptides to alphabet codes.
+    std::vector<std::string> normalized(nPeptides);
+    _lengths.resize(nPeptides);
+    for(size_t i = 0; i < nPeptides; i++) {
+        if(peptides[i].empty())
+            throw std::invalid_argument("Peptide sequences can not be empty!");
+        normalized[i].resize(peptides[i].size());
+        for(size_t j = 0; j < peptides[i].size(); j++) {
+            int8_t c = _code[(unsigned char)peptides[i][j]];
+            if(c < 0)
+                throw std::invalid_argument("Invalid residue in peptide: " + peptides[i]);
+            normalized[i][j] = (char)c;
+        }
+        _lengths[i] = (uint32_t)peptides[i].size();
+    }
+
+    std::vector<uint32_t> order(nPeptides);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&normalized](uint32_t lhs, uint32_t rhs) {
+        return normalized[lhs] < normalized[rhs];
+    });
+
+    _firstChild.clear();
+    _label.clear();
+    _outputBegin.clear();
+    _outputs.clear();
+    _outputs.reserve(nPeptides);
+
+    // Each state is the range of sorted peptides which share its prefix.
+    // States of each level are numbered consecutively after the states of the previous level.
+    typedef std::pair<size_t, size_t> Range;
+    std::vector<Range> level, nextLevel;
+    level.emplace_back(0, nPeptides);
+    _label.push_back(0);
+    for(size_t depth = 0; !level.empty(); depth++) {
+        nextLevel.clear();
+        for(const Range& range: level) {
+            size_t i = range.first;
+
+            // Shorter strings sort first, so peptides ending at this state are at the beginning of the range.
+            _outputBegin.push_back((uint32_t)_outputs.size());
+            for(; i < range.second && normalized[order[i]].size() == depth; i++)
+                _outputs.push_back(order[i]);
+
+            _firstChild.push_back((uint32_t)_label.size());
+            while(i < range.second) {
+                char c = normalized[order[i]][depth];
+                size_t j = i + 1;
+                while(j < range.second && normalized[order[j]][depth] == c)
+                    j++;
+                _label.push_back((uint8_t)c);
+                nextLevel.emplace_back(i, j);
+                i = j;
+            }
+        }
+        level.swap(nextLevel);
+        if(_label.size() >= NONE)
+            throw std::invalid_argument("Too many states in automaton!");
+    }
+    size_t nStates = _label.size();
+    _firstChild.push_back((uint32_t)nStates);
+    _outputBegin.push_back((uint32_t)_outputs.size());
+
+    std::fill(_rootNext, _rootNext + ALPHABET_SIZE, ROOT);
+    for(uint32_t v = _firstChild[ROOT]; v < _firstChild[ROOT + 1]; v++)
+        _rootNext[_label[v]] = v;
+
+    // States are in breadth first order, so failure links of shallower states are always set first.
+    _fail.assign(nStates, ROOT);
+    _dictLink.assign(nStates, NONE);
+    for(uint32_t u = 0; u < nStates; u++) {
+        for(uint32_t v = _firstChild[u]; v < _firstChild[u + 1]; v++) {
+            uint32_t fail = u == ROOT ? ROOT : _next(_fail[u], _label[v]);
+            _fail[v] = fail;
+            _dictLink[v] = _hasOutputs(fail) ? fail : _dictLink[fail];
+        }
+    }
+}
+
+//! Child of \p state with edge \p c or NONE.
+uint32_t utils::PeptideMapper::_child(uint32_t state, uint8_t c) const
+{
+    for(uint32_t i = _firstChild[state]; i < _firstChild[state + 1]; i++) {
+        if(_label[i] == c) return i;
+        if(_label[i] > c) break;
+    }
+    return NONE;
+}
+
+//! Follow failure links from \p state until a transition on \p c is found.
+uint32_t utils::PeptideMapper::_next(uint32_t state, uint8_t c) const
+{
+    while(state != ROOT) {
+        uint32_t child = _child(state, c);
+        if(child != NONE) return child;
+        state = _fail[state];
+    }
+    return _rootNext[c];
+}
+
+/**
+ \brief Find every peptide in \p sequence. <br>
+
+ Characters which are not A-Z break matches, so peptides never span them.
+ \param sequence Protein sequence to search.
+ \param protein Index to use for PeptideHit::protein
+ \param hits Hits are appended in the order of the peptide C terminus in \p sequence.
+ */
+void utils::PeptideMapper::map(StringView sequence, size_t protein, HitListType& hits) const
+{
+    uint32_t state = ROOT;
+    size_t len = sequence.size();
+    for(size_t i = 0; i < len; i++) {
+        int8_t c = _code[(unsigned char)sequence[i]];
+        if(c < 0) {
+            state = ROOT;
+            continue;
+        }
+        state = _next(state, (uint8_t)c);
+        for(uint32_t out = _hasOutputs(state) ? state : _dictLink[state]; out != NONE; out = _dictLink[out]) {
+            for(uint32_t k = _outputBegin[out]; k < _outputBegin[out + 1]; k++) {
+                uint32_t peptide = _outputs[k];
+                hits.emplace_back(peptide, protein, i + 1 - _lengths[peptide]);
+            }
+        }
+    }
+}
+
+/**
+ \brief Find every peptide in every protein in \p fasta.
+ \param fasta Initialized FastaFile.
+ \param hits Populated with hits sorted by protein, start and peptide.
+ \param nThread Number of threads to use. If 0, \p std::thread::hardware_concurrency() threads are used.
+ */
+void utils::PeptideMapper::map(const FastaFile& fasta, HitListType& hits, unsigned int nThread) const
+{
+    hits.clear();
+    size_t nProteins = fasta.getSequenceCount();
+    if(nProteins == 0 || _lengths.empty()) return;
+
+    unsigned int _nThread = nThread == 0 ? std::thread::hardware_concurrency() : nThread;
+    _nThread = (unsigned int)std::max((size_t)1, std::min((size_t)_nThread, nProteins));
+    std::vector<HitListType> threadHits(_nThread);
+    std::vector<std::thread> threads;
+    for(unsigned int thread = 0; thread < _nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            std::string buffer;
+            for(size_t i = thread; i < nProteins; i += _nThread)
+                map(fasta.getSequence(i, buffer), i, threadHits[thread]);
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+
+    size_t nHits = 0;
+    for(const auto& h: threadHits)
+        nHits += h.size();
+    hits.reserve(nHits);
+    for(auto& h: threadHits) {
+        hits.insert(hits.end(), h.begin(), h.end());
+        HitListType().swap(h);
+    }
+    std::sort(hits.begin(), hits.end());
+}
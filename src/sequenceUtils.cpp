@@ -93,10 +93,11 @@ void utils::_digest_all_res(unsigned int begin, unsigned int end,
                             std::string cleavagePattern,
                             double minMz, double maxMz, int minCharge, int maxCharge)
 {
+    std::string buffer;
     for(unsigned int i = begin; i < end; i++)
     {
         std::vector<std::string> seq_temp;
-        residues.digest(fasta.at(i), seq_temp,
+        residues.digest(fasta.getSequence(i, buffer), seq_temp,
                         nMissedCleavages, length_filter, cleavagePattern,
                         minMz, maxMz, minCharge, maxCharge);
         seqs[fasta.getIndexID(i)] = seq_temp;
@@ -109,10 +110,11 @@ void utils::_digest_all_len(unsigned int begin, unsigned int end,
                             unsigned nMissedCleavages, size_t minLen, size_t maxLen,
                             std::string cleavagePattern)
 {
+    std::string buffer;
     for(unsigned int i = begin; i < end; i++)
     {
         std::vector<std::string> seq_temp;
-        utils::digest(fasta.at(i), seq_temp, nMissedCleavages, minLen, maxLen, cleavagePattern);
+        utils::digest(fasta.getSequence(i, buffer), seq_temp, nMissedCleavages, minLen, maxLen, cleavagePattern);
         seqs[fasta.getIndexID(i)] = seq_temp;
     }
 }
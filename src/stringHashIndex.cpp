@@ -0,0 +1,124 @@
+//
+// stringHashIndex.cpp
+// utils
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+
+#include <stringHashIndex.hpp>
+
+size_t const utils::StringHashIndex::NOT_FOUND;
+
+//! 64 bit FNV-1a hash of \p key.
+uint64_t utils::StringHashIndex::hash(StringView key)
+{
+    uint64_t ret = 14695981039346656037ULL;
+    for(char c: key) {
+        ret ^= (unsigned char)c;
+        ret *= 1099511628211ULL;
+    }
+    return ret;
+}
+
+//! Index of the slot containing \p key or the empty slot where it would be inserted.
+size_t utils::StringHashIndex::_findSlot(StringView key, uint64_t hash) const
+{
+    size_t mask = _slots.size() - 1;
+    for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = _slots[i];
+        if(slot.value == NOT_FOUND) return i;
+        if(slot.hash == hash && StringView(_keys.data() + slot.keyOffset, slot.keyLength) == key)
+            return i;
+    }
+}
+
+void utils::StringHashIndex::_rehash(size_t capacity)
+{
+    std::vector<Slot> old;
+    old.swap(_slots);
+    _slots.resize(capacity);
+    size_t mask = capacity - 1;
+    for(const Slot& slot: old) {
+        if(slot.value == NOT_FOUND) continue;
+        size_t i = slot.hash & mask;
+        while(_slots[i].value != NOT_FOUND)
+            i = (i + 1) & mask;
+        _slots[i] = slot;
+    }
+}
+
+/**
+ \brief Add \p key to the index.
+ \param key Key to add. Its characters are copied into the index.
+ \param value Value of \p key. Must not be NOT_FOUND.
+ \return false if \p key was already in the index, in which case its value is not changed.
+ */
+bool utils::StringHashIndex::insert(StringView key, size_t value)
+{
+    if((_size + 1) * 2 > _slots.size())
+        _rehash(_slots.empty() ? 16 : _slots.size() * 2);
+
+    uint64_t h = hash(key);
+    Slot& slot = _slots[_findSlot(key, h)];
+    if(slot.value != NOT_FOUND) return false;
+    slot.hash = h;
+    slot.keyOffset = _keys.size();
+    slot.keyLength = key.size();
+    slot.value = value;
+    _keys.append(key.data(), key.size());
+    _size++;
+    return true;
+}
+
+/**
+ \brief Look up \p key.
+ \return Value of \p key or NOT_FOUND if \p key is not in the index.
+ */
+size_t utils::StringHashIndex::find(StringView key) const
+{
+    if(_size == 0) return NOT_FOUND;
+    return _slots[_findSlot(key, hash(key))].value;
+}
+
+/**
+ \brief Allocate space for \p n keys.
+ \param n Number of keys.
+ \param keyBytes Total number of characters in keys.
+ */
+void utils::StringHashIndex::reserve(size_t n, size_t keyBytes)
+{
+    size_t capacity = 16;
+    while(capacity < n * 2)
+        capacity *= 2;
+    if(capacity > _slots.size())
+        _rehash(capacity);
+    _keys.reserve(keyBytes);
+}
+
+void utils::StringHashIndex::clear()
+{
+    _keys.clear();
+    _slots.clear();
+    _size = 0;
+}
@@ -24,6 +24,9 @@
 // -----------------------------------------------------------------------------
 // 
 
+#include <clocale>
+#include <cstdint>
+#include <locale>
 #include <utility>
 #include <utils.hpp>
 
@@ -32,7 +35,9 @@
 /*******************/
 
 /**
- \brief Read contents of \p fname into \p buffer
+ \brief Read contents of \p fname into \p buffer. <br>
+
+ \p buffer is allocated with one extra byte which is set to 0 so it can be searched with the c string functions.
  \param fname path of file to read
  \param buffer location to store file contents
  \param size length of \p buffer after reading
@@ -46,7 +51,8 @@ void utils::readBuffer(const std::string& fname, char** buffer, std::streamsize&
     inF.seekg(0, inF.end);
     size = inF.tellg();
     inF.seekg(0, inF.beg);
-    *buffer = new char [size];
+    *buffer = new char [size + 1];
+    (*buffer)[size] = '\0';
     
     if(!inF.read(*buffer, size))
         throw std::runtime_error("Could not read " + fname);
@@ -649,3 +655,123 @@ void utils::getIdxOfSubstr(char* searchStr, const char* findStr,
     }
 }
 
+namespace {
+    //! Is \p c an ASCII digit? Unlike \p isdigit, safe for negative chars and independent of the locale.
+    inline bool isAsciiDigit(char c) {
+        return (unsigned)(c - '0') < 10u;
+    }
+}
+
+/**
+ \brief Parse a floating point number from the characters between \p begin and \p end. <br>
+
+ Unlike \p std::stod and \p strtod, the decimal separator is always '.' regardless of the current locale,
+ and no copy of the input is made. Numbers with up to 19 significant digits and a decimal exponent of
+ no more than 22 are converted exactly with a single floating point multiplication or division.
+ Other numbers fall back to a slower, correctly rounded conversion.
+
+ \param begin Pointer to first character to parse.
+ \param end Pointer past last character which may be parsed.
+ \param value Set to parsed value.
+ \return Pointer to the first character after the number, or \p begin if no number could be parsed.
+ */
+const char* utils::parseDouble(const char* begin, const char* end, double& value)
+{
+    static const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* it = begin;
+    bool negative = false;
+    if(it < end && (*it == '-' || *it == '+')) {
+        negative = *it == '-';
+        ++it;
+    }
+
+    uint64_t mantissa = 0;
+    int nDigits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    const char* digitsBegin = it;
+    for(; it < end && isAsciiDigit(*it); ++it) {
+        if(nDigits < 19) {
+            mantissa = mantissa * 10 + (*it - '0');
+            if(mantissa > 0) nDigits++;
+        } else {
+            exponent++;
+            if(*it != '0') truncated = true;
+        }
+    }
+    size_t nIntDigits = it - digitsBegin;
+    size_t nFracDigits = 0;
+    if(it < end && *it == '.') {
+        ++it;
+        const char* fracBegin = it;
+        for(; it < end && isAsciiDigit(*it); ++it) {
+            if(nDigits < 19) {
+                mantissa = mantissa * 10 + (*it - '0');
+                if(mantissa > 0) nDigits++;
+                exponent--;
+            } else if(*it != '0') truncated = true;
+        }
+        nFracDigits = it - fracBegin;
+    }
+    if(nIntDigits + nFracDigits == 0) return begin;
+
+    if(it < end && (*it == 'e' || *it == 'E')) {
+        const char* expBegin = it++;
+        bool expNegative = false;
+        if(it < end && (*it == '-' || *it == '+')) {
+            expNegative = *it == '-';
+            ++it;
+        }
+        if(it < end && isAsciiDigit(*it)) {
+            int e = 0;
+            for(; it < end && isAsciiDigit(*it); ++it)
+                if(e < 100000) e = e * 10 + (*it - '0');
+            exponent += expNegative ? -e : e;
+        } else it = expBegin; // 'e' is not part of the number
+    }
+
+    if(!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        auto d = (double)mantissa;
+        d = exponent < 0 ? d / powersOf10[-exponent] : d * powersOf10[exponent];
+        value = negative ? -d : d;
+        return it;
+    }
+
+    // strtod is correctly rounded but locale dependent, so only use it when the locale uses '.'
+    char buffer[128];
+    size_t len = it - begin;
+    if(len < sizeof(buffer) && *localeconv()->decimal_point == '.') {
+        memcpy(buffer, begin, len);
+        buffer[len] = '\0';
+        value = strtod(buffer, nullptr);
+    } else {
+        std::istringstream ss(std::string(begin, it));
+        ss.imbue(std::locale::classic());
+        ss >> value;
+    }
+    return it;
+}
+
+/**
+ \brief Parse a base 10 integer from the characters between \p begin and \p end.
+ \param begin Pointer to first character to parse.
+ \param end Pointer past last character which may be parsed.
+ \param value Set to parsed value.
+ \return Pointer to the first character after the number, or \p begin if no number could be parsed.
+ */
+const char* utils::parseLong(const char* begin, const char* end, long& value)
+{
+    const char* it = begin;
+    bool negative = false;
+    if(it < end && (*it == '-' || *it == '+')) {
+        negative = *it == '-';
+        ++it;
+    }
+    if(it == end || !isAsciiDigit(*it)) return begin;
+    long ret = 0;
+    for(; it < end && isAsciiDigit(*it); ++it)
+        ret = ret * 10 + (*it - '0');
+    value = negative ? -ret : ret;
+    return it;
+}
@@ -1,11 +1,17 @@
 
 #include <iostream>
 #include <vector>
+#include <cmath>
+#include <cassert>
+#include <thread>
+#include <atomic>
 
 #include <msInterface/mzXMLFile.hpp>
 #include <msInterface/mzMLFile.hpp>
 #include <msInterface/msScan.hpp>
 #include <msInterface/ms2File.hpp>
+#include <msInterface/msBinFile.hpp>
+#include <fastaFile.hpp>
 
 // int main() {
 //     std::string ifname = "/Volumes/Data/msData/ionFinder/another_another_bug/20190912_Thompson_PAD1_GlucTryp_t2.mzML";
@@ -35,11 +41,131 @@
 //     return 0;
 // }
 
+//! Compare peak values which may have been stored as 32 bit floats.
+bool peakValueEqual(double lhs, double rhs, bool isFloat) {
+    if(!isFloat) return lhs == rhs;
+    return std::abs(lhs - rhs) <= std::abs(lhs) * 1e-6;
+}
+
+/**
+ * Write \p input to a MsBinFile with every combination of array options, read it back
+ * and check that each scan is the same as in \p input.
+ */
+void msBinRoundTrip(const utils::msInterface::MsInterface& input, const std::string& ofname)
+{
+    std::vector<size_t> scans;
+    input.getScanNumbers(scans);
+#ifdef ENABLE_ZLIB
+    int nZlib = 2;
+#else
+    int nZlib = 1;
+#endif
+    for(int options = 0; options < 4 * nZlib; options++) {
+        bool floatMZ = options & 1;
+        bool floatIntensity = options & 2;
+        bool zlib = options & 4;
+        assert(utils::msInterface::MsBinFile::write(input, ofname, floatMZ, floatIntensity, zlib));
+        utils::msInterface::MsBinFile binFile(ofname);
+        assert(binFile.read());
+        assert(binFile.getScanCount() == scans.size());
+
+        utils::msInterface::Scan expected, observed;
+        for(size_t scan: scans) {
+            assert(input.getScan(scan, expected));
+            assert(binFile.getScan(scan, observed));
+            assert(observed.getScanNum() == expected.getScanNum());
+            assert(observed.getLevel() == expected.getLevel());
+            assert(observed.getPolarity() == expected.getPolarity());
+            assert(observed.isCentroided() == expected.isCentroided());
+            assert(observed.getIonInjectionTime() == expected.getIonInjectionTime());
+            assert(observed.getIMCV() == expected.getIMCV());
+            assert(observed.isIonMobilityScan() == expected.isIonMobilityScan());
+
+            const auto& expectedPrecursor = expected.getPrecursor();
+            const auto& observedPrecursor = observed.getPrecursor();
+            assert(observedPrecursor.getMZ() == expectedPrecursor.getMZ());
+            assert(observedPrecursor.getIntensity() == expectedPrecursor.getIntensity());
+            assert(observedPrecursor.getCharge() == expectedPrecursor.getCharge());
+            assert(observedPrecursor.getRT() == expectedPrecursor.getRT());
+            assert(observedPrecursor.getActivationMethod() == expectedPrecursor.getActivationMethod());
+            assert(observedPrecursor.getScan() == expectedPrecursor.getScan());
+            assert(observedPrecursor.getFile() == expectedPrecursor.getFile());
+            assert(observedPrecursor.getSample() == expectedPrecursor.getSample());
+            assert(observed.getIons().size() == expected.getIons().size());
+            for(size_t i = 0; i < expected.getIons().size(); i++) {
+                assert(peakValueEqual(expected.getIons()[i].getMZ(), observed.getIons()[i].getMZ(), floatMZ));
+                assert(peakValueEqual(expected.getIons()[i].getIntensity(), observed.getIons()[i].getIntensity(), floatIntensity));
+            }
+        }
+        std::cout << "MsBinFile round trip passed (floatMZ = " << floatMZ << ", floatIntensity = " << floatIntensity
+                  << ", zlib = " << zlib << ")\n";
+    }
+}
+
+/**
+ * Call the const lookups of \p fasta from 64 threads at once and check every result against
+ * the result from a single thread. Build with -DTEST_TSAN=ON to check for data races.
+ */
+void fastaThreadTest(const utils::FastaFile& fasta)
+{
+    struct Query {
+        size_t index;
+        std::string id;
+        std::string sequence;
+        std::string peptide;
+        std::string modifiedResidue;
+        std::string before;
+        size_t n;
+    };
+
+    // Expected results from a single thread.
+    std::vector<Query> queries;
+    std::string buffer;
+    for(size_t i = 0; i < fasta.getSequenceCount(); i += std::max((size_t)1, fasta.getSequenceCount() / 1000)) {
+        Query query;
+        query.index = i;
+        query.id = fasta.getIndexID(i);
+        query.sequence = fasta.getSequence(i, buffer).str();
+        if(query.sequence.size() < 10) continue;
+        query.peptide = query.sequence.substr(query.sequence.size() / 2, 7);
+        query.modifiedResidue = fasta.getModifiedResidue(query.id, query.peptide, 3);
+        query.before = fasta.nBefore(query.peptide, query.id, 4, true);
+        query.n = fasta.indexN(query.peptide, query.id, 2, true);
+        queries.push_back(query);
+    }
+    assert(!queries.empty());
+
+    size_t const nThread = 64;
+    std::atomic<size_t> errors(0);
+    std::vector<std::thread> threads;
+    for(size_t thread = 0; thread < nThread; thread++) {
+        threads.emplace_back([&, thread] {
+            std::string threadBuffer;
+            for(size_t i = 0; i < queries.size() * 5; i++) {
+                const Query& query = queries[(i * 7 + thread) % queries.size()];
+                bool ok = fasta.getIdIndex(query.id) == query.index &&
+                          fasta.getSequence(query.index, threadBuffer) == query.sequence &&
+                          fasta.getModifiedResidue(query.id, query.peptide, 3) == query.modifiedResidue &&
+                          fasta.nBefore(query.peptide, query.id, 4, true) == query.before &&
+                          fasta.indexN(query.peptide, query.id, 2, true) == query.n;
+                if(fasta.getStorage() != utils::FastaFile::Storage::PACKED_5BIT)
+                    ok = ok && fasta.at(query.index) == query.sequence;
+                if(!ok) errors++;
+            }
+        });
+    }
+    for(auto& thread: threads)
+        thread.join();
+    assert(errors == 0);
+    std::cout << "FastaFile thread test passed (" << nThread << " threads, " << queries.size() << " proteins)\n";
+}
+
 int main()
 {
     std::string dir = "/Volumes/Data/msData/ionFinder/another_another_bug/";
     std::string ms2_fname = dir + "20190912_Thompson_PAD2_GlucTryp_t3.ms2";
     std::string mzml_fname = dir + "20190912_Thompson_PAD2_GlucTryp_t3.mzML";
+    std::string mzxml_fname = dir + "20190912_Thompson_PAD2_GlucTryp_t3.mzXML";
 
     std::string mzmlTest = dir + "20190912_Thompson_PAD1_GlucTryp_t3.mzML";
     utils::msInterface::MzMLFile testFile(mzmlTest);
@@ -50,6 +176,17 @@ int main()
     assert(mzMlFile.read());
     assert(ms2File.read());
 
+    utils::FastaFile fasta(dir + "database.fasta");
+    assert(fasta.read());
+    fastaThreadTest(fasta);
+
+    utils::msInterface::MzXMLFile mzXmlFile(mzxml_fname);
+    assert(mzXmlFile.read());
+
+    msBinRoundTrip(mzMlFile, dir + "roundTrip.msbin");
+    msBinRoundTrip(mzXmlFile, dir + "roundTrip.msbin");
+    msBinRoundTrip(ms2File, dir + "roundTrip.msbin");
+
     std::string scanList [] = {"17602", "16730", "13003"};
 
     utils::msInterface::Scan ms2Scan, mzMLScan;